@@ -159,7 +159,7 @@ void RISCVTargetInfo::getTargetDefines(const LangOptions &Opts,
   else
     Builder.defineMacro("__riscv_float_abi_soft");
 
-  if (ABIName == "ilp32e" || ABIName == "il32pc64e")
+  if (ABIName == "ilp32e" || ABIName == "il32pc64e" || ABIName == "cheriot")
     Builder.defineMacro("__riscv_abi_rve");
 
   Builder.defineMacro("__riscv_arch_test");
@@ -434,6 +434,14 @@ static void addSymbolRewriterPass(const CodeGenOptions &Opts,
   MPM->add(createRewriteSymbolsPass(DL));
 }
 
+/// Besides collecting CSetBounds statistics, the logging pass reports the
+/// bounds that survived optimization as missed-optimization remarks.
+static bool shouldLogCheriSetBounds(const CodeGenOptions &CodeGenOpts) {
+  return cheri::ShouldCollectCSetBoundsStats ||
+         !CodeGenOpts.OptRecordFile.empty() ||
+         CodeGenOpts.OptimizationRemarkMissed.hasValidPattern();
+}
+
 static CodeGenOpt::Level getCGOptLevel(const CodeGenOptions &CodeGenOpts) {
   switch (CodeGenOpts.OptimizationLevel) {
   default:
@@ -820,7 +828,7 @@ void EmitAssemblyHelper::CreatePasses(legacy::PassManager &MPM,
     FPM.add(createVerifierPass());
 
   // FIXME: is this the right location?
-  if (cheri::ShouldCollectCSetBoundsStats) {
+  if (shouldLogCheriSetBounds(CodeGenOpts)) {
     FPM.add(createLogCheriSetBoundsPass());
   }
 
@@ -1413,7 +1421,7 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
             MPM.addPass(InstrProfiling(*Options, false));
           });
     // Run the CSetBounds logging past after all IR-level optimization have run.
-    if (cheri::ShouldCollectCSetBoundsStats) {
+    if (shouldLogCheriSetBounds(CodeGenOpts)) {
       PB.registerOptimizerLastEPCallback(
           [](ModulePassManager &MPM, PassBuilder::OptimizationLevel Level) {
             FunctionPassManager FPM;
@@ -0,0 +1,67 @@
+// REQUIRES: riscv-registered-target
+// RUN: %clang_cc1 %s -o - "-triple" "riscv32-unknown-unknown" "-S" "-mframe-pointer=none" "-mcmodel=small" "-target-cpu" "cheriot" "-target-feature" "+xcheri" "-target-feature" "-64bit" "-target-feature" "-relax" "-target-feature" "-xcheri-rvc" "-target-feature" "-save-restore" "-target-abi" "cheriot" "-Oz" "-Wno-atomic-alignment" "-cheri-compartment=example" | FileCheck %s
+
+// Without the A extension, clang emits C11 atomics as __atomic_* libcalls.
+// When interrupts are disabled nothing can run concurrently on a CHERIoT
+// core, so the backend replaces them with plain loads and stores.
+
+_Atomic(int) x;
+
+// CHECK-LABEL: fetch_add_disabled:
+// CHECK-NOT: __atomic_fetch_add_4
+// CHECK: clw
+// CHECK-NOT: __atomic_fetch_add_4
+// CHECK: csw
+// CHECK-NOT: __atomic_fetch_add_4
+// CHECK: cret
+__attribute__((cheri_interrupt_state(disabled)))
+int fetch_add_disabled(void) {
+  return __c11_atomic_fetch_add(&x, 1, __ATOMIC_SEQ_CST);
+}
+
+// CHECK-LABEL: load_store_disabled:
+// CHECK-NOT: __atomic_load_4
+// CHECK-NOT: __atomic_store_4
+// CHECK: clw
+// CHECK: csw
+// CHECK: cret
+__attribute__((cheri_interrupt_state(disabled)))
+void load_store_disabled(void) {
+  int v = __c11_atomic_load(&x, __ATOMIC_ACQUIRE);
+  __c11_atomic_store(&x, v + 2, __ATOMIC_RELEASE);
+}
+
+// CHECK-LABEL: cmpxchg_disabled:
+// CHECK-NOT: __atomic_compare_exchange_4
+// CHECK: clw
+// CHECK: csw
+// CHECK: cret
+__attribute__((cheri_interrupt_state(disabled)))
+_Bool cmpxchg_disabled(int *expected) {
+  return __c11_atomic_compare_exchange_strong(&x, expected, 42,
+                                              __ATOMIC_SEQ_CST,
+                                              __ATOMIC_SEQ_CST);
+}
+
+// An internal function that inherits its interrupt posture and is only called
+// with interrupts disabled gets the same treatment.
+// CHECK-LABEL: exchange_helper:
+// CHECK-NOT: __atomic_exchange_4
+// CHECK: cret
+__attribute__((noinline, cheri_interrupt_state(inherit)))
+static int exchange_helper(int v) {
+  return __c11_atomic_exchange(&x, v, __ATOMIC_SEQ_CST);
+}
+
+__attribute__((cheri_interrupt_state(disabled)))
+int call_helper_disabled(void) {
+  return exchange_helper(3);
+}
+
+// With interrupts enabled the libcall must stay.
+// CHECK-LABEL: fetch_add_enabled:
+// CHECK: __atomic_fetch_add_4
+__attribute__((cheri_interrupt_state(enabled)))
+int fetch_add_enabled(void) {
+  return __c11_atomic_fetch_add(&x, 1, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,82 @@
+// REQUIRES: riscv-registered-target
+// RUN: %clang_cc1 %s -o - "-triple" "riscv32-unknown-unknown" "-S" "-mframe-pointer=none" "-mcmodel=small" "-target-cpu" "cheriot" "-target-feature" "+xcheri" "-target-feature" "-64bit" "-target-feature" "-relax" "-target-feature" "-xcheri-rvc" "-target-feature" "-save-restore" "-target-abi" "cheriot" "-Oz" "-Werror" "-cheri-compartment=example" | FileCheck %s
+// RUN: %clang_cc1 %s -o - "-triple" "riscv32-unknown-unknown" "-S" "-mframe-pointer=none" "-mcmodel=small" "-target-cpu" "cheriot" "-target-feature" "+xcheri" "-target-feature" "-64bit" "-target-feature" "-relax" "-target-feature" "-xcheri-rvc" "-target-feature" "+save-restore" "-target-abi" "cheriot" "-Oz" "-Werror" "-cheri-compartment=example" | FileCheck %s --check-prefix=LIBCALL
+
+// Compartment entry points that return early should not spill anything on
+// the early-exit path.  The checks on stack-argument and sret capabilities
+// must still run first, in the entry block.
+
+int helper(int *);
+
+// CHECK-LABEL: early_exit:
+// CHECK-NOT: csc
+// CHECK: {{beqz|bnez}} a0,
+// CHECK: csc cra,
+// CHECK: {{ccall|cjal}} helper
+// CHECK: clc cra,
+// CHECK: cret
+// LIBCALL-LABEL: early_exit:
+// LIBCALL-NOT: __riscv_save
+// LIBCALL: {{beqz|bnez}} a0,
+// LIBCALL: __riscv_save_cap_{{[0-9]+}}
+// LIBCALL: {{ccall|cjal}} helper
+// LIBCALL: __riscv_restore_cap_{{[0-9]+}}
+__attribute__((cheri_compartment("example")))
+int early_exit(int *p) {
+  if (!p)
+    return -1;
+  helper(p);
+  return 0;
+}
+
+// The seventh argument is passed on the stack, through ct0.
+// CHECK-LABEL: stack_args:
+// CHECK-NOT: csc
+// CHECK: cgetaddr t1, ct0
+// CHECK-NEXT: cgetbase t2, ct0
+// CHECK-NEXT: bne t1, t2, [[FAIL:.LBB[0-9_]+]]
+// CHECK-NEXT: blt t1, sp, [[FAIL]]
+// CHECK-NEXT: cgetlen t1, ct0
+// CHECK-NOT: csc
+// CHECK: cgetperm t1, ct0
+// CHECK-NOT: csc
+// CHECK: bne t1, t2, [[FAIL]]
+// CHECK-NOT: csc
+// CHECK: {{beqz|bnez}} a0,
+// CHECK: csc cra,
+// CHECK: {{ccall|cjal}} helper
+// CHECK: cret
+__attribute__((cheri_compartment("example")))
+int stack_args(int *p, int a1, int a2, int a3, int a4, int a5, int a6) {
+  if (!p)
+    return a6;
+  helper(p);
+  return 0;
+}
+
+struct big {
+  int v[8];
+};
+
+// The sret capability is checked before it is saved across the call.
+// CHECK-LABEL: sret:
+// CHECK-NOT: csc
+// CHECK: cgetaddr t1, ca0
+// CHECK-NEXT: cgetbase t2, ca0
+// CHECK-NEXT: bne t1, t2, [[FAIL:.LBB[0-9_]+]]
+// CHECK-NEXT: blt t1, sp, [[FAIL]]
+// CHECK-NEXT: cgetlen t1, ca0
+// CHECK-NEXT: {{li t2, 32|addi t2, zero, 32}}
+// CHECK-NEXT: blt t1, t2, [[FAIL]]
+// CHECK-NOT: csc
+// CHECK: cgetperm t1, ca0
+// CHECK-NOT: csc
+// CHECK: bne t1, t2, [[FAIL]]
+// CHECK: csc cra,
+// CHECK: {{ccall|cjal}} helper
+// CHECK: cret
+__attribute__((cheri_compartment("example")))
+struct big sret(int a) {
+  helper(&a);
+  return (struct big){{a, a, a, a, a, a, a, a}};
+}
@@ -0,0 +1,24 @@
+// REQUIRES: mips-registered-target
+// Check that bounds that survive optimization are reported as remarks.
+// RUN: %cheri128_purecap_cc1 %s -mllvm -cheri-cap-table-abi=pcrel -cheri-bounds=aggressive \
+// RUN:     -O1 -debug-info-kind=standalone -Rpass=cheri -Rpass-missed=cheri \
+// RUN:     -S -o /dev/null 2>&1 | FileCheck %s
+
+struct Nested {
+  int a;
+  int b;
+};
+
+void do_stuff_with_int(int *);
+void do_stuff_with_pointer(void *);
+
+void test_subobject(struct Nested *n) {
+  do_stuff_with_int(&n->b);
+  // CHECK: csetbounds-remarks.c:[[@LINE-1]]:{{[0-9]+}}: remark: bounds set on {{.+}} pointer with size 4 (estimated cost: 1) [-Rpass-missed=cheri-log-setbounds]
+}
+
+void test_stack(void) {
+  int x = 1;
+  // CHECK: csetbounds-remarks.c:[[@LINE-1]]:{{[0-9]+}}: remark: bounds set on local variable x (stack) with size 4 for {{[0-9]+}} of {{[0-9]+}} uses (estimated cost: 1) [-Rpass-missed=cheri-bound-allocas]
+  do_stuff_with_pointer(&x);
+}
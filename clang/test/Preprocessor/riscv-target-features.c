@@ -93,6 +93,17 @@
 // CHECK-DOUBLE-NOT: __riscv_float_abi_soft
 // CHECK-DOUBLE-NOT: __riscv_float_abi_single
 
+// RUN: %clang_cc1 -triple riscv32-unknown-unknown -target-abi ilp32e -x c -E -dM %s \
+// RUN: -o - | FileCheck --check-prefix=CHECK-RVE %s
+// RUN: %clang_cc1 -triple riscv32-unknown-unknown -target-cpu cheriot \
+// RUN: -target-feature +xcheri -target-abi cheriot -x c -E -dM %s \
+// RUN: -o - | FileCheck --check-prefix=CHECK-RVE %s
+// CHECK-RVE: __riscv_abi_rve 1
+
+// RUN: %clang -target riscv32-unknown-linux-gnu -march=rv32i -mabi=ilp32 -x c -E -dM %s \
+// RUN: -o - | FileCheck --check-prefix=CHECK-NO-RVE %s
+// CHECK-NO-RVE-NOT: __riscv_abi_rve
+
 // RUN: %clang -target riscv32-unknown-linux-gnu -march=rv32ic -x c -E -dM %s \
 // RUN: -o - | FileCheck --check-prefix=CHECK-C-EXT %s
 // RUN: %clang -target riscv64-unknown-linux-gnu -march=rv64ic -x c -E -dM %s \
@@ -92,21 +92,29 @@ SymbolAndOffset::fromSectionWithOffset(InputSectionBase *isec, int64_t offset,
       return *Default;
     return {isec, offset};
   }
-  for (Symbol *b : isec->file->getSymbols()) {
-    if (auto *d = dyn_cast<Defined>(b)) {
-      if (d->section != isec)
-        continue;
-      if ((int64_t)d->value <= offset &&
-          offset <= (int64_t)d->value + (int64_t)d->size) {
-        // XXXAR: should we accept any symbol that encloses or only exact
-        // matches?
-        if ((int64_t)d->value == offset && (d->isFunc() || d->isObject()))
-          return {d, 0}; // perfect match
-        fallbackResult = d;
-        fallbackOffset = offset - d->value;
-      }
-    }
-  }
+  // Only local symbols defined in isec can match, so don't create the others
+  // if local symbols are created lazily.
+  Defined *perfectMatch = nullptr;
+  file->forEachSymbol(
+      [&](const InputSectionBase *sec, uint8_t) { return sec == isec; },
+      [&](Symbol *b) {
+        auto *d = dyn_cast<Defined>(b);
+        if (perfectMatch || !d || d->section != isec)
+          return;
+        if ((int64_t)d->value <= offset &&
+            offset <= (int64_t)d->value + (int64_t)d->size) {
+          // XXXAR: should we accept any symbol that encloses or only exact
+          // matches?
+          if ((int64_t)d->value == offset && (d->isFunc() || d->isObject())) {
+            perfectMatch = d;
+            return;
+          }
+          fallbackResult = d;
+          fallbackOffset = offset - d->value;
+        }
+      });
+  if (perfectMatch)
+    return {perfectMatch, 0};
   // When using the legacy __cap_relocs style (where clang emits __cap_relocs
   // instead of R_CHERI_CAPABILITY) the local symbols might not exist so we
   // may have fall back to the section.
@@ -579,20 +587,62 @@ void CheriCapTableSection::writeTo(uint8_t* buf) {
   relocateAlloc(buf, buf + getSize());
 }
 
-static Defined *findMatchingFunction(const InputSectionBase *isec,
-                                     uint64_t symOffset) {
-  switch (config->ekind) {
-  default:
-    llvm_unreachable("Invalid kind");
-  case ELF32LEKind:
-    return isec->getEnclosingFunction<ELF32LE>(symOffset);
-  case ELF32BEKind:
-    return isec->getEnclosingFunction<ELF32BE>(symOffset);
-  case ELF64LEKind:
-    return isec->getEnclosingFunction<ELF64LE>(symOffset);
-  case ELF64BEKind:
-    return isec->getEnclosingFunction<ELF64BE>(symOffset);
+Defined *CheriCapTableSection::findEnclosingFunction(
+    const InputSectionBase *isec, uint64_t offset) {
+  if (indexedFiles.insert(isec->file).second) {
+    // Bucket all function symbols of this file by section once instead of
+    // scanning the whole symbol list for every lookup.
+    SmallVector<const SectionBase *, 8> touched;
+    isec->file->forEachSymbol(
+        [](const InputSectionBase *, uint8_t type) { return type == STT_FUNC; },
+        [&](Symbol *b) {
+          Defined *d = dyn_cast_or_null<Defined>(b);
+          if (!d || d->file != isec->file || d->type != STT_FUNC ||
+              !d->section)
+            return;
+          auto &funcs = functionsBySection[d->section];
+          if (funcs.empty())
+            touched.push_back(d->section);
+          funcs.push_back({d, 0});
+        });
+    // Use a stable sort so that aliases keep symbol table order and we return
+    // the same symbol as InputSectionBase::getEnclosingFunction().
+    for (const SectionBase *sec : touched) {
+      auto &funcs = functionsBySection[sec];
+      llvm::stable_sort(funcs, [](const FunctionIndexEntry &a,
+                                  const FunctionIndexEntry &b) {
+        return a.sym->value < b.sym->value;
+      });
+      uint64_t maxEnd = 0;
+      for (FunctionIndexEntry &e : funcs) {
+        maxEnd = std::max(maxEnd, e.sym->value + e.sym->size);
+        e.maxEnd = maxEnd;
+      }
+    }
+  }
+  auto it = functionsBySection.find(isec);
+  if (it == functionsBySection.end())
+    return nullptr;
+  ArrayRef<FunctionIndexEntry> funcs = it->second;
+  auto groupEnd = llvm::upper_bound(
+      funcs, offset, [](uint64_t off, const FunctionIndexEntry &e) {
+        return off < e.sym->value;
+      });
+  // Walk backwards over groups of functions with the same start address until
+  // no earlier function can extend past the offset. Usually the first group
+  // matches, but zero-sized function symbols can be nested inside another one.
+  while (groupEnd != funcs.begin() && std::prev(groupEnd)->maxEnd > offset) {
+    uint64_t start = std::prev(groupEnd)->sym->value;
+    auto groupBegin = std::prev(groupEnd);
+    while (groupBegin != funcs.begin() &&
+           std::prev(groupBegin)->sym->value == start)
+      --groupBegin;
+    for (auto i = groupBegin; i != groupEnd; ++i)
+      if (offset < i->sym->value + i->sym->size)
+        return i->sym;
+    groupEnd = groupBegin;
   }
+  return nullptr;
 }
 
 CheriCapTableSection::CaptableMap &
@@ -605,7 +655,7 @@ CheriCapTableSection::getCaptableMapForFileAndOffset(
     return perFileEntries[isec->file];
   }
   if (config->capTableScope == CapTableScopePolicy::Function) {
-    Symbol *func = findMatchingFunction(isec, offset);
+    Symbol *func = findEnclosingFunction(isec, offset);
     if (!func) {
       warn(
           "Could not find corresponding function with per-function captable: " +
@@ -682,7 +732,7 @@ void CheriCapTableSection::addEntry(Symbol &sym, RelExpr expr,
   if (Config->CapTableScope == CapTableScopePolicy::File) {
     DbgContext = " for file '" + toString(IS->File) + "'";
   } else if (Config->CapTableScope == CapTableScopePolicy::Function) {
-    DbgContext =  " for function '" + toString(*findMatchingFunction(IS, Offset)) + "'";
+    DbgContext =  " for function '" + toString(*findEnclosingFunction(IS, Offset)) + "'";
   }
   llvm::errs() << "Added symbol " << toString(Sym) << " to .captable"
                << DbgContext << ". Total count " << Entries.size() << "\n";
@@ -746,6 +796,18 @@ uint32_t CheriCapTableSection::getTlsOffset(const Symbol &sym) const {
   return it->second.index.getValue() * config->wordsize;
 }
 
+std::vector<std::pair<Symbol *, uint64_t>>
+CheriCapTableSection::getGlobalEntryOffsets() const {
+  assert(valuesAssigned && "getGlobalEntryOffsets called before assignment");
+  std::vector<std::pair<Symbol *, uint64_t>> ret;
+  ret.reserve(globalEntries.size());
+  for (const auto &it : globalEntries.map)
+    ret.emplace_back(it.first,
+                     (it.second.index.getValue() - globalEntries.firstIndex) *
+                         config->capabilitySize);
+  return ret;
+}
+
 template <class ELFT>
 uint64_t CheriCapTableSection::assignIndices(uint64_t startIndex,
                                              CaptableMap &entries,
@@ -978,17 +1040,19 @@ size_t CheriCapTableMappingSection::getSize() const {
   assert(config->capTableScope != CapTableScopePolicy::All);
   if (!isNeeded())
     return 0;
-  size_t count = 0;
   if (!in.symTab) {
     error("Cannot use " + this->name + " without .symtab section!");
     return 0;
   }
-  for (const SymbolTableEntry &ste : in.symTab->getSymbols()) {
+  ArrayRef<SymbolTableEntry> symbols = in.symTab->getSymbols();
+  assert(numScannedSymbols <= symbols.size());
+  for (const SymbolTableEntry &ste : symbols.drop_front(numScannedSymbols)) {
     if (!ste.sym->isDefined() || !ste.sym->isFunc())
       continue;
-    count++;
+    numFunctions++;
   }
-  return count * sizeof(CaptableMappingEntry);
+  numScannedSymbols = symbols.size();
+  return numFunctions * sizeof(CaptableMappingEntry);
 }
 
 void CheriCapTableMappingSection::writeTo(uint8_t *buf) {
@@ -1002,6 +1066,7 @@ void CheriCapTableMappingSection::writeTo(uint8_t *buf) {
 
   // Write the mapping from function vaddr -> captable subset for RTLD
   std::vector<CaptableMappingEntry> entries;
+  entries.reserve(numFunctions);
   // Note: Symtab->getSymbols() only returns the symbols in .dynsym. We need
   // to use In.sym()tab instead since we also want to add all local functions!
   for (const SymbolTableEntry &ste : in.symTab->getSymbols()) {
@@ -1043,17 +1108,16 @@ void CheriCapTableMappingSection::writeTo(uint8_t *buf) {
       return e1.funcEnd < e2.funcEnd;
     return e1.funcStart < e2.funcStart;
   });
-  // Byte-swap all the values so that we can memcpy the sorted buffer
-  for (CaptableMappingEntry &e : entries) {
-    e.funcStart = support::endian::byte_swap(e.funcStart, config->endianness);
-    e.funcEnd = support::endian::byte_swap(e.funcEnd, config->endianness);
-    e.capTableOffset =
-        support::endian::byte_swap(e.capTableOffset, config->endianness);
-    e.subTableSize =
-        support::endian::byte_swap(e.subTableSize, config->endianness);
-  }
   assert(entries.size() * sizeof(CaptableMappingEntry) == getSize());
-  memcpy(buf, entries.data(), entries.size() * sizeof(CaptableMappingEntry));
+  // Write the sorted entries in target endianess directly to the output buffer
+  // instead of byte-swapping a copy first.
+  for (const CaptableMappingEntry &e : entries) {
+    write64(buf, e.funcStart);
+    write64(buf + 8, e.funcEnd);
+    write32(buf + 16, e.capTableOffset);
+    write32(buf + 20, e.subTableSize);
+    buf += sizeof(CaptableMappingEntry);
+  }
 }
 
 template <typename ELFT>
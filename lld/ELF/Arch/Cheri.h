@@ -9,6 +9,7 @@
 #include "lld/Common/ErrorHandler.h"
 #include "lld/Common/Memory.h"
 #include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/Endian.h"
 
 namespace lld {
@@ -86,6 +87,13 @@ public:
   void addCapReloc(CheriCapRelocLocation loc, const SymbolAndOffset &target,
                    bool targetNeedsDynReloc, int64_t capabilityOffset,
                    Symbol *sourceSymbol = nullptr);
+  // If this is true reduce number of warnings for compat
+  bool containsLegacyCapRelocs() const { return !legacyInputs.empty(); }
+  // Calls fn with the target of every capability relocation.
+  template <typename Fn> void forEachTarget(Fn fn) const {
+    for (const auto &it : relocsMap)
+      fn(it.second.target);
+  }
 
 private:
   void processSection(InputSectionBase *s);
@@ -111,8 +119,6 @@ private:
   // If we have dynamic relocations we can't sort the __cap_relocs section
   // before writing it. TODO: actually we can but it will require refactoring
   bool containsDynamicRelocations = false;
-  // If this is true reduce number of warnings for compat
-  bool containsLegacyCapRelocs() const { return !legacyInputs.empty(); }
 };
 
 // General cap table structure (for CapSize = 2*WordSize):
@@ -201,6 +207,9 @@ public:
   uint32_t getDynTlsOffset(const Symbol &sym) const;
   uint32_t getTlsIndexOffset() const;
   uint32_t getTlsOffset(const Symbol &sym) const;
+  // Returns the byte offset of every entry in the global table. The
+  // per-file/per-function tables are not included.
+  std::vector<std::pair<Symbol *, uint64_t>> getGlobalEntryOffsets() const;
   bool isNeeded() const override {
     return nonTlsEntryCount() != 0 || !dynTlsEntries.empty() ||
            !tlsEntries.empty();
@@ -245,6 +254,13 @@ private:
   /// return a reference to the file/function that matches InputFile+Offset
   CaptableMap &getCaptableMapForFileAndOffset(const InputSectionBase *isec,
                                               uint64_t offset);
+  /// @return the STT_FUNC symbol defined in IS that contains Offset or null.
+  /// This is a binary search in a per-section index of function symbols that
+  /// is built the first time a section of a given file is queried, so the
+  /// per-function captable mode no longer scans every symbol of the file for
+  /// each captable relocation.
+  Defined *findEnclosingFunction(const InputSectionBase *isec,
+                                 uint64_t offset);
   size_t nonTlsEntryCount() const {
     size_t totalCount = globalEntries.size();
     if (LLVM_LIKELY(config->capTableScope == CapTableScopePolicy::All)) {
@@ -265,6 +281,16 @@ private:
   CaptableMap globalEntries;
   CaptableMap dynTlsEntries;
   CaptableMap tlsEntries;
+  // Function symbols sorted by start offset for each input section (only
+  // populated for the per-function captable mode). maxEnd is the largest end
+  // offset of this and all preceding entries and bounds the backwards search.
+  struct FunctionIndexEntry {
+    Defined *sym;
+    uint64_t maxEnd;
+  };
+  llvm::DenseMap<const SectionBase *, SmallVector<FunctionIndexEntry, 0>>
+      functionsBySection;
+  llvm::DenseSet<const InputFile *> indexedFiles;
   bool valuesAssigned = false;
   friend class CheriCapTableMappingSection;
 };
@@ -279,7 +305,8 @@ struct CaptableMappingEntry {
 };
 
 // Map from symbol vaddr -> captable subset so that RTLD can setup the correct
-// trampolines to initialize $cgp to the correct subset
+// trampolines to initialize $cgp to the correct subset. The entries are sorted
+// by (funcStart, funcEnd) so that RTLD can binary-search the table directly.
 class CheriCapTableMappingSection : public SyntheticSection {
 public:
   CheriCapTableMappingSection();
@@ -290,6 +317,13 @@ public:
   }
   void writeTo(uint8_t *buf) override;
   size_t getSize() const override;
+
+private:
+  // getSize() is called repeatedly while assigning addresses. Symbols are only
+  // ever appended to (or reordered within) .symtab, so we only need to look at
+  // the ones that were added since the last call.
+  mutable size_t numScannedSymbols = 0;
+  mutable size_t numFunctions = 0;
 };
 
 inline bool isSectionEndSymbol(StringRef name) {
@@ -676,19 +676,29 @@ static void initSymbolAnchors() {
     }
   }
   // Store anchors (st_value and st_value+st_size) for symbols relative to text
-  // sections.
+  // sections. Local symbols that have not been created by now are neither
+  // relocation targets nor copied to the output (see
+  // ObjFile::initializeSymbols()), but -Map and diagnostics may still create
+  // them later, from the unrelaxed st_value and st_size. Create the ones in
+  // relaxed sections now so that they are adjusted too. Locals in other
+  // sections do not move and stay lazy.
   for (InputFile *file : objectFiles)
-    for (Symbol *sym : file->getSymbols()) {
-      auto *d = dyn_cast<Defined>(sym);
-      if (!d || d->file != file)
-        continue;
-      if (auto *sec = dyn_cast_or_null<InputSection>(d->section))
-        if (sec->flags & SHF_EXECINSTR && sec->relaxAux) {
-          // If sec is discarded, relaxAux will be nullptr.
-          sec->relaxAux->anchors.push_back({d->value, d, false});
-          sec->relaxAux->anchors.push_back({d->value + d->size, d, true});
-        }
-    }
+    file->forEachSymbol(
+        [](const InputSectionBase *sec, uint8_t) {
+          auto *isec = dyn_cast_or_null<InputSection>(sec);
+          return isec && (isec->flags & SHF_EXECINSTR) && isec->relaxAux;
+        },
+        [&](Symbol *sym) {
+          auto *d = dyn_cast<Defined>(sym);
+          if (!d || d->file != file)
+            return;
+          if (auto *sec = dyn_cast_or_null<InputSection>(d->section))
+            if (sec->flags & SHF_EXECINSTR && sec->relaxAux) {
+              // If sec is discarded, relaxAux will be nullptr.
+              sec->relaxAux->anchors.push_back({d->value, d, false});
+              sec->relaxAux->anchors.push_back({d->value + d->size, d, true});
+            }
+        });
   // Sort anchors by offset so that we can find the closest relocation
   // efficiently. For a zero size symbol, ensure that its start anchor precedes
   // its end anchor. For two symbols with anchors at the same offset, their
@@ -38,6 +38,14 @@
 ///   * If not, then combine the clusters.
 /// * Sort non-empty clusters by density
 ///
+/// CHERIoT compartments and libraries must keep their code contiguous under
+/// their own PCC bounds. Sections of different compartments are never
+/// clustered together. A call into another compartment goes through the
+/// switcher, so it only adds to the weight of the callee, which makes hot
+/// entry points sort first within their compartment. Compartments are laid out
+/// in order of cross-compartment call frequency, with compartments that call
+/// each other placed next to each other.
+///
 //===----------------------------------------------------------------------===//
 
 #include "CallGraphSort.h"
@@ -58,7 +66,8 @@ struct Edge {
 };
 
 struct Cluster {
-  Cluster(int sec, size_t s) : next(sec), prev(sec), size(s) {}
+  Cluster(int sec, size_t s, const InputFile *compartment)
+      : next(sec), prev(sec), size(s), compartment(compartment) {}
 
   double getDensity() const {
     if (size == 0)
@@ -72,6 +81,7 @@ struct Cluster {
   uint64_t weight = 0;
   uint64_t initialWeight = 0;
   Edge bestPred = {-1, 0};
+  const InputFile *compartment;
 };
 
 class CallGraphSort {
@@ -81,8 +91,16 @@ public:
   DenseMap<const InputSectionBase *, int> run();
 
 private:
+  const InputFile *getCompartment(const InputSectionBase *isec);
+  DenseMap<const InputFile *, unsigned> orderCompartments();
+
   std::vector<Cluster> clusters;
   std::vector<const InputSectionBase *> sections;
+  DenseMap<const InputFile *, bool> isCompartment;
+  // Weights of calls between two compartments, keyed on the pair of
+  // compartments ordered by address.
+  DenseMap<std::pair<const InputFile *, const InputFile *>, uint64_t>
+      compartmentCalls;
 };
 
 // Maximum amount the combined cluster density can be worse than the original
@@ -96,6 +114,25 @@ constexpr uint64_t MAX_CLUSTER_SIZE = 1024 * 1024;
 using SectionPair =
     std::pair<const InputSectionBase *, const InputSectionBase *>;
 
+// Each CHERIoT compartment or library is linked into a single relocatable
+// object (see --compartment) that carries its import and export tables.
+// Returns that object for sections of a compartment, or nullptr.
+const InputFile *CallGraphSort::getCompartment(const InputSectionBase *isec) {
+  InputFile *file = isec->file;
+  if (!file)
+    return nullptr;
+  auto res = isCompartment.try_emplace(file, false);
+  if (res.second)
+    for (InputSectionBase *sec : file->getSections())
+      if (sec && (sec->name.startswith(".compartment_exports") ||
+                  sec->name.startswith(".compartment_imports") ||
+                  sec->name == ".compartment_import_table")) {
+        res.first->second = true;
+        break;
+      }
+  return res.first->second ? file : nullptr;
+}
+
 // Take the edge list in Config->CallGraphProfile, resolve symbol names to
 // Symbols, and generate a graph between InputSections with the provided
 // weights.
@@ -107,7 +144,8 @@ CallGraphSort::CallGraphSort() {
     auto res = secToCluster.try_emplace(isec, clusters.size());
     if (res.second) {
       sections.push_back(isec);
-      clusters.emplace_back(clusters.size(), isec->getSize());
+      clusters.emplace_back(clusters.size(), isec->getSize(),
+                            getCompartment(isec));
     }
     return res.first->second;
   };
@@ -118,6 +156,16 @@ CallGraphSort::CallGraphSort() {
     const auto *toSB = cast<InputSectionBase>(c.first.second->repl);
     uint64_t weight = c.second;
 
+    // Never cluster the code of two compartments together. The call still
+    // makes the callee hot, and pulls the two compartments closer together.
+    const InputFile *fromComp = getCompartment(fromSB);
+    const InputFile *toComp = getCompartment(toSB);
+    if (fromComp != toComp) {
+      compartmentCalls[std::minmax(fromComp, toComp)] += weight;
+      clusters[getOrCreateNode(toSB)].weight += weight;
+      continue;
+    }
+
     // Ignore edges between input sections belonging to different output
     // sections.  This is done because otherwise we would end up with clusters
     // containing input sections that can't actually be placed adjacently in the
@@ -176,6 +224,46 @@ static void mergeClusters(std::vector<Cluster> &cs, Cluster &into, int intoIdx,
   from.weight = 0;
 }
 
+// Returns the position of each compartment in the output. Starting with the
+// compartment with the most cross-compartment calls, each next compartment is
+// the one that is called most by (or calls most into) the previous one.
+DenseMap<const InputFile *, unsigned> CallGraphSort::orderCompartments() {
+  DenseMap<const InputFile *, unsigned> order;
+  if (compartmentCalls.empty())
+    return order;
+
+  MapVector<const InputFile *, uint64_t> totals;
+  for (const Cluster &c : clusters)
+    totals.insert({c.compartment, 0});
+  for (const auto &it : compartmentCalls) {
+    totals[it.first.first] += it.second;
+    totals[it.first.second] += it.second;
+  }
+
+  std::vector<const InputFile *> unplaced;
+  for (const auto &it : totals)
+    unplaced.push_back(it.first);
+  const InputFile *last = nullptr;
+  while (!unplaced.empty()) {
+    auto best = unplaced.begin();
+    uint64_t bestCalls = 0;
+    for (auto it = unplaced.begin(), e = unplaced.end(); it != e; ++it) {
+      uint64_t calls =
+          order.empty() ? 0 : compartmentCalls.lookup(std::minmax(last, *it));
+      if (calls > bestCalls ||
+          (calls == bestCalls && totals[*it] > totals[*best])) {
+        best = it;
+        bestCalls = calls;
+      }
+    }
+    last = *best;
+    unsigned pos = order.size();
+    order[last] = pos;
+    unplaced.erase(best);
+  }
+  return order;
+}
+
 // Group InputSections into clusters using the Call-Chain Clustering heuristic
 // then sort the clusters by density.
 DenseMap<const InputSectionBase *, int> CallGraphSort::run() {
@@ -212,12 +300,17 @@ DenseMap<const InputSectionBase *, int> CallGraphSort::run() {
     mergeClusters(clusters, *predC, predL, c, l);
   }
 
-  // Sort remaining non-empty clusters by density.
+  // Sort remaining non-empty clusters by compartment, then by density.
+  DenseMap<const InputFile *, unsigned> compartmentOrder = orderCompartments();
   sorted.clear();
   for (int i = 0, e = (int)clusters.size(); i != e; ++i)
     if (clusters[i].size > 0)
       sorted.push_back(i);
   llvm::stable_sort(sorted, [&](int a, int b) {
+    unsigned orderA = compartmentOrder.lookup(clusters[a].compartment);
+    unsigned orderB = compartmentOrder.lookup(clusters[b].compartment);
+    if (orderA != orderB)
+      return orderA < orderB;
     return clusters[a].getDensity() > clusters[b].getDensity();
   });
 
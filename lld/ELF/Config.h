@@ -47,6 +47,9 @@ enum class CapRelocsMode { Legacy, ElfReloc, CBuildCap };
 
 enum class CapTableScopePolicy { All, File, Function };
 
+// For --compress-debug-sections.
+enum class DebugCompressionKind { None, Zlib, Zstd };
+
 // For --discard-{all,locals,none}.
 enum class DiscardPolicy { Default, All, Locals, None };
 
@@ -160,7 +163,7 @@ struct Configuration {
   bool callGraphProfileSort;
   bool checkSections;
   bool checkDynamicRelocs;
-  bool compressDebugSections;
+  DebugCompressionKind compressDebugSections;
   bool cref;
   std::vector<std::pair<llvm::GlobPattern, uint64_t>> deadRelocInNonAlloc;
   bool defineCommon;
@@ -184,6 +187,7 @@ struct Configuration {
   bool hasDynSymTab;
   bool ignoreDataAddressEquality;
   bool ignoreFunctionAddressEquality;
+  bool incremental;
   bool ltoCSProfileGenerate;
   bool ltoDebugPassManager;
   bool ltoEmitAsm;
@@ -216,6 +220,7 @@ struct Configuration {
   std::vector<std::pair<llvm::GlobPattern, uint32_t>> shuffleSections;
   bool sortCapRelocs;
   bool singleRoRx;
+  bool streamOutput;
   bool shared;
   bool symbolic;
   bool isStatic = false;
@@ -26,6 +26,7 @@
 #include "Arch/Cheri.h"
 #include "Config.h"
 #include "ICF.h"
+#include "Incremental.h"
 #include "InputFiles.h"
 #include "InputSection.h"
 #include "LinkerScript.h"
@@ -368,6 +369,14 @@ static void checkOptions() {
     if (config->exportDynamic)
       error("-r and --export-dynamic may not be used together");
   }
+  if (config->incremental) {
+    if (config->relocatable)
+      error("-r and --incremental may not be used together");
+    if (config->shared || config->pie)
+      error("--incremental is only supported for static executables");
+    if (config->emitRelocs)
+      error("--emit-relocs and --incremental may not be used together");
+  }
   if (config->localCapRelocsMode == CapRelocsMode::ElfReloc)
     error("local-cap-relocs=elf is not implemented yet");
   if (config->localCapRelocsMode == CapRelocsMode::CBuildCap)
@@ -968,9 +977,43 @@ processCallGraphRelocations(SmallVector<uint32_t, 32> &symbolIndices,
   return !symbolIndices.empty();
 }
 
+// A CHERIoT compartment only exports its entry points through its export
+// table; the functions themselves are local to the compartment, so a call into
+// another compartment refers to an undefined symbol. Returns a map from the
+// name of each exported function to its definition. Names that are exported
+// by more than one compartment map to nullptr.
+template <class ELFT> static StringMap<Defined *> getCompartmentEntryPoints() {
+  StringMap<Defined *> entryPoints;
+  for (InputFile *file : objectFiles) {
+    auto *obj = cast<ObjFile<ELFT>>(file);
+    auto addEntryPoint = [&](Symbol &sym) {
+      auto *d = dyn_cast<Defined>(&sym);
+      if (!d || d->type != STT_FUNC)
+        return;
+      auto res = entryPoints.try_emplace(d->getName(), d);
+      if (!res.second && res.first->second != d)
+        res.first->second = nullptr;
+    };
+    for (InputSectionBase *sec : obj->getSections()) {
+      if (!sec || sec == &InputSection::discarded ||
+          !sec->name.startswith(".compartment_exports"))
+        continue;
+      if (sec->areRelocsRela) {
+        for (const typename ELFT::Rela &rel : sec->template relas<ELFT>())
+          addEntryPoint(obj->getRelocTargetSym(rel));
+      } else {
+        for (const typename ELFT::Rel &rel : sec->template rels<ELFT>())
+          addEntryPoint(obj->getRelocTargetSym(rel));
+      }
+    }
+  }
+  return entryPoints;
+}
+
 template <class ELFT> static void readCallGraphsFromObjectFiles() {
   SmallVector<uint32_t, 32> symbolIndices;
   ArrayRef<typename ELFT::CGProfile> cgProfile;
+  Optional<StringMap<Defined *>> entryPoints;
   for (auto file : objectFiles) {
     auto *obj = cast<ObjFile<ELFT>>(file);
     if (!processCallGraphRelocations(symbolIndices, cgProfile, obj))
@@ -985,6 +1028,12 @@ template <class ELFT> static void readCallGraphsFromObjectFiles() {
       uint32_t toIndex = symbolIndices[i * 2 + 1];
       auto *fromSym = dyn_cast<Defined>(&obj->getSymbol(fromIndex));
       auto *toSym = dyn_cast<Defined>(&obj->getSymbol(toIndex));
+      if (fromSym && !toSym && config->isCheriAbi &&
+          obj->getSymbol(toIndex).isUndefined()) {
+        if (!entryPoints)
+          entryPoints = getCompartmentEntryPoints<ELFT>();
+        toSym = entryPoints->lookup(obj->getSymbol(toIndex).getName());
+      }
       if (!fromSym || !toSym)
         continue;
 
@@ -996,15 +1045,22 @@ template <class ELFT> static void readCallGraphsFromObjectFiles() {
   }
 }
 
-static bool getCompressDebugSections(opt::InputArgList &args) {
+static DebugCompressionKind getCompressDebugSections(opt::InputArgList &args) {
   StringRef s = args.getLastArgValue(OPT_compress_debug_sections, "none");
   if (s == "none")
-    return false;
-  if (s != "zlib")
-    error("unknown --compress-debug-sections value: " + s);
-  if (!zlib::isAvailable())
-    error("--compress-debug-sections: zlib is not available");
-  return true;
+    return DebugCompressionKind::None;
+  if (s == "zlib") {
+    if (!zlib::isAvailable())
+      error("--compress-debug-sections: zlib is not available");
+    return DebugCompressionKind::Zlib;
+  }
+  if (s == "zstd") {
+    if (!zstd::isAvailable())
+      error("--compress-debug-sections: zstd is not available");
+    return DebugCompressionKind::Zstd;
+  }
+  error("unknown --compress-debug-sections value: " + s);
+  return DebugCompressionKind::None;
 }
 
 static StringRef getAliasSpelling(opt::Arg *arg) {
@@ -1135,6 +1191,8 @@ static void readConfigs(opt::InputArgList &args) {
       args.hasArg(OPT_ignore_data_address_equality);
   config->ignoreFunctionAddressEquality =
       args.hasArg(OPT_ignore_function_address_equality);
+  config->incremental =
+      args.hasFlag(OPT_incremental, OPT_no_incremental, false);
   config->init = args.getLastArgValue(OPT_init, "_init");
   config->localCapRelocsMode = getLocalCapRelocsMode(args);
   config->ltoAAPipeline = args.getLastArgValue(OPT_lto_aa_pipeline);
@@ -1215,6 +1273,8 @@ static void readConfigs(opt::InputArgList &args) {
       args.hasFlag(OPT_sort_cap_relocs, OPT_no_sort_cap_relocs, true);
   config->sortSection = getSortSection(args);
   config->splitStackAdjustSize = args::getInteger(args, OPT_split_stack_adjust_size, 16384);
+  config->streamOutput =
+      args.hasFlag(OPT_stream_output, OPT_no_stream_output, false);
   config->strip = getStrip(args);
   config->sysroot = args.getLastArgValue(OPT_sysroot);
   config->target1Rel = args.hasFlag(OPT_target1_rel, OPT_target1_abs, false);
@@ -2280,6 +2340,14 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   if (config->entry.empty() && !config->relocatable)
     config->entry = (config->emachine == EM_MIPS) ? "__start" : "_start";
 
+  // With --incremental, try to patch the previous output before doing any
+  // real work.
+  if (config->incremental && tryIncrementalLink<ELFT>(args, files)) {
+    if (!config->dependencyFile.empty())
+      writeDependencyFile();
+    return;
+  }
+
   // Handle --trace-symbol.
   for (auto *arg : args.filtered(OPT_trace_symbol))
     symtab->insert(arg->getValue())->traced = true;
@@ -2295,6 +2363,7 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   // appended to the Files vector.
   {
     llvm::TimeTraceScope timeScope("Parse input files");
+    prehashSymbolNames(files);
     for (size_t i = 0; i < files.size(); ++i) {
       auto fileName = files[i]->getName();
       llvm::TimeTraceScope timeScope("Parse input files", fileName);
@@ -2531,6 +2600,11 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   markLive<ELFT>();
   demoteSharedSymbols();
 
+  // ICF, --gdb-index and relocation processing look up relocation targets in
+  // parallel. Create the local symbols they need while we are single-threaded.
+  for (InputFile *file : objectFiles)
+    cast<ObjFile<ELFT>>(file)->initializeRelocTargetSymbols();
+
   // Make copies of any input sections that need to be copied into each
   // partition.
   copySectionsIntoPartitions();
@@ -2595,5 +2669,7 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
 
   // Write the result to the file.
   writeResult<ELFT>();
+  if (config->incremental)
+    writeIncrementalState<ELFT>(args);
 
 }
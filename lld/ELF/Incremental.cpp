@@ -0,0 +1,1255 @@
+//===- Incremental.cpp ----------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements --incremental.
+//
+// A full link with --incremental leaves some free space after each allocated
+// input section and saves the layout of the output to <output>.incr: the
+// address and file offset of every output section, the slot of every input
+// section of every object file given on the command line, the address of
+// every global symbol and the position of the symbols in .symtab.
+//
+// The next link with the same command line compares the inputs against the
+// saved state. If only object files changed, and every section that changed
+// still fits into its slot and refers only to symbols whose addresses are
+// known, the changed sections are relocated against the saved addresses and
+// written over the previous output. Everything else falls back to a full link,
+// which writes a new state file. In particular, the following force a full
+// link:
+//
+//  - a changed archive, shared library, linker script or command line;
+//  - a changed section that is not allocated (e.g. debug info), a mergeable or
+//    .eh_frame section, or a section that grew beyond its slot;
+//  - a global symbol that moved, or a symbol whose address or size is baked
+//    into a capability;
+//  - relocations that need a GOT, a PLT, TLS or a new capability.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Incremental.h"
+#include "Arch/Cheri.h"
+#include "Config.h"
+#include "InputFiles.h"
+#include "InputSection.h"
+#include "OutputSections.h"
+#include "SymbolTable.h"
+#include "Symbols.h"
+#include "SyntheticSections.h"
+#include "Target.h"
+#include "Writer.h"
+#include "lld/Common/DWARF.h"
+#include "lld/Common/ErrorHandler.h"
+#include "lld/Common/Memory.h"
+#include "lld/Common/Version.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Option/ArgList.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace llvm;
+using namespace llvm::ELF;
+using namespace llvm::object;
+using namespace lld;
+using namespace lld::elf;
+
+// Bump this whenever the format of the state file changes.
+static const int64_t stateVersion = 1;
+
+// Input sections grow by up to an eighth of their size before a full link is
+// needed.
+static const uint64_t slackDivisor = 8;
+
+uint64_t elf::getIncrementalSlack(const InputSection *s) {
+  if (!config->incremental || !s->file || isa<SyntheticSection>(s))
+    return 0;
+  if (!(s->flags & SHF_ALLOC) || (s->flags & SHF_TLS) || s->type == SHT_NOBITS)
+    return 0;
+  return divideCeil(s->getSize(), slackDivisor);
+}
+
+// Returns the index of the first global symbol in the symbol table of obj.
+template <class ELFT> static size_t getFirstGlobal(ObjFile<ELFT> *obj) {
+  return obj->getSymbols().size() - obj->getGlobalSymbols().size();
+}
+
+namespace {
+enum SectionKind : int64_t {
+  // The section has no InputSection, e.g. a symbol or relocation table.
+  NoSection,
+  // A COMDAT group member that lost to another file, or a section that is
+  // dropped by design (.note.GNU-stack etc.).
+  Discarded,
+  // Garbage collected or discarded by the linker script.
+  Dead,
+  // A regular input section with a slot in an output section.
+  Placed,
+  // A mergeable section. Only the addresses of its pieces are saved.
+  Merge,
+  // Anything else (.eh_frame, ...). It cannot be patched.
+  Other,
+};
+
+struct InputState {
+  std::string path;
+  int64_t hash = 0;
+};
+
+struct OutputSectionState {
+  std::string name;
+  int64_t type = 0;
+  int64_t flags = 0;
+  int64_t addr = 0;
+  int64_t offset = 0;
+  int64_t size = 0;
+  int64_t filler = 0;
+};
+
+// A symbol of the global symbol table.
+struct SymbolState {
+  std::string name;
+  // The file that defines the symbol, empty if it is linker-defined.
+  std::string file;
+  int64_t type = 0;
+  int64_t va = 0;
+  int64_t size = 0;
+  // The output section the symbol is in, or -1 if it is absolute.
+  int64_t osec = -1;
+  // The file offset of the .symtab entry, or -1.
+  int64_t symtab = -1;
+  // The address of the entry in the capability table, or -1.
+  int64_t capSlot = -1;
+  // The address and size of the symbol are baked into a capability.
+  bool pinned = false;
+};
+
+struct SectionState {
+  std::string name;
+  int64_t kind = NoSection;
+  int64_t hash = 0;
+  int64_t osec = -1;
+  int64_t outSecOff = 0;
+  int64_t slot = 0;
+  int64_t alignment = 0;
+  // Pairs of (input offset, address) for the live pieces of a mergeable
+  // section.
+  std::vector<int64_t> pieces;
+};
+
+// A symbol of an object file, in the order of its symbol table. Only the name
+// is saved for global symbols; they are described by SymbolState.
+struct FileSymbolState {
+  std::string name;
+  bool global = false;
+  int64_t va = 0;
+  int64_t size = 0;
+  int64_t symtab = -1;
+  int64_t capSlot = -1;
+  bool pinned = false;
+};
+
+struct FileState {
+  std::string path;
+  std::vector<SectionState> sections;
+  std::vector<FileSymbolState> symbols;
+};
+
+struct LinkState {
+  int64_t version = 0;
+  std::string lldVersion;
+  int64_t args = 0;
+  int64_t outputSize = 0;
+  int64_t outputTime = 0;
+  // The file offset of the --build-id hash, or -1.
+  int64_t buildIdOffset = -1;
+  int64_t buildIdSize = 0;
+  bool isCheriAbi = false;
+  int64_t capabilitySize = 0;
+  std::vector<InputState> inputs;
+  std::vector<OutputSectionState> outputSections;
+  std::vector<SymbolState> symbols;
+  std::vector<FileState> files;
+};
+
+json::Value toJSON(const InputState &s) {
+  return json::Object{{"path", s.path}, {"hash", s.hash}};
+}
+
+bool fromJSON(const json::Value &v, InputState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("path", s.path) && o.map("hash", s.hash);
+}
+
+json::Value toJSON(const OutputSectionState &s) {
+  return json::Object{{"name", s.name},     {"type", s.type},
+                      {"flags", s.flags},   {"addr", s.addr},
+                      {"offset", s.offset}, {"size", s.size},
+                      {"filler", s.filler}};
+}
+
+bool fromJSON(const json::Value &v, OutputSectionState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("name", s.name) && o.map("type", s.type) &&
+         o.map("flags", s.flags) && o.map("addr", s.addr) &&
+         o.map("offset", s.offset) && o.map("size", s.size) &&
+         o.map("filler", s.filler);
+}
+
+json::Value toJSON(const SymbolState &s) {
+  return json::Object{{"name", s.name},       {"file", s.file},
+                      {"type", s.type},       {"va", s.va},
+                      {"size", s.size},       {"osec", s.osec},
+                      {"symtab", s.symtab},   {"capSlot", s.capSlot},
+                      {"pinned", s.pinned}};
+}
+
+bool fromJSON(const json::Value &v, SymbolState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("name", s.name) && o.map("file", s.file) &&
+         o.map("type", s.type) && o.map("va", s.va) && o.map("size", s.size) &&
+         o.map("osec", s.osec) && o.map("symtab", s.symtab) &&
+         o.map("capSlot", s.capSlot) && o.map("pinned", s.pinned);
+}
+
+json::Value toJSON(const SectionState &s) {
+  return json::Object{{"name", s.name},           {"kind", s.kind},
+                      {"hash", s.hash},           {"osec", s.osec},
+                      {"outSecOff", s.outSecOff}, {"slot", s.slot},
+                      {"alignment", s.alignment}, {"pieces", s.pieces}};
+}
+
+bool fromJSON(const json::Value &v, SectionState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("name", s.name) && o.map("kind", s.kind) &&
+         o.map("hash", s.hash) && o.map("osec", s.osec) &&
+         o.map("outSecOff", s.outSecOff) && o.map("slot", s.slot) &&
+         o.map("alignment", s.alignment) && o.map("pieces", s.pieces);
+}
+
+json::Value toJSON(const FileSymbolState &s) {
+  return json::Object{{"name", s.name},     {"global", s.global},
+                      {"va", s.va},         {"size", s.size},
+                      {"symtab", s.symtab}, {"capSlot", s.capSlot},
+                      {"pinned", s.pinned}};
+}
+
+bool fromJSON(const json::Value &v, FileSymbolState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("name", s.name) && o.map("global", s.global) &&
+         o.map("va", s.va) && o.map("size", s.size) &&
+         o.map("symtab", s.symtab) && o.map("capSlot", s.capSlot) &&
+         o.map("pinned", s.pinned);
+}
+
+json::Value toJSON(const FileState &s) {
+  return json::Object{{"path", s.path},
+                      {"sections", s.sections},
+                      {"symbols", s.symbols}};
+}
+
+bool fromJSON(const json::Value &v, FileState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("path", s.path) && o.map("sections", s.sections) &&
+         o.map("symbols", s.symbols);
+}
+
+json::Value toJSON(const LinkState &s) {
+  return json::Object{{"version", s.version},
+                      {"lldVersion", s.lldVersion},
+                      {"args", s.args},
+                      {"outputSize", s.outputSize},
+                      {"outputTime", s.outputTime},
+                      {"buildIdOffset", s.buildIdOffset},
+                      {"buildIdSize", s.buildIdSize},
+                      {"isCheriAbi", s.isCheriAbi},
+                      {"capabilitySize", s.capabilitySize},
+                      {"inputs", s.inputs},
+                      {"outputSections", s.outputSections},
+                      {"symbols", s.symbols},
+                      {"files", s.files}};
+}
+
+bool fromJSON(const json::Value &v, LinkState &s, json::Path p) {
+  json::ObjectMapper o(v, p);
+  return o && o.map("version", s.version) &&
+         o.map("lldVersion", s.lldVersion) && o.map("args", s.args) &&
+         o.map("outputSize", s.outputSize) &&
+         o.map("outputTime", s.outputTime) &&
+         o.map("buildIdOffset", s.buildIdOffset) &&
+         o.map("buildIdSize", s.buildIdSize) &&
+         o.map("isCheriAbi", s.isCheriAbi) &&
+         o.map("capabilitySize", s.capabilitySize) &&
+         o.map("inputs", s.inputs) &&
+         o.map("outputSections", s.outputSections) &&
+         o.map("symbols", s.symbols) && o.map("files", s.files);
+}
+} // namespace
+
+static std::string getStatePath() {
+  return (config->outputFile + ".incr").str();
+}
+
+static int64_t hashArgs(opt::InputArgList &args) {
+  std::string str;
+  for (opt::Arg *arg : args) {
+    str += arg->getAsString(args);
+    str += '\0';
+  }
+  return xxHash64(str);
+}
+
+static bool getOutputStatus(int64_t &size, int64_t &time) {
+  sys::fs::file_status st;
+  if (sys::fs::status(config->outputFile, st))
+    return false;
+  size = st.getSize();
+  time = st.getLastModificationTime().time_since_epoch().count();
+  return true;
+}
+
+// Returns the hashes of the files at the given paths, or 0 for files that
+// cannot be read.
+static std::vector<int64_t> hashFiles(ArrayRef<std::string> paths) {
+  std::vector<int64_t> hashes(paths.size());
+  parallelForEachN(0, paths.size(), [&](size_t i) {
+    auto mbOrErr = MemoryBuffer::getFile(paths[i], /*IsText=*/false,
+                                         /*RequiresNullTerminator=*/false);
+    if (mbOrErr)
+      hashes[i] = xxHash64((*mbOrErr)->getBuffer());
+  });
+  return hashes;
+}
+
+// Hashes the contents and relocations of every section of an object file. A
+// relocation is hashed together with the name, value and section index of the
+// symbol it refers to, so two versions of a section hash the same only if they
+// are written the same way at the same address. The hashes of symbol and
+// relocation tables are 0; changes to them are covered by the sections that
+// use them.
+template <class ELFT>
+static Optional<std::vector<int64_t>> hashSections(MemoryBufferRef mb) {
+  using Elf_Shdr = typename ELFT::Shdr;
+  auto objOrErr = ELFFile<ELFT>::create(mb.getBuffer());
+  if (!objOrErr) {
+    consumeError(objOrErr.takeError());
+    return None;
+  }
+  const ELFFile<ELFT> &obj = *objOrErr;
+  auto sectionsOrErr = obj.sections();
+  if (!sectionsOrErr) {
+    consumeError(sectionsOrErr.takeError());
+    return None;
+  }
+  ArrayRef<Elf_Shdr> sections = *sectionsOrErr;
+
+  typename ELFT::SymRange syms;
+  StringRef strtab;
+  for (const Elf_Shdr &sec : sections) {
+    if (sec.sh_type != SHT_SYMTAB)
+      continue;
+    auto symsOrErr = obj.symbols(&sec);
+    auto strtabOrErr = obj.getStringTableForSymtab(sec, sections);
+    if (!symsOrErr || !strtabOrErr) {
+      consumeError(symsOrErr.takeError());
+      consumeError(strtabOrErr.takeError());
+      return None;
+    }
+    syms = *symsOrErr;
+    strtab = *strtabOrErr;
+  }
+
+  std::vector<SmallVector<uint64_t, 0>> words(sections.size());
+  for (size_t i = 0, e = sections.size(); i != e; ++i) {
+    const Elf_Shdr &sec = sections[i];
+    if (sec.sh_type == SHT_REL || sec.sh_type == SHT_RELA ||
+        sec.sh_type == SHT_SYMTAB || sec.sh_type == SHT_STRTAB)
+      continue;
+    auto nameOrErr = obj.getSectionName(sec);
+    if (!nameOrErr) {
+      consumeError(nameOrErr.takeError());
+      return None;
+    }
+    words[i] = {xxHash64(*nameOrErr), sec.sh_type, sec.sh_flags,
+                sec.sh_addralign, sec.sh_size};
+    if (sec.sh_type == SHT_NOBITS)
+      continue;
+    auto contentsOrErr = obj.getSectionContents(sec);
+    if (!contentsOrErr) {
+      consumeError(contentsOrErr.takeError());
+      return None;
+    }
+    words[i].push_back(xxHash64(*contentsOrErr));
+  }
+
+  auto addSymbol = [&](SmallVector<uint64_t, 0> &w, uint32_t idx) {
+    if (idx >= syms.size())
+      return false;
+    const typename ELFT::Sym &sym = syms[idx];
+    StringRef name;
+    if (sym.st_name < strtab.size())
+      name = strtab.data() + sym.st_name;
+    w.push_back(xxHash64(name));
+    w.push_back(sym.st_value);
+    w.push_back(sym.st_shndx);
+    w.push_back(sym.st_info);
+    return true;
+  };
+  for (const Elf_Shdr &sec : sections) {
+    if ((sec.sh_type != SHT_REL && sec.sh_type != SHT_RELA) ||
+        sec.sh_info >= sections.size())
+      continue;
+    SmallVector<uint64_t, 0> &w = words[sec.sh_info];
+    if (sec.sh_type == SHT_RELA) {
+      auto relsOrErr = obj.relas(sec);
+      if (!relsOrErr) {
+        consumeError(relsOrErr.takeError());
+        return None;
+      }
+      for (const typename ELFT::Rela &rel : *relsOrErr) {
+        w.push_back(rel.r_offset);
+        w.push_back(rel.getType(config->isMips64EL));
+        w.push_back(rel.r_addend);
+        if (!addSymbol(w, rel.getSymbol(config->isMips64EL)))
+          return None;
+      }
+    } else {
+      auto relsOrErr = obj.rels(sec);
+      if (!relsOrErr) {
+        consumeError(relsOrErr.takeError());
+        return None;
+      }
+      for (const typename ELFT::Rel &rel : *relsOrErr) {
+        w.push_back(rel.r_offset);
+        w.push_back(rel.getType(config->isMips64EL));
+        if (!addSymbol(w, rel.getSymbol(config->isMips64EL)))
+          return None;
+      }
+    }
+  }
+
+  std::vector<int64_t> hashes(sections.size());
+  for (size_t i = 0, e = sections.size(); i != e; ++i)
+    if (!words[i].empty())
+      hashes[i] = xxHash64(StringRef(
+          reinterpret_cast<const char *>(words[i].data()),
+          words[i].size() * sizeof(uint64_t)));
+  return hashes;
+}
+
+static bool writeState(const LinkState &state) {
+  std::error_code ec;
+  raw_fd_ostream os(getStatePath(), ec, sys::fs::OF_None);
+  if (ec) {
+    warn("cannot write " + getStatePath() + ": " + ec.message());
+    return false;
+  }
+  os << json::Value(toJSON(state));
+  return true;
+}
+
+// Returns why an output cannot be updated in place, or an empty string.
+template <class ELFT> static std::string getUnsupportedReason() {
+  if (partitions.size() > 1)
+    return "partitions";
+  if (!sharedFiles.empty())
+    return "shared libraries";
+  if (config->icf != ICFLevel::None)
+    return "--icf";
+  if (InX<ELFT>::capRelocs && InX<ELFT>::capRelocs->containsLegacyCapRelocs())
+    return "legacy __cap_relocs input sections";
+  return "";
+}
+
+template <class ELFT>
+void elf::writeIncrementalState(opt::InputArgList &args) {
+  llvm::TimeTraceScope timeScope("Write incremental state");
+  using Elf_Sym = typename ELFT::Sym;
+  if (errorCount())
+    return;
+  std::string reason = getUnsupportedReason<ELFT>();
+  if (!reason.empty()) {
+    warn("--incremental is not supported with " + reason);
+    return;
+  }
+
+  LinkState state;
+  state.version = stateVersion;
+  state.lldVersion = getLLDVersion();
+  state.args = hashArgs(args);
+  state.isCheriAbi = config->isCheriAbi;
+  state.capabilitySize = config->capabilitySize;
+  if (!getOutputStatus(state.outputSize, state.outputTime))
+    return;
+
+  if (BuildIdSection *buildId = mainPart->buildId) {
+    if (buildId->getParent() && config->buildId != BuildIdKind::Hexstring) {
+      state.buildIdOffset = buildId->getParent()->offset + buildId->outSecOff +
+                            buildId->getSize() - buildId->hashSize;
+      state.buildIdSize = buildId->hashSize;
+    }
+  }
+
+  std::vector<std::string> paths;
+  for (StringRef path : config->dependencyFiles)
+    paths.push_back(path.str());
+  std::vector<int64_t> hashes = hashFiles(paths);
+  for (size_t i = 0, e = paths.size(); i != e; ++i)
+    state.inputs.push_back({paths[i], hashes[i]});
+
+  DenseMap<const OutputSection *, int64_t> osecIndex;
+  for (OutputSection *os : outputSections) {
+    osecIndex[os] = state.outputSections.size();
+    state.outputSections.push_back(
+        {os->name.str(), os->type, static_cast<int64_t>(os->flags),
+         static_cast<int64_t>(os->addr), static_cast<int64_t>(os->offset),
+         static_cast<int64_t>(os->size),
+         support::endian::read32le(os->getFiller().data())});
+  }
+  auto getOsecIndex = [&](const Symbol *sym) -> int64_t {
+    if (OutputSection *os = sym->getOutputSection())
+      return osecIndex.lookup(os);
+    return -1;
+  };
+
+  // Find the file offset of each .symtab entry.
+  DenseMap<const Symbol *, int64_t> symtabOffset;
+  if (in.symTab && in.symTab->getParent()) {
+    uint64_t off = in.symTab->getParent()->offset + in.symTab->outSecOff +
+                   sizeof(Elf_Sym);
+    for (const SymbolTableEntry &ent : in.symTab->getSymbols()) {
+      symtabOffset[ent.sym] = off;
+      off += sizeof(Elf_Sym);
+    }
+  }
+
+  // Symbols whose address or size is baked into a capability or a
+  // CHERIoT size relocation cannot move or change size.
+  DenseSet<const Symbol *> pinned;
+  if (InX<ELFT>::capRelocs)
+    InX<ELFT>::capRelocs->forEachTarget([&](const SymbolAndOffset &target) {
+      if (Symbol *sym = target.symOrSec.dyn_cast<Symbol *>())
+        pinned.insert(sym);
+    });
+  for (InputSectionBase *sec : inputSections)
+    for (const Relocation &rel : sec->relocations)
+      if (rel.expr == R_CHERIOT_COMPARTMENT_SIZE)
+        pinned.insert(rel.sym);
+
+  // Only the global capability table can be reused.
+  DenseMap<const Symbol *, int64_t> capSlot;
+  if (in.cheriCapTable && in.cheriCapTable->getParent() &&
+      ElfSym::cheriCapabilityTable &&
+      config->capTableScope == CapTableScopePolicy::All) {
+    uint64_t base = ElfSym::cheriCapabilityTable->getVA();
+    for (const auto &entry : in.cheriCapTable->getGlobalEntryOffsets())
+      capSlot[entry.first] = base + entry.second;
+  }
+  auto getCapSlot = [&](const Symbol *sym) -> int64_t {
+    auto it = capSlot.find(sym);
+    return it == capSlot.end() ? -1 : it->second;
+  };
+  auto getSymtabOffset = [&](const Symbol *sym) -> int64_t {
+    auto it = symtabOffset.find(sym);
+    return it == symtabOffset.end() ? -1 : it->second;
+  };
+
+  for (Symbol *sym : symtab->symbols()) {
+    auto *d = dyn_cast<Defined>(sym);
+    if (!d || (d->section && !d->getOutputSection()))
+      continue;
+    SymbolState s;
+    s.name = d->getName().str();
+    if (d->file)
+      s.file = d->file->getName().str();
+    s.type = d->type;
+    s.va = d->getVA();
+    s.size = d->getSize();
+    s.osec = getOsecIndex(d);
+    s.symtab = getSymtabOffset(d);
+    s.capSlot = getCapSlot(d);
+    s.pinned = pinned.count(d);
+    state.symbols.push_back(std::move(s));
+  }
+
+  // Save the layout of each object file that was given on the command line.
+  // Archive members and LTO output are not saved, so any change to them needs
+  // a full link.
+  std::vector<ObjFile<ELFT> *> objs;
+  for (InputFile *file : objectFiles)
+    if (auto *obj = dyn_cast<ObjFile<ELFT>>(file))
+      if (obj->archiveName.empty() && !obj->justSymbols &&
+          config->dependencyFiles.count(CachedHashString(obj->getName())))
+        objs.push_back(obj);
+  std::vector<FileState> files(objs.size());
+  std::vector<bool> saved(objs.size());
+  parallelForEachN(0, objs.size(), [&](size_t i) {
+    ObjFile<ELFT> *obj = objs[i];
+    Optional<std::vector<int64_t>> hashes = hashSections<ELFT>(obj->mb);
+    ArrayRef<InputSectionBase *> sections = obj->getSections();
+    if (!hashes || hashes->size() != sections.size())
+      return;
+
+    FileState &fs = files[i];
+    fs.path = obj->getName().str();
+    fs.sections.resize(sections.size());
+    for (size_t j = 0, e = sections.size(); j != e; ++j) {
+      SectionState &ss = fs.sections[j];
+      InputSectionBase *sec = sections[j];
+      ss.hash = (*hashes)[j];
+      if (!sec)
+        continue;
+      ss.name = sec->name.str();
+      if (sec == &InputSection::discarded) {
+        ss.kind = Discarded;
+      } else if (!sec->isLive() || !sec->getOutputSection()) {
+        ss.kind = Dead;
+      } else if (auto *ms = dyn_cast<MergeInputSection>(sec)) {
+        ss.kind = Merge;
+        ss.osec = osecIndex.lookup(ms->getOutputSection());
+        for (const SectionPiece &piece : ms->pieces) {
+          if (!piece.live)
+            continue;
+          ss.pieces.push_back(piece.inputOff);
+          ss.pieces.push_back(ms->getVA(piece.inputOff));
+        }
+      } else if (sec->kind() == SectionBase::Regular) {
+        auto *isec = cast<InputSection>(sec);
+        ss.kind = Placed;
+        ss.osec = osecIndex.lookup(isec->getParent());
+        ss.outSecOff = isec->outSecOff;
+        ss.slot = isec->getSize() + getIncrementalSlack(isec);
+        ss.alignment = isec->alignment;
+      } else {
+        ss.kind = Other;
+      }
+    }
+
+    ArrayRef<Symbol *> syms = obj->getSymbols();
+    size_t firstGlobal = getFirstGlobal(obj);
+    fs.symbols.resize(syms.size());
+    for (size_t j = 0, e = syms.size(); j != e; ++j) {
+      FileSymbolState &s = fs.symbols[j];
+      s.name = syms[j]->getName().str();
+      s.global = j >= firstGlobal;
+      auto *d = dyn_cast<Defined>(syms[j]);
+      if (s.global || !d || (d->section && !d->getOutputSection()))
+        continue;
+      s.va = d->getVA();
+      s.size = d->getSize();
+      s.symtab = getSymtabOffset(d);
+      s.capSlot = getCapSlot(d);
+      s.pinned = pinned.count(d);
+    }
+    saved[i] = true;
+  });
+  for (size_t i = 0, e = files.size(); i != e; ++i)
+    if (saved[i])
+      state.files.push_back(std::move(files[i]));
+
+  writeState(state);
+}
+
+namespace {
+template <class ELFT> class IncrementalLink {
+public:
+  IncrementalLink(LinkState &state) : state(state) {}
+  bool run(opt::InputArgList &args, ArrayRef<InputFile *> files);
+
+private:
+  // A section to write over the previous output.
+  struct Patch {
+    InputSection *sec;
+    SectionState *state;
+    std::vector<uint8_t> contents;
+  };
+
+  // A .symtab entry to update.
+  struct SymtabPatch {
+    int64_t offset;
+    uint64_t value;
+    uint64_t size;
+  };
+
+  bool fail(const Twine &msg) {
+    log("--incremental: " + msg + "; doing a full link");
+    return false;
+  }
+
+  OutputSection *getOutputSection(int64_t idx);
+  InputSection *getAnchor(int64_t idx);
+  Defined *makeSymbolAt(uint64_t va);
+  Optional<uint64_t> getSymbolVA(const Defined &d, int64_t addend = 0);
+
+  bool placeSections(ObjFile<ELFT> *obj, FileState &fs,
+                     ArrayRef<int64_t> hashes);
+  bool resolveSymbols(ObjFile<ELFT> *obj, FileState &fs);
+  bool checkSymbols(ObjFile<ELFT> *obj, FileState &fs);
+  template <class RelTy>
+  bool scanRelocations(ObjFile<ELFT> *obj, FileState &fs, InputSection *sec,
+                       ArrayRef<RelTy> rels);
+  bool relocate(ObjFile<ELFT> *obj, FileState &fs, Patch &patch);
+  bool writeOutput();
+
+  LinkState &state;
+  StringMap<SymbolState *> globals;
+  DenseMap<int64_t, OutputSection *> outputSecs;
+  DenseMap<int64_t, InputSection *> anchors;
+  DenseMap<const SectionBase *, SectionState *> sectionStates;
+  std::vector<Patch> patches;
+  std::vector<SymtabPatch> symtabPatches;
+};
+} // namespace
+
+template <class ELFT>
+OutputSection *IncrementalLink<ELFT>::getOutputSection(int64_t idx) {
+  OutputSection *&os = outputSecs[idx];
+  if (!os) {
+    const OutputSectionState &s = state.outputSections[idx];
+    os = make<OutputSection>(saver.save(s.name), s.type, s.flags);
+    os->addr = s.addr;
+    os->offset = s.offset;
+    os->size = s.size;
+  }
+  return os;
+}
+
+// Symbols of other files are replaced by symbols in an empty section at the
+// start of their output section, so that they have the same address and
+// output section as in the previous link.
+template <class ELFT>
+InputSection *IncrementalLink<ELFT>::getAnchor(int64_t idx) {
+  InputSection *&anchor = anchors[idx];
+  if (!anchor) {
+    OutputSection *os = getOutputSection(idx);
+    anchor = make<InputSection>(nullptr, os->flags, os->type, 1,
+                                ArrayRef<uint8_t>(), os->name);
+    anchor->parent = os;
+    anchor->outSecOff = 0;
+  }
+  return anchor;
+}
+
+template <class ELFT>
+Defined *IncrementalLink<ELFT>::makeSymbolAt(uint64_t va) {
+  for (size_t i = 0, e = state.outputSections.size(); i != e; ++i) {
+    const OutputSectionState &s = state.outputSections[i];
+    if (!(s.flags & SHF_ALLOC) || va < uint64_t(s.addr) ||
+        va >= uint64_t(s.addr + s.size))
+      continue;
+    return make<Defined>(nullptr, "", STB_LOCAL, STV_DEFAULT, STT_NOTYPE,
+                         va - s.addr, 0, getAnchor(i));
+  }
+  return make<Defined>(nullptr, "", STB_LOCAL, STV_DEFAULT, STT_NOTYPE, va, 0,
+                       nullptr);
+}
+
+template <class ELFT>
+Optional<uint64_t> IncrementalLink<ELFT>::getSymbolVA(const Defined &d,
+                                                      int64_t addend) {
+  if (!d.section)
+    return d.value + addend;
+  if (auto *isec = dyn_cast<InputSection>(d.section)) {
+    if (!isec->getParent())
+      return None;
+    return isec->getVA(d.value + addend);
+  }
+  if (auto *ms = dyn_cast<MergeInputSection>(d.section)) {
+    SectionState *ss = sectionStates.lookup(ms);
+    if (!ss)
+      return None;
+    // The pieces are sorted by input offset.
+    uint64_t off = d.value + addend;
+    ArrayRef<int64_t> pieces = ss->pieces;
+    for (size_t i = pieces.size(); i >= 2; i -= 2)
+      if (uint64_t(pieces[i - 2]) <= off)
+        return pieces[i - 1] + (off - pieces[i - 2]);
+  }
+  return None;
+}
+
+// Gives the sections of a changed file the same place as in the previous
+// link, and queues the sections whose contents changed to be rewritten.
+template <class ELFT>
+bool IncrementalLink<ELFT>::placeSections(ObjFile<ELFT> *obj, FileState &fs,
+                                          ArrayRef<int64_t> hashes) {
+  ArrayRef<InputSectionBase *> sections = obj->getSections();
+  if (sections.size() != fs.sections.size() ||
+      hashes.size() != fs.sections.size())
+    return fail(toString(obj) + " has a different number of sections");
+
+  for (size_t i = 0, e = sections.size(); i != e; ++i) {
+    InputSectionBase *sec = sections[i];
+    SectionState &ss = fs.sections[i];
+    bool changed = hashes[i] != ss.hash;
+    if (sec && sec != &InputSection::discarded && sec->name != ss.name)
+      return fail(toString(obj) + " has different sections");
+    if (sec && sec->type == SHT_LLVM_DEPENDENT_LIBRARIES)
+      return fail(toString(obj) + " has dependent libraries");
+
+    switch (ss.kind) {
+    case NoSection:
+    case Discarded:
+      // Symbol and relocation tables are checked through the sections that
+      // use them. A discarded COMDAT member stays discarded because the file
+      // that wins the group does not change.
+      break;
+    case Merge:
+      if (changed || !isa_and_nonnull<MergeInputSection>(sec))
+        return fail(toString(sec) + " changed and is mergeable");
+      sectionStates[sec] = &ss;
+      break;
+    case Placed: {
+      if (!sec || sec->kind() != SectionBase::Regular)
+        return fail(toString(obj) + " has different sections");
+      auto *isec = cast<InputSection>(sec);
+      isec->parent = getOutputSection(ss.osec);
+      isec->outSecOff = ss.outSecOff;
+      sectionStates[sec] = &ss;
+      if (!changed)
+        break;
+      if (!(isec->flags & SHF_ALLOC))
+        return fail(toString(isec) + " changed and is not allocated");
+      if (isec->getSize() > uint64_t(ss.slot))
+        return fail(toString(isec) + " does not fit into its slot");
+      if (ss.outSecOff % isec->alignment)
+        return fail(toString(isec) + " needs a larger alignment");
+      patches.push_back({isec, &ss, {}});
+      break;
+    }
+    default:
+      if (changed)
+        return fail(toString(sec) + " changed and cannot be patched");
+      break;
+    }
+  }
+  return true;
+}
+
+// Resolves the global symbols of a changed file against the saved symbol
+// table.
+template <class ELFT>
+bool IncrementalLink<ELFT>::resolveSymbols(ObjFile<ELFT> *obj, FileState &fs) {
+  ArrayRef<Symbol *> syms = obj->getSymbols();
+  if (syms.size() != fs.symbols.size())
+    return fail(toString(obj) + " has a different number of symbols");
+  size_t firstGlobal = getFirstGlobal(obj);
+  for (size_t i = 0, e = syms.size(); i != e; ++i) {
+    Symbol *sym = syms[i];
+    const FileSymbolState &s = fs.symbols[i];
+    if (sym->getName() != s.name || (i >= firstGlobal) != s.global)
+      return fail(toString(obj) + " has different symbols");
+    if (!s.global)
+      continue;
+
+    SymbolState *gs = globals.lookup(sym->getName());
+    auto *d = dyn_cast<Defined>(sym);
+    bool definedHere = d && d->file == obj;
+    if (gs && gs->file == fs.path) {
+      // This file defined the symbol. It is checked by checkSymbols().
+      if (!definedHere)
+        return fail(toString(*sym) + " is no longer defined");
+      continue;
+    }
+    if (definedHere && d->section && !d->section->isLive())
+      continue;
+    if (definedHere && !gs) {
+      if (!d->section || sectionStates.count(d->section))
+        return fail("new symbol " + toString(*sym));
+      continue;
+    }
+    if (isa<CommonSymbol>(sym))
+      return fail("common symbol " + toString(*sym));
+    if (!gs) {
+      if (sym->isUndefWeak())
+        continue;
+      return fail(toString(*sym) + " was not defined in the previous link");
+    }
+    if (gs->type == STT_TLS)
+      return fail("thread-local symbol " + toString(*sym));
+
+    InputSection *anchor = gs->osec >= 0 ? getAnchor(gs->osec) : nullptr;
+    uint64_t value =
+        gs->va - (anchor ? state.outputSections[gs->osec].addr : 0);
+    sym->replace(Defined{nullptr, sym->getName(), STB_GLOBAL, sym->stOther,
+                         static_cast<uint8_t>(gs->type), value,
+                         static_cast<uint64_t>(gs->size), anchor});
+  }
+  return true;
+}
+
+// Checks that the symbols of a changed file are where other files expect them
+// and queues the .symtab updates.
+template <class ELFT>
+bool IncrementalLink<ELFT>::checkSymbols(ObjFile<ELFT> *obj, FileState &fs) {
+  ArrayRef<Symbol *> syms = obj->getSymbols();
+  for (size_t i = 0, e = syms.size(); i != e; ++i) {
+    auto *d = dyn_cast<Defined>(syms[i]);
+    if (!d || d->file != obj)
+      continue;
+    FileSymbolState &s = fs.symbols[i];
+    SymbolState *gs = s.global ? globals.lookup(d->getName()) : nullptr;
+    if (s.global && (!gs || gs->file != fs.path))
+      continue;
+    if (d->isTls() || d->isSection())
+      continue;
+
+    Optional<uint64_t> va = getSymbolVA(*d);
+    if (!va)
+      continue;
+    uint64_t size = d->getSize();
+    if (gs) {
+      if (*va != uint64_t(gs->va) || d->type != gs->type)
+        return fail(toString(*d) + " moved");
+      if (size != uint64_t(gs->size)) {
+        if (gs->pinned)
+          return fail("the size of " + toString(*d) + " is used elsewhere");
+        gs->size = size;
+        if (gs->symtab >= 0)
+          symtabPatches.push_back({gs->symtab, *va, size});
+      }
+      continue;
+    }
+    if (*va == uint64_t(s.va) && size == uint64_t(s.size))
+      continue;
+    if (s.pinned)
+      return fail("the address of " + toString(*d) + " is used elsewhere");
+    s.va = *va;
+    s.size = size;
+    if (s.symtab >= 0)
+      symtabPatches.push_back({s.symtab, *va, size});
+  }
+  return true;
+}
+
+template <class ELFT>
+static int64_t getAddend(const typename ELFT::Rel &rel, const uint8_t *loc,
+                         RelType type) {
+  return target->getImplicitAddend(loc, type);
+}
+
+template <class ELFT>
+static int64_t getAddend(const typename ELFT::Rela &rel, const uint8_t *loc,
+                         RelType type) {
+  return rel.r_addend;
+}
+
+// Rebuilds the relocations of a changed section. Only relocations that do not
+// need a synthetic section other than the capability table are supported.
+template <class ELFT>
+template <class RelTy>
+bool IncrementalLink<ELFT>::scanRelocations(ObjFile<ELFT> *obj, FileState &fs,
+                                            InputSection *sec,
+                                            ArrayRef<RelTy> rels) {
+  const uint8_t *data = sec->data().data();
+  size_t firstGlobal = getFirstGlobal(obj);
+  for (const RelTy &rel : rels) {
+    RelType type = rel.getType(config->isMips64EL);
+    uint32_t symIndex = rel.getSymbol(config->isMips64EL);
+    Symbol *sym = &obj->getSymbol(symIndex);
+    uint64_t offset = rel.r_offset;
+    if (offset >= sec->getSize())
+      return fail(toString(sec) + " has a relocation out of bounds");
+    int64_t addend = getAddend<ELFT>(rel, data + offset, type);
+    RelExpr expr = target->getRelExpr(type, *sym, data + offset);
+
+    switch (expr) {
+    case R_NONE:
+    case R_RELAX_HINT:
+      continue;
+    case R_PLT_PC:
+      expr = R_PC;
+      break;
+    case R_PLT:
+      expr = R_ABS;
+      break;
+    case R_ABS:
+    case R_PC:
+    case R_RISCV_ADD:
+    case R_RISCV_PC_INDIRECT:
+    case R_CHERIOT_COMPARTMENT_CGPREL_HI:
+    case R_CHERIOT_COMPARTMENT_CGPREL_LO_I:
+    case R_CHERIOT_COMPARTMENT_CGPREL_LO_S:
+    case R_CHERIOT_COMPARTMENT_SIZE:
+      break;
+    case R_CHERI_CAPABILITY_TABLE_ENTRY_PC: {
+      // Refer to the existing capability table entry directly.
+      SymbolState *gs =
+          symIndex >= firstGlobal ? globals.lookup(sym->getName())
+                                       : nullptr;
+      int64_t slot = gs ? gs->capSlot
+                        : symIndex < firstGlobal
+                              ? fs.symbols[symIndex].capSlot
+                              : -1;
+      if (slot < 0)
+        return fail(toString(*sym) + " has no capability table entry");
+      sec->relocations.push_back(
+          {R_PC, type, offset, addend, makeSymbolAt(slot)});
+      continue;
+    }
+    default:
+      return fail(toString(sec) + " has a relocation of type " +
+                  toString(type) + " against " + toString(*sym));
+    }
+
+    if (auto *d = dyn_cast<Defined>(sym)) {
+      if (isa_and_nonnull<MergeInputSection>(d->section)) {
+        // Refer to the piece directly; the merged section is not rebuilt.
+        Optional<uint64_t> va = getSymbolVA(*d, addend);
+        if (!va)
+          return fail(toString(sec) + " refers to a dead string");
+        sym = makeSymbolAt(*va);
+        addend = 0;
+      } else if (d->section && !isa<InputSection>(d->section)) {
+        return fail(toString(sec) + " refers to " + toString(*sym) +
+                    " in a section that cannot be patched");
+      } else if (d->section && !cast<InputSection>(d->section)->getParent()) {
+        return fail(toString(sec) + " refers to " + toString(*sym) +
+                    " in a section that is not in the output");
+      }
+    }
+    sec->relocations.push_back({expr, type, offset, addend, sym});
+  }
+  // getRISCVPCRelHi20() does a binary search.
+  llvm::stable_sort(sec->relocations,
+                    [](const Relocation &a, const Relocation &b) {
+                      return a.offset < b.offset;
+                    });
+  return true;
+}
+
+template <class ELFT>
+bool IncrementalLink<ELFT>::relocate(ObjFile<ELFT> *obj, FileState &fs,
+                                     Patch &patch) {
+  InputSection *sec = patch.sec;
+  if (sec->areRelocsRela) {
+    if (!scanRelocations(obj, fs, sec, sec->template relas<ELFT>()))
+      return false;
+  } else if (!scanRelocations(obj, fs, sec, sec->template rels<ELFT>())) {
+    return false;
+  }
+  if (sec->type == SHT_NOBITS)
+    return true;
+
+  // Fill the free space the same way as the gaps between input sections.
+  std::vector<uint8_t> &buf = patch.contents;
+  buf.resize(patch.state->slot);
+  uint32_t filler = state.outputSections[patch.state->osec].filler;
+  for (size_t i = 0, e = buf.size(); i < e; i += 4)
+    for (size_t j = 0; j < 4 && i + j < e; ++j)
+      buf[i + j] = filler >> (8 * j);
+
+  ArrayRef<uint8_t> data = sec->data();
+  memcpy(buf.data(), data.data(), data.size());
+  sec->relocateAlloc(buf.data(), buf.data() + data.size());
+  return true;
+}
+
+template <class ELFT> bool IncrementalLink<ELFT>::writeOutput() {
+  using Elf_Sym = typename ELFT::Sym;
+  int fd;
+  if (std::error_code ec = sys::fs::openFileForReadWrite(
+          config->outputFile, fd, sys::fs::CD_OpenExisting, sys::fs::OF_None))
+    return fail("cannot open " + config->outputFile + ": " + ec.message());
+  auto closeFile =
+      make_scope_exit([&] { sys::Process::SafelyCloseFileDescriptor(fd); });
+
+  std::error_code ec;
+  sys::fs::mapped_file_region map(sys::fs::convertFDToNativeFile(fd),
+                                  sys::fs::mapped_file_region::readwrite,
+                                  state.outputSize, 0, ec);
+  if (ec)
+    return fail("cannot map " + config->outputFile + ": " + ec.message());
+  uint8_t *buf = reinterpret_cast<uint8_t *>(map.data());
+
+  for (const Patch &patch : patches)
+    if (!patch.contents.empty())
+      memcpy(buf + state.outputSections[patch.state->osec].offset +
+                 patch.state->outSecOff,
+             patch.contents.data(), patch.contents.size());
+
+  for (const SymtabPatch &patch : symtabPatches) {
+    auto *eSym = reinterpret_cast<Elf_Sym *>(buf + patch.offset);
+    eSym->st_value = patch.value;
+    eSym->st_size = patch.size;
+  }
+
+  if (state.buildIdOffset >= 0) {
+    MutableArrayRef<uint8_t> buildId(buf + state.buildIdOffset,
+                                     state.buildIdSize);
+    std::vector<uint8_t> hash(buildId.size());
+    std::fill(buildId.begin(), buildId.end(), 0);
+    computeBuildId(hash, {buf, size_t(state.outputSize)});
+    llvm::copy(hash, buildId.begin());
+  }
+  return true;
+}
+
+template <class ELFT>
+bool IncrementalLink<ELFT>::run(opt::InputArgList &args,
+                                ArrayRef<InputFile *> files) {
+  if (state.version != stateVersion || state.lldVersion != getLLDVersion())
+    return fail("the state was written by a different linker");
+  if (state.args != hashArgs(args))
+    return fail("the command line changed");
+  std::string reason = getUnsupportedReason<ELFT>();
+  if (!reason.empty())
+    return fail("not supported with " + reason);
+  if (!config->mapFile.empty() || config->cref ||
+      !config->printArchiveStats.empty() ||
+      config->shouldEmitCompartmentReport())
+    return fail("a report was requested");
+
+  int64_t outputSize, outputTime;
+  if (!getOutputStatus(outputSize, outputTime) ||
+      outputSize != state.outputSize || outputTime != state.outputTime)
+    return fail("the output was modified");
+
+  // Find the inputs that changed. Everything that was read so far must have
+  // been read by the previous link as well.
+  StringMap<InputState *> inputs;
+  std::vector<std::string> paths;
+  for (InputState &input : state.inputs) {
+    inputs[input.path] = &input;
+    paths.push_back(input.path);
+  }
+  for (StringRef path : config->dependencyFiles)
+    if (!inputs.count(path))
+      return fail(path + " was not used by the previous link");
+  std::vector<int64_t> hashes = hashFiles(paths);
+
+  StringMap<FileState *> fileStates;
+  for (FileState &fs : state.files)
+    fileStates[fs.path] = &fs;
+  std::vector<std::pair<ObjFile<ELFT> *, FileState *>> changed;
+  for (size_t i = 0, e = paths.size(); i != e; ++i) {
+    if (hashes[i] == state.inputs[i].hash)
+      continue;
+    state.inputs[i].hash = hashes[i];
+    FileState *fs = fileStates.lookup(paths[i]);
+    auto it = llvm::find_if(files, [&](InputFile *f) {
+      return f->getName() == paths[i];
+    });
+    if (!fs || it == files.end() || !isa<ObjFile<ELFT>>(*it))
+      return fail(paths[i] + " changed and is not an object file");
+    // Parse a fresh copy so that the original file can still be linked if
+    // this fails.
+    changed.push_back({make<ObjFile<ELFT>>((*it)->mb, ""), fs});
+  }
+  if (changed.empty()) {
+    log("--incremental: " + config->outputFile + " is up to date");
+    return true;
+  }
+
+  for (SymbolState &s : state.symbols)
+    globals[s.name] = &s;
+
+  // Parse the changed files into a scratch symbol table. The ABI is not known
+  // until all input files are read, so relocate against the one that was
+  // saved. A full link computes its own if this fails.
+  SymbolTable *savedSymtab = symtab;
+  InputSection *savedAttributes = in.attributes;
+  bool savedIsCheriAbi = config->isCheriAbi;
+  int savedCapabilitySize = config->capabilitySize;
+  symtab = make<SymbolTable>();
+  config->isCheriAbi = state.isCheriAbi;
+  config->capabilitySize = state.capabilitySize;
+  auto restore = make_scope_exit([&] {
+    symtab = savedSymtab;
+    in.attributes = savedAttributes;
+    config->isCheriAbi = savedIsCheriAbi;
+    config->capabilitySize = savedCapabilitySize;
+  });
+
+  for (auto &it : changed) {
+    ObjFile<ELFT> *obj = it.first;
+    FileState &fs = *it.second;
+    Optional<std::vector<int64_t>> sectionHashes =
+        hashSections<ELFT>(obj->mb);
+    if (!sectionHashes)
+      return fail("cannot read " + toString(obj));
+    uint64_t errors = errorCount();
+    obj->parse();
+    if (errorCount() != errors)
+      return fail("cannot parse " + toString(obj));
+    if (!placeSections(obj, fs, *sectionHashes) || !resolveSymbols(obj, fs))
+      return false;
+    for (size_t i = 0, e = sectionHashes->size(); i != e; ++i)
+      fs.sections[i].hash = (*sectionHashes)[i];
+  }
+  for (auto &it : changed)
+    if (!checkSymbols(it.first, *it.second))
+      return false;
+  for (Patch &patch : patches) {
+    auto *obj = cast<ObjFile<ELFT>>(patch.sec->file);
+    if (!relocate(obj, *fileStates.lookup(obj->getName()), patch))
+      return false;
+  }
+  // Relocation errors are as fatal as in a full link.
+  if (errorCount())
+    return true;
+
+  if (!writeOutput())
+    return false;
+  if (!getOutputStatus(state.outputSize, state.outputTime))
+    return true;
+  writeState(state);
+  log("--incremental: patched " + Twine(patches.size()) + " sections in " +
+      config->outputFile);
+  return true;
+}
+
+template <class ELFT>
+bool elf::tryIncrementalLink(opt::InputArgList &args,
+                             ArrayRef<InputFile *> files) {
+  llvm::TimeTraceScope timeScope("Incremental link");
+  auto mbOrErr = MemoryBuffer::getFile(getStatePath(), /*IsText=*/true);
+  if (!mbOrErr)
+    return false;
+
+  LinkState state;
+  bool patched = false;
+  Expected<json::Value> v = json::parse((*mbOrErr)->getBuffer());
+  if (!v) {
+    log("--incremental: cannot parse " + getStatePath() + ": " +
+        toString(v.takeError()));
+  } else {
+    json::Path::Root root;
+    if (!fromJSON(*v, state, root))
+      log("--incremental: cannot parse " + getStatePath() + ": " +
+          toString(root.getError()));
+    else
+      patched = IncrementalLink<ELFT>(state).run(args, files);
+  }
+
+  // The full link writes a new state. Don't leave a stale one behind if it
+  // fails.
+  if (!patched)
+    sys::fs::remove(getStatePath());
+  return patched;
+}
+
+template bool elf::tryIncrementalLink<ELF32LE>(opt::InputArgList &,
+                                               ArrayRef<InputFile *>);
+template bool elf::tryIncrementalLink<ELF32BE>(opt::InputArgList &,
+                                               ArrayRef<InputFile *>);
+template bool elf::tryIncrementalLink<ELF64LE>(opt::InputArgList &,
+                                               ArrayRef<InputFile *>);
+template bool elf::tryIncrementalLink<ELF64BE>(opt::InputArgList &,
+                                               ArrayRef<InputFile *>);
+
+template void elf::writeIncrementalState<ELF32LE>(opt::InputArgList &);
+template void elf::writeIncrementalState<ELF32BE>(opt::InputArgList &);
+template void elf::writeIncrementalState<ELF64LE>(opt::InputArgList &);
+template void elf::writeIncrementalState<ELF64BE>(opt::InputArgList &);
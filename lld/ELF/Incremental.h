@@ -0,0 +1,44 @@
+//===- Incremental.h --------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_INCREMENTAL_H
+#define LLD_ELF_INCREMENTAL_H
+
+#include "lld/Common/LLVM.h"
+#include <cstdint>
+
+namespace llvm {
+namespace opt {
+class InputArgList;
+}
+} // namespace llvm
+
+namespace lld {
+namespace elf {
+class InputFile;
+class InputSection;
+
+// Returns the number of bytes to leave free after s so that a later
+// incremental link can grow it in place.
+uint64_t getIncrementalSlack(const InputSection *s);
+
+// Tries to bring the output of a previous --incremental link up to date by
+// patching the input sections that changed. Returns false if a full link is
+// needed.
+template <class ELFT>
+bool tryIncrementalLink(llvm::opt::InputArgList &args,
+                        ArrayRef<InputFile *> files);
+
+// Saves the layout of the output that was just written for the next
+// incremental link.
+template <class ELFT>
+void writeIncrementalState(llvm::opt::InputArgList &args);
+} // namespace elf
+} // namespace lld
+
+#endif
@@ -26,10 +26,12 @@
 #include "llvm/Support/ARMAttributeParser.h"
 #include "llvm/Support/ARMBuildAttributes.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/RISCVAttributeParser.h"
 #include "llvm/Support/TarWriter.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
 
 using namespace llvm;
 using namespace llvm::ELF;
@@ -389,6 +391,117 @@ template <class ELFT> void ELFFileBase::init() {
   stringTable = CHECK(obj.getStringTableForSymtab(*symtabSec, sections), this);
 }
 
+// Returns SymbolTable::hashName() of each global symbol name in an ELF
+// relocatable object. This runs on worker threads, so it does not report
+// errors; files it cannot read get no hashes, and parseFile() diagnoses them
+// as usual.
+template <class ELFT>
+static std::vector<uint32_t> hashGlobalSymbolNames(MemoryBufferRef mb) {
+  std::pair<unsigned char, unsigned char> type =
+      getElfArchType(mb.getBuffer());
+  if (type.first != (ELFT::Is64Bits ? ELFCLASS64 : ELFCLASS32) ||
+      type.second != (ELFT::TargetEndianness == support::little ? ELFDATA2LSB
+                                                                : ELFDATA2MSB))
+    return {};
+
+  auto hashNames = [&]() -> Expected<std::vector<uint32_t>> {
+    Expected<ELFFile<ELFT>> obj = ELFFile<ELFT>::create(mb.getBuffer());
+    if (!obj)
+      return obj.takeError();
+    Expected<typename ELFT::ShdrRange> sections = obj->sections();
+    if (!sections)
+      return sections.takeError();
+    const typename ELFT::Shdr *symtabSec = findSection(*sections, SHT_SYMTAB);
+    if (!symtabSec)
+      return std::vector<uint32_t>();
+    Expected<typename ELFT::SymRange> eSyms = obj->symbols(symtabSec);
+    if (!eSyms)
+      return eSyms.takeError();
+    Expected<StringRef> strtab =
+        obj->getStringTableForSymtab(*symtabSec, *sections);
+    if (!strtab)
+      return strtab.takeError();
+
+    std::vector<uint32_t> hashes;
+    for (size_t i = symtabSec->sh_info, e = eSyms->size(); i < e; ++i) {
+      Expected<StringRef> name = (*eSyms)[i].getName(*strtab);
+      if (!name) {
+        consumeError(name.takeError());
+        hashes.push_back(0);
+        continue;
+      }
+      hashes.push_back(SymbolTable::hashName(*name));
+    }
+    return std::move(hashes);
+  };
+
+  Expected<std::vector<uint32_t>> hashes = hashNames();
+  if (!hashes) {
+    consumeError(hashes.takeError());
+    return {};
+  }
+  return std::move(*hashes);
+}
+
+static std::vector<uint32_t> hashGlobalSymbolNames(MemoryBufferRef mb) {
+  switch (config->ekind) {
+  case ELF32LEKind:
+    return hashGlobalSymbolNames<ELF32LE>(mb);
+  case ELF32BEKind:
+    return hashGlobalSymbolNames<ELF32BE>(mb);
+  case ELF64LEKind:
+    return hashGlobalSymbolNames<ELF64LE>(mb);
+  case ELF64BEKind:
+    return hashGlobalSymbolNames<ELF64BE>(mb);
+  default:
+    llvm_unreachable("unknown ELFT");
+  }
+}
+
+void elf::prehashSymbolNames(ArrayRef<InputFile *> files) {
+  // The hashes are also used to count the distinct names to presize the
+  // symbol table. Each file splits its hashes into one bucket per shard, so
+  // that each shard can be deduplicated independently by looking only at its
+  // own buckets. Names whose hashes collide are counted once, which is fine
+  // for an estimate.
+  size_t numShards = parallel::strategy.compute_thread_count();
+  std::vector<std::vector<std::vector<uint32_t>>> buckets(files.size());
+  parallelForEachN(0, files.size(), [&](size_t i) {
+    InputFile *file = files[i];
+    ArrayRef<uint32_t> hashes;
+    if (auto *f = dyn_cast<ArchiveFile>(file)) {
+      f->hashSymbolNames();
+      hashes = f->symbolNameHashes;
+    } else if (file->kind() == InputFile::ObjKind) {
+      auto *f = cast<ELFFileBase>(file);
+      f->globalNameHashes = hashGlobalSymbolNames(file->mb);
+      hashes = f->globalNameHashes;
+    }
+    if (hashes.empty())
+      return;
+    buckets[i].resize(numShards);
+    for (uint32_t hash : hashes)
+      buckets[i][hash % numShards].push_back(hash);
+  });
+
+  std::vector<size_t> numNames(numShards);
+  parallelForEachN(0, numShards, [&](size_t shard) {
+    std::vector<uint32_t> shardHashes;
+    for (std::vector<std::vector<uint32_t>> &fileBuckets : buckets)
+      if (!fileBuckets.empty())
+        shardHashes.insert(shardHashes.end(), fileBuckets[shard].begin(),
+                           fileBuckets[shard].end());
+    llvm::sort(shardHashes);
+    numNames[shard] = std::unique(shardHashes.begin(), shardHashes.end()) -
+                      shardHashes.begin();
+  });
+
+  size_t total = 0;
+  for (size_t n : numNames)
+    total += n;
+  symtab->reserve(total);
+}
+
 template <class ELFT>
 uint32_t ObjFile<ELFT>::getSectionIndex(const Elf_Sym &sym) const {
   return CHECK(
@@ -399,6 +512,8 @@ uint32_t ObjFile<ELFT>::getSectionIndex(const Elf_Sym &sym) const {
 template <class ELFT> ArrayRef<Symbol *> ObjFile<ELFT>::getLocalSymbols() {
   if (this->symbols.empty())
     return {};
+  if (this->lazyLocals)
+    initializeLocalSymbols();
   return makeArrayRef(this->symbols).slice(1, this->firstGlobal - 1);
 }
 
@@ -1085,11 +1200,154 @@ StringRef ObjFile<ELFT>::getSectionName(const Elf_Shdr &sec) {
   return CHECK(getObj().getSectionName(sec, sectionStringTable), this);
 }
 
+// Creates the local symbol at index i of the ELF symbol table. The symbol has
+// been validated by initializeSymbols().
+template <class ELFT> Symbol *ObjFile<ELFT>::createLocalSymbol(uint32_t i) {
+  const Elf_Sym &eSym = this->getELFSyms<ELFT>()[i];
+  uint32_t secIdx = getSectionIndex(eSym);
+  InputSectionBase *sec = this->sections[secIdx];
+  uint8_t type = eSym.getType();
+  StringRefZ name = this->stringTable.data() + eSym.st_name;
+
+  if (eSym.st_shndx == SHN_UNDEF)
+    return make<Undefined>(this, name, STB_LOCAL, eSym.st_other, type);
+  if (sec == &InputSection::discarded)
+    return make<Undefined>(this, name, STB_LOCAL, eSym.st_other, type,
+                           /*discardedSecIdx=*/secIdx);
+  return make<Defined>(this, name, STB_LOCAL, eSym.st_other, type,
+                       eSym.st_value, eSym.st_size, sec);
+}
+
+// Local symbols are created lazily from code that may run in parallel with
+// other lookups (e.g. when an error message looks for the enclosing function),
+// so creating one is serialized. Lookups of symbols that already exist only
+// need an atomic load. Relocation targets are created up front by
+// initializeRelocTargetSymbols(), which keeps the lock off the hot paths.
+static std::mutex localSymbolsMutex;
+
+template <class ELFT> Symbol &ObjFile<ELFT>::getLazyLocalSymbol(uint32_t i) {
+  if (Symbol *sym = lazyLocalSymbols[i].load(std::memory_order_acquire))
+    return *sym;
+  std::lock_guard<std::mutex> lock(localSymbolsMutex);
+  Symbol *sym = lazyLocalSymbols[i].load(std::memory_order_relaxed);
+  if (!sym) {
+    sym = createLocalSymbol(i);
+    lazyLocalSymbols[i].store(sym, std::memory_order_release);
+  }
+  return *sym;
+}
+
+template <class ELFT> void ObjFile<ELFT>::initializeLocalSymbols() {
+  std::lock_guard<std::mutex> lock(localSymbolsMutex);
+  if (!this->lazyLocals.load(std::memory_order_relaxed))
+    return;
+  for (uint32_t i = 0; i != firstGlobal; ++i) {
+    Symbol *sym = lazyLocalSymbols[i].load(std::memory_order_relaxed);
+    if (!sym) {
+      sym = createLocalSymbol(i);
+      lazyLocalSymbols[i].store(sym, std::memory_order_release);
+    }
+    this->symbols[i] = sym;
+  }
+  this->lazyLocals.store(false, std::memory_order_release);
+}
+
+template <class ELFT>
+void ObjFile<ELFT>::forEachSymbolIf(
+    function_ref<bool(const InputSectionBase *, uint8_t)> createIf,
+    function_ref<void(Symbol *)> fn) {
+  if (!this->lazyLocals.load(std::memory_order_acquire)) {
+    for (Symbol *sym : this->symbols)
+      fn(sym);
+    return;
+  }
+  ArrayRef<Elf_Sym> eSyms = this->getELFSyms<ELFT>();
+  for (uint32_t i = 0; i != firstGlobal; ++i) {
+    Symbol *sym = lazyLocalSymbols[i].load(std::memory_order_acquire);
+    if (!sym) {
+      const Elf_Sym &eSym = eSyms[i];
+      if (!createIf(this->sections[getSectionIndex(eSym)], eSym.getType()))
+        continue;
+      sym = &getLazyLocalSymbol(i);
+    }
+    fn(sym);
+  }
+  for (Symbol *sym : makeArrayRef(this->symbols).slice(firstGlobal))
+    fn(sym);
+}
+
+template <class ELFT> void ObjFile<ELFT>::initializeRelocTargetSymbols() {
+  if (!this->lazyLocals)
+    return;
+  for (InputSectionBase *sec : this->sections) {
+    if (!sec || sec == &InputSection::discarded || !sec->isLive() ||
+        !sec->numRelocations)
+      continue;
+    if (sec->areRelocsRela) {
+      for (const Elf_Rela &rel : sec->template relas<ELFT>())
+        getRelocTargetSym(rel);
+    } else {
+      for (const Elf_Rel &rel : sec->template rels<ELFT>())
+        getRelocTargetSym(rel);
+    }
+  }
+}
+
+void InputFile::forEachSymbol(
+    function_ref<bool(const InputSectionBase *, uint8_t)> createIf,
+    function_ref<void(Symbol *)> fn) {
+  if (!lazyLocals) {
+    for (Symbol *sym : getMutableSymbols())
+      fn(sym);
+    return;
+  }
+  switch (ekind) {
+  case ELF32LEKind:
+    cast<ObjFile<ELF32LE>>(this)->forEachSymbolIf(createIf, fn);
+    return;
+  case ELF32BEKind:
+    cast<ObjFile<ELF32BE>>(this)->forEachSymbolIf(createIf, fn);
+    return;
+  case ELF64LEKind:
+    cast<ObjFile<ELF64LE>>(this)->forEachSymbolIf(createIf, fn);
+    return;
+  case ELF64BEKind:
+    cast<ObjFile<ELF64BE>>(this)->forEachSymbolIf(createIf, fn);
+    return;
+  default:
+    llvm_unreachable("unknown ELFT");
+  }
+}
+
+void InputFile::materializeLocalSymbols() {
+  switch (ekind) {
+  case ELF32LEKind:
+    cast<ObjFile<ELF32LE>>(this)->initializeLocalSymbols();
+    return;
+  case ELF32BEKind:
+    cast<ObjFile<ELF32BE>>(this)->initializeLocalSymbols();
+    return;
+  case ELF64LEKind:
+    cast<ObjFile<ELF64LE>>(this)->initializeLocalSymbols();
+    return;
+  case ELF64BEKind:
+    cast<ObjFile<ELF64BE>>(this)->initializeLocalSymbols();
+    return;
+  default:
+    llvm_unreachable("unknown ELFT");
+  }
+}
+
 // Initialize this->Symbols. this->Symbols is a parallel array as
 // its corresponding ELF symbol table.
 template <class ELFT> void ObjFile<ELFT>::initializeSymbols() {
   ArrayRef<Elf_Sym> eSyms = this->getELFSyms<ELFT>();
   this->symbols.resize(eSyms.size());
+  bool lazy = !config->copyRelocs && firstGlobal != 0 &&
+              (config->discard == DiscardPolicy::All ||
+               config->strip == StripPolicy::All);
+  if (lazy)
+    lazyLocalSymbols = std::make_unique<std::atomic<Symbol *>[]>(firstGlobal);
 
   // Fill in InputFile::symbols. Some entries have been initialized
   // because of LazyObjFile.
@@ -1105,8 +1363,12 @@ template <class ELFT> void ObjFile<ELFT>::initializeSymbols() {
         error(toString(this) + ": non-local symbol (" + Twine(i) +
               ") found at index < .symtab's sh_info (" + Twine(firstGlobal) +
               ")");
+      StringRef name = CHECK(eSyms[i].getName(this->stringTable), this);
+      size_t hashIdx = i - firstGlobal;
       this->symbols[i] =
-          symtab->insert(CHECK(eSyms[i].getName(this->stringTable), this));
+          i >= firstGlobal && hashIdx < this->globalNameHashes.size()
+              ? symtab->insert(name, this->globalNameHashes[hashIdx])
+              : symtab->insert(name);
       continue;
     }
 
@@ -1118,25 +1380,22 @@ template <class ELFT> void ObjFile<ELFT>::initializeSymbols() {
                   ") found at index >= .symtab's sh_info (" +
                   Twine(firstGlobal) + ")");
 
-    InputSectionBase *sec = this->sections[secIdx];
-    uint8_t type = eSym.getType();
-    if (type == STT_FILE)
+    if (eSym.getType() == STT_FILE)
       sourceFile = CHECK(eSym.getName(this->stringTable), this);
     if (this->stringTable.size() <= eSym.st_name)
       fatal(toString(this) + ": invalid symbol name offset");
-    StringRefZ name = this->stringTable.data() + eSym.st_name;
 
-    if (eSym.st_shndx == SHN_UNDEF)
-      this->symbols[i] =
-          make<Undefined>(this, name, STB_LOCAL, eSym.st_other, type);
-    else if (sec == &InputSection::discarded)
-      this->symbols[i] =
-          make<Undefined>(this, name, STB_LOCAL, eSym.st_other, type,
-                          /*discardedSecIdx=*/secIdx);
-    else
-      this->symbols[i] = make<Defined>(this, name, STB_LOCAL, eSym.st_other,
-                                       type, eSym.st_value, eSym.st_size, sec);
+    // If local symbols are not copied to the output, most of them are never
+    // looked at: relocations usually refer to section symbols instead. Such
+    // symbols are created on first use by getSymbol() or getSymbols().
+    if (lazy && i < firstGlobal)
+      continue;
+    this->symbols[i] = createLocalSymbol(i);
   }
+  // The precomputed hashes are not needed once every global is inserted.
+  std::vector<uint32_t>().swap(this->globalNameHashes);
+  if (lazy)
+    this->lazyLocals = true;
 
   // Symbol resolution of non-local symbols.
   SmallVector<unsigned, 32> undefineds;
@@ -1223,9 +1482,65 @@ ArchiveFile::ArchiveFile(std::unique_ptr<Archive> &&file)
     : InputFile(ArchiveKind, file->getMemoryBufferRef()),
       file(std::move(file)) {}
 
-void ArchiveFile::parse() {
+void ArchiveFile::hashSymbolNames() {
   for (const Archive::Symbol &sym : file->symbols())
-    symtab->addSymbol(LazyArchive{*this, sym});
+    symbolNameHashes.push_back(SymbolTable::hashName(sym.getName()));
+}
+
+// Archive symbols that are undefined in the symbol table at this point fetch
+// their members as soon as parse() adds them. Hash the global symbol names of
+// those members in parallel up front, which also pulls their contents into
+// memory, so that fetch() and parseFile() find them ready.
+void ArchiveFile::prefetchMembers() {
+  // Members of thin archives are read from disk on first access, which is not
+  // thread-safe.
+  if (symbolNameHashes.empty() || file->isThin())
+    return;
+
+  std::vector<std::pair<uint64_t, MemoryBufferRef>> members;
+  DenseSet<uint64_t> queued;
+  size_t i = 0;
+  for (const Archive::Symbol &sym : file->symbols()) {
+    Symbol *s = symtab->find(sym.getName(), symbolNameHashes[i++]);
+    if (!s || !s->isUndefined() || s->isWeak())
+      continue;
+    Expected<Archive::Child> c = sym.getMember();
+    if (!c) {
+      consumeError(c.takeError());
+      continue;
+    }
+    uint64_t offset = c->getChildOffset();
+    if (seen.count(offset) || !queued.insert(offset).second)
+      continue;
+    Expected<MemoryBufferRef> mb = c->getMemoryBufferRef();
+    if (!mb) {
+      consumeError(mb.takeError());
+      continue;
+    }
+    if (identify_magic(mb->getBuffer()) == file_magic::elf_relocatable)
+      members.emplace_back(offset, *mb);
+  }
+
+  std::vector<std::vector<uint32_t>> hashes(members.size());
+  parallelForEachN(0, members.size(), [&](size_t i) {
+    hashes[i] = hashGlobalSymbolNames(members[i].second);
+  });
+  for (size_t i = 0, e = members.size(); i != e; ++i)
+    prefetched[members[i].first] = std::move(hashes[i]);
+}
+
+void ArchiveFile::parse() {
+  prefetchMembers();
+
+  size_t i = 0;
+  for (const Archive::Symbol &sym : file->symbols()) {
+    Symbol *s = i < symbolNameHashes.size()
+                    ? symtab->insert(sym.getName(), symbolNameHashes[i])
+                    : symtab->insert(sym.getName());
+    s->resolve(LazyArchive{*this, sym});
+    ++i;
+  }
+  prefetched.clear();
 
   // Inform a future invocation of ObjFile<ELFT>::initializeSymbols() that this
   // archive has been processed.
@@ -1253,6 +1568,12 @@ void ArchiveFile::fetch(const Archive::Symbol &sym) {
 
   InputFile *file = createObjectFile(mb, getName(), c.getChildOffset());
   file->groupId = groupId;
+  auto it = prefetched.find(c.getChildOffset());
+  if (it != prefetched.end()) {
+    if (auto *f = dyn_cast<ELFFileBase>(file))
+      f->globalNameHashes = std::move(it->second);
+    prefetched.erase(it);
+  }
   parseFile(file);
 }
 
@@ -21,6 +21,7 @@
 #include "llvm/Object/ELF.h"
 #include "llvm/Object/IRObjectFile.h"
 #include "llvm/Support/Threading.h"
+#include <atomic>
 #include <map>
 
 namespace llvm {
@@ -53,6 +54,11 @@ llvm::Optional<MemoryBufferRef> readFile(StringRef path);
 // Add symbols in File to the symbol table.
 void parseFile(InputFile *file);
 
+// Hashes the global symbol names of the given files in parallel and presizes
+// the symbol table, so that the serial parseFile() calls only need to look up
+// precomputed hashes. This does not change the order of symbol resolution.
+void prehashSymbolNames(ArrayRef<InputFile *> files);
+
 // The root class of input files.
 class InputFile {
 public:
@@ -84,8 +90,23 @@ public:
 
   // Returns object file symbols. It is a runtime error to call this
   // function on files of other types.
-  ArrayRef<Symbol *> getSymbols() { return getMutableSymbols(); }
+  ArrayRef<Symbol *> getSymbols() {
+    if (lazyLocals)
+      materializeLocalSymbols();
+    return getMutableSymbols();
+  }
 
+  // Calls fn for each symbol of an object file, in symbol table order. Local
+  // symbols that have not been created yet are created, and passed to fn, only
+  // if createIf accepts the section they are defined in and their ELF type.
+  // This lets a query that only cares about some local symbols avoid creating
+  // all of them.
+  void forEachSymbol(
+      llvm::function_ref<bool(const InputSectionBase *, uint8_t)> createIf,
+      llvm::function_ref<void(Symbol *)> fn);
+
+  // Unlike getSymbols(), this does not create local symbols that have not
+  // been needed yet, so some entries of an object file may be null.
   MutableArrayRef<Symbol *> getMutableSymbols() {
     assert(fileKind == BinaryKind || fileKind == ObjKind ||
            fileKind == BitcodeKind);
@@ -152,7 +173,13 @@ protected:
   InputFile(Kind k, MemoryBufferRef m);
   std::vector<InputSectionBase *> sections;
 
+  // True while the local symbols of this object file are created on first
+  // use. See ObjFile::initializeSymbols().
+  std::atomic<bool> lazyLocals{false};
+
 private:
+  void materializeLocalSymbols();
+
   const Kind fileKind;
 
   // Cache for getNameForScript().
@@ -170,6 +197,11 @@ public:
 
   StringRef getStringTable() const { return stringTable; }
 
+  // SymbolTable::hashName() of each global symbol name, if computed in
+  // advance by prehashSymbolNames() or an archive prefetch. Released by
+  // initializeSymbols().
+  std::vector<uint32_t> globalNameHashes;
+
   template <typename ELFT> typename ELFT::SymRange getELFSyms() const {
     return typename ELFT::SymRange(
         reinterpret_cast<const typename ELFT::Sym *>(elfSyms), numELFSyms);
@@ -214,9 +246,24 @@ public:
   Symbol &getSymbol(uint32_t symbolIndex) const {
     if (symbolIndex >= this->symbols.size())
       fatal(toString(this) + ": invalid symbol index");
+    if (symbolIndex < this->firstGlobal &&
+        this->lazyLocals.load(std::memory_order_acquire))
+      return const_cast<ObjFile *>(this)->getLazyLocalSymbol(symbolIndex);
     return *this->symbols[symbolIndex];
   }
 
+  // Creates the local symbols that have not been created yet.
+  void initializeLocalSymbols();
+
+  // See InputFile::forEachSymbol().
+  void forEachSymbolIf(
+      llvm::function_ref<bool(const InputSectionBase *, uint8_t)> createIf,
+      llvm::function_ref<void(Symbol *)> fn);
+
+  // Creates the local symbols that relocations of live sections refer to, so
+  // that passes that run in parallel never need to create one.
+  void initializeRelocTargetSymbols();
+
   uint32_t getSectionIndex(const Elf_Sym &sym) const;
 
   template <typename RelT> Symbol &getRelocTargetSym(const RelT &rel) const {
@@ -260,6 +307,8 @@ private:
   void initializeSections(bool ignoreComdats);
   void initializeSymbols();
   void initializeJustSymbols();
+  Symbol *createLocalSymbol(uint32_t i);
+  Symbol &getLazyLocalSymbol(uint32_t i);
 
   InputSectionBase *getRelocTarget(const Elf_Shdr &sec);
   InputSectionBase *createInputSection(const Elf_Shdr &sec);
@@ -284,6 +333,11 @@ private:
   // .shstrtab contents.
   StringRef sectionStringTable;
 
+  // While lazyLocals is set, local symbols live here rather than in
+  // this->symbols, so that they can be created by one thread while others
+  // look them up. initializeLocalSymbols() copies them to this->symbols.
+  std::unique_ptr<std::atomic<Symbol *>[]> lazyLocalSymbols;
+
   // Debugging information to retrieve source file and line for error
   // reporting. Linker may find reasonable number of errors in a
   // single object file, so we cache debugging information in order to
@@ -344,9 +398,22 @@ public:
 
   bool parsed = false;
 
+  // Computes symbolNameHashes. This is thread-safe.
+  void hashSymbolNames();
+
+  // SymbolTable::hashName() of each archive symbol table entry, if computed
+  // in advance by prehashSymbolNames().
+  std::vector<uint32_t> symbolNameHashes;
+
 private:
+  void prefetchMembers();
+
   std::unique_ptr<Archive> file;
   llvm::DenseSet<uint64_t> seen;
+
+  // Global symbol name hashes of the members that parse() is about to fetch,
+  // computed in parallel by prefetchMembers() and keyed by member offset.
+  llvm::DenseMap<uint64_t, std::vector<uint32_t>> prefetched;
 };
 
 class BitcodeFile : public InputFile {
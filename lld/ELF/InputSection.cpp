@@ -81,14 +81,11 @@ InputSectionBase::InputSectionBase(InputFile *file, uint64_t flags,
     fatal(toString(this) + ": sh_addralign is not a power of 2");
   this->alignment = v;
 
-  // In ELF, each section can be compressed by zlib, and if compressed,
-  // section name may be mangled by appending "z" (e.g. ".zdebug_info").
-  // If that's the case, demangle section name so that we can handle a
-  // section as if it weren't compressed.
+  // In ELF, each section can be compressed by zlib or zstd, and if
+  // compressed by zlib, section name may be mangled by appending "z" (e.g.
+  // ".zdebug_info"). If that's the case, demangle section name so that we can
+  // handle a section as if it weren't compressed.
   if ((flags & SHF_COMPRESSED) || name.startswith(".zdebug")) {
-    if (!zlib::isAvailable())
-      error(toString(file) + ": contains a compressed section, " +
-            "but zlib is not available");
     switch (config->ekind) {
     case ELF32LEKind:
       parseCompressedHeader<ELF32LE>();
@@ -168,7 +165,11 @@ void InputSectionBase::uncompress() const {
     uncompressedBuf = bAlloc.Allocate<char>(size);
   }
 
-  if (Error e = zlib::uncompress(toStringRef(rawData), uncompressedBuf, size))
+  if (Error e = compressedWithZstd
+                    ? zstd::uncompress(toStringRef(rawData), uncompressedBuf,
+                                       size)
+                    : zlib::uncompress(toStringRef(rawData), uncompressedBuf,
+                                       size))
     fatal(toString(this) +
           ": uncompress failed: " + llvm::toString(std::move(e)));
   rawData = makeArrayRef((uint8_t *)uncompressedBuf, size);
@@ -224,7 +225,7 @@ OutputSection *SectionBase::getOutputSection() {
 }
 
 // When a section is compressed, `rawData` consists with a header followed
-// by zlib-compressed data. This function parses a header to initialize
+// by zlib- or zstd-compressed data. This function parses a header to initialize
 // `uncompressedSize` member and remove the header from `rawData`.
 template <typename ELFT> void InputSectionBase::parseCompressedHeader() {
   // Old-style header
@@ -240,6 +241,11 @@ template <typename ELFT> void InputSectionBase::parseCompressedHeader() {
       return;
     }
 
+    if (!zlib::isAvailable()) {
+      error(toString(this) + ": contains a compressed section, " +
+            "but zlib is not available");
+      return;
+    }
     uncompressedSize = read64be(rawData.data());
     rawData = rawData.slice(8);
 
@@ -259,7 +265,20 @@ template <typename ELFT> void InputSectionBase::parseCompressedHeader() {
   }
 
   auto *hdr = reinterpret_cast<const typename ELFT::Chdr *>(rawData.data());
-  if (hdr->ch_type != ELFCOMPRESS_ZLIB) {
+  if (hdr->ch_type == ELFCOMPRESS_ZSTD) {
+    if (!zstd::isAvailable()) {
+      error(toString(this) + ": contains a compressed section, " +
+            "but zstd is not available");
+      return;
+    }
+    compressedWithZstd = true;
+  } else if (hdr->ch_type == ELFCOMPRESS_ZLIB) {
+    if (!zlib::isAvailable()) {
+      error(toString(this) + ": contains a compressed section, " +
+            "but zlib is not available");
+      return;
+    }
+  } else {
     error(toString(this) + ": unsupported compression type");
     return;
   }
@@ -1366,8 +1385,10 @@ template <class ELFT> void InputSection::writeTo(uint8_t *buf) {
   // to the buffer.
   if (uncompressedSize >= 0) {
     size_t size = uncompressedSize;
-    if (Error e = zlib::uncompress(toStringRef(rawData),
-                                   (char *)(buf + outSecOff), size))
+    StringRef in = toStringRef(rawData);
+    char *out = (char *)(buf + outSecOff);
+    if (Error e = compressedWithZstd ? zstd::uncompress(in, out, size)
+                                     : zlib::uncompress(in, out, size))
       fatal(toString(this) +
             ": uncompress failed: " + llvm::toString(std::move(e)));
     uint8_t *bufEnd = buf + outSecOff + size;
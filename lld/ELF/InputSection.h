@@ -141,6 +141,10 @@ public:
   // deleteFallThruJmpInsn.
   bool nopFiller = false;
 
+  // Whether rawData is compressed with zstd rather than zlib. Only meaningful
+  // while uncompressedSize >= 0.
+  bool compressedWithZstd = false;
+
   void drop_back(uint64_t num) { bytesDropped += num; }
 
   void push_back(uint64_t num) {
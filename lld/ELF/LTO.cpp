@@ -17,6 +17,7 @@
 #include "lld/Common/TargetOptionsCommandFlags.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/BinaryFormat/ELF.h"
@@ -31,6 +32,8 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cstddef>
 #include <memory>
@@ -240,11 +243,16 @@ void BitcodeCompiler::add(BitcodeFile &f) {
 
     // We ask LTO to preserve following global symbols:
     // 1) All symbols when doing relocatable link, so that them can be used
-    //    for doing final link.
+    //    for doing final link. A compartment link is relocatable, but only the
+    //    compartment's entry points remain global in its output (see
+    //    SymbolTableBaseSection::addSymbol), so everything else is internalized.
     // 2) Symbols that are used in regular objects.
     // 3) C named sections if we have corresponding __start_/__stop_ symbol.
     // 4) Symbols that are defined in bitcode files and used for dynamic linking.
-    r.VisibleToRegularObj = config->relocatable || sym->isUsedInRegularObj ||
+    bool preserveForRelocatable =
+        config->compartment ? objSym.isCompartmentEntry()
+                            : config->relocatable;
+    r.VisibleToRegularObj = preserveForRelocatable || sym->isUsedInRegularObj ||
                             (r.Prevailing && sym->includeInDynsym()) ||
                             usedStartStop.count(objSym.getSectionName());
     // Identify symbols exported dynamically, and that therefore could be
@@ -294,6 +302,24 @@ static void thinLTOCreateEmptyIndexFiles() {
   }
 }
 
+// Each compartment is linked separately, so give each one its own cache
+// directory, named after the output file. This keeps one compartment's cache
+// pruning from evicting the objects of the others, so that an unchanged
+// compartment always finds its objects in the cache. Compartments in different
+// directories may have the same file name, so the name also includes a hash of
+// the absolute path of the output.
+static std::string getThinLTOCacheDir() {
+  if (config->thinLTOCacheDir.empty() || !config->compartment)
+    return std::string(config->thinLTOCacheDir);
+  SmallString<128> output(config->outputFile);
+  sys::fs::make_absolute(output);
+  sys::path::remove_dots(output, /*remove_dot_dot=*/true);
+  SmallString<128> path(config->thinLTOCacheDir);
+  sys::path::append(path, sys::path::filename(output) + "-" +
+                              utohexstr(xxHash64(output.str())));
+  return std::string(path.str());
+}
+
 // Merge all the bitcode files we have seen, codegen the result
 // and return the resulting ObjectFile(s).
 std::vector<InputFile *> BitcodeCompiler::compile() {
@@ -305,9 +331,10 @@ std::vector<InputFile *> BitcodeCompiler::compile() {
   // to cache native object files for ThinLTO incremental builds. If a path was
   // specified, configure LTO to use it as the cache directory.
   lto::NativeObjectCache cache;
-  if (!config->thinLTOCacheDir.empty())
+  std::string cacheDir = getThinLTOCacheDir();
+  if (!cacheDir.empty())
     cache = check(
-        lto::localCache(config->thinLTOCacheDir,
+        lto::localCache(cacheDir,
                         [&](size_t task, std::unique_ptr<MemoryBuffer> mb) {
                           files[task] = std::move(mb);
                         }));
@@ -344,8 +371,8 @@ std::vector<InputFile *> BitcodeCompiler::compile() {
     return {};
   }
 
-  if (!config->thinLTOCacheDir.empty())
-    pruneCache(config->thinLTOCacheDir, config->thinLTOCachePolicy);
+  if (!cacheDir.empty())
+    pruneCache(cacheDir, config->thinLTOCachePolicy);
 
   if (!config->ltoObjPath.empty()) {
     saveBuffer(buf[0], config->ltoObjPath);
@@ -12,6 +12,7 @@
 
 #include "LinkerScript.h"
 #include "Config.h"
+#include "Incremental.h"
 #include "InputSection.h"
 #include "OutputSections.h"
 #include "SymbolTable.h"
@@ -871,6 +872,10 @@ void LinkerScript::output(InputSection *s) {
   uint64_t pos = advance(s->getSize(), s->alignment);
   s->outSecOff = pos - s->getSize() - ctx->outSec->addr;
 
+  // With --incremental, leave room for the section to grow in later links.
+  if (uint64_t slack = getIncrementalSlack(s))
+    pos = advance(slack, 1);
+
   // Update output section size after adding each section. This is so that
   // SIZEOF works correctly in the case below:
   // .foo { *(.aaa) a = SIZEOF(.foo); *(.bbb) }
@@ -899,7 +904,7 @@ static uint64_t outputSectionCheriAlignment(OutputSection *sec)
     // Add two alignment to the size, one for unaligned start one for unaligned
     // end which is the worst case scenario.
     for (InputSection *s : cast<InputSectionDescription>(base)->sections) {
-      total += s->getSize() + 2 * s->alignment;
+      total += s->getSize() + getIncrementalSlack(s) + 2 * s->alignment;
     }
   }
 
@@ -283,32 +283,71 @@ template <class ELFT> void OutputSection::maybeCompress() {
   using Elf_Chdr = typename ELFT::Chdr;
 
   // Compress only DWARF debug sections.
-  if (!config->compressDebugSections || (flags & SHF_ALLOC) ||
-      !name.startswith(".debug_"))
+  if (config->compressDebugSections == DebugCompressionKind::None ||
+      (flags & SHF_ALLOC) || !name.startswith(".debug_"))
     return;
 
   llvm::TimeTraceScope timeScope("Compress debug sections");
+  bool isZstd = config->compressDebugSections == DebugCompressionKind::Zstd;
 
   // Create a section header.
   zDebugHeader.resize(sizeof(Elf_Chdr));
   auto *hdr = reinterpret_cast<Elf_Chdr *>(zDebugHeader.data());
-  hdr->ch_type = ELFCOMPRESS_ZLIB;
+  hdr->ch_type = isZstd ? ELFCOMPRESS_ZSTD : ELFCOMPRESS_ZLIB;
   hdr->ch_size = size;
   hdr->ch_addralign = alignment;
 
   // Write section contents to a temporary buffer and compress it.
   std::vector<uint8_t> buf(size);
   writeTo<ELFT>(buf.data());
-  // We chose 1 as the default compression level because it is the fastest. If
-  // -O2 is given, we use level 6 to compress debug info more by ~15%. We found
-  // that level 7 to 9 doesn't make much difference (~1% more compression) while
-  // they take significant amount of time (~2x), so level 6 seems enough.
-  if (Error e = zlib::compress(toStringRef(buf), compressedData,
-                               config->optimize >= 2 ? 6 : 1))
-    fatal("compress failed: " + llvm::toString(std::move(e)));
+
+  // Split the contents into shards and compress them in parallel. A zlib
+  // shard is a piece of a raw deflate stream that ends on a byte boundary, so
+  // the shards concatenate into one deflate stream; we wrap it with a zlib
+  // header and the combined adler32 checksum. zstd shards are independent
+  // frames, which decompressors handle in sequence.
+  //
+  // We chose 1 as the default zlib compression level because it is the
+  // fastest. If -O2 is given, we use level 6 to compress debug info more by
+  // ~15%. We found that level 7 to 9 doesn't make much difference (~1% more
+  // compression) while they take significant amount of time (~2x), so level 6
+  // seems enough.
+  constexpr size_t shardSize = 1 << 20;
+  int level = isZstd ? (config->optimize >= 2 ? zstd::DefaultCompression
+                                              : zstd::BestSpeedCompression)
+                     : (config->optimize >= 2 ? 6 : 1);
+  StringRef input = toStringRef(buf);
+  size_t numShards = std::max<size_t>(1, divideCeil(input.size(), shardSize));
+  compressedShards.resize(numShards);
+  std::vector<uint32_t> checksums(numShards);
+  parallelForEachN(0, numShards, [&](size_t i) {
+    StringRef shard = input.substr(i * shardSize, shardSize);
+    Error e = isZstd ? zstd::compress(shard, compressedShards[i], level)
+                     : zlib::compressChunk(shard, compressedShards[i], level,
+                                           /*IsLast=*/i == numShards - 1);
+    if (e)
+      fatal("compress failed: " + llvm::toString(std::move(e)));
+    if (!isZstd)
+      checksums[i] = zlib::adler32(shard);
+  });
+
+  if (!isZstd) {
+    // CMF 0x78 (deflate, 32K window) and FLG 0x01 (no dictionary, fastest).
+    zDebugHeader.push_back(0x78);
+    zDebugHeader.push_back(0x01);
+    uint32_t checksum = checksums[0];
+    for (size_t i = 1; i != numShards; ++i)
+      checksum = zlib::adler32Combine(
+          checksum, checksums[i], input.substr(i * shardSize, shardSize).size());
+    SmallVector<char, 0> &last = compressedShards.back();
+    last.resize(last.size() + 4);
+    write32be(last.data() + last.size() - 4, checksum);
+  }
 
   // Update section headers.
-  size = sizeof(Elf_Chdr) + compressedData.size();
+  size = zDebugHeader.size();
+  for (const SmallVector<char, 0> &shard : compressedShards)
+    size += shard.size();
   flags |= SHF_COMPRESSED;
 }
 
@@ -332,10 +371,18 @@ template <class ELFT> void OutputSection::writeTo(uint8_t *buf) {
   // If -compress-debug-section is specified and if this is a debug section,
   // we've already compressed section contents. If that's the case,
   // just write it down.
-  if (!compressedData.empty()) {
+  if (!compressedShards.empty()) {
     memcpy(buf, zDebugHeader.data(), zDebugHeader.size());
-    memcpy(buf + zDebugHeader.size(), compressedData.data(),
-           compressedData.size());
+    std::vector<size_t> offsets(compressedShards.size());
+    size_t offset = zDebugHeader.size();
+    for (size_t i = 0, e = compressedShards.size(); i != e; ++i) {
+      offsets[i] = offset;
+      offset += compressedShards[i].size();
+    }
+    parallelForEachN(0, compressedShards.size(), [&](size_t i) {
+      memcpy(buf + offsets[i], compressedShards[i].data(),
+             compressedShards[i].size());
+    });
     return;
   }
 
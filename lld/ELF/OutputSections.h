@@ -114,12 +114,14 @@ public:
   void sortInitFini();
   void sortCtorsDtors();
 
+  std::array<uint8_t, 4> getFiller();
+
 private:
-  // Used for implementation of --compress-debug-sections option.
+  // Used for implementation of --compress-debug-sections option. The
+  // compressed contents are split into shards that are compressed in
+  // parallel and written out back to back after zDebugHeader.
   std::vector<uint8_t> zDebugHeader;
-  llvm::SmallVector<char, 0> compressedData;
-
-  std::array<uint8_t, 4> getFiller();
+  std::vector<llvm::SmallVector<char, 0>> compressedShards;
 };
 
 int getPriority(StringRef s);
@@ -93,19 +93,38 @@ void SymbolTable::wrap(Symbol *sym, Symbol *real, Symbol *wrap) {
   real->isUsedInRegularObj = false;
 }
 
-// Find an existing symbol or create a new one.
-Symbol *SymbolTable::insert(StringRef name) {
-  // <name>@@<version> means the symbol is the default version. In that
-  // case <name>@@<version> will be used to resolve references to <name>.
-  //
+// <name>@@<version> means the symbol is the default version. In that
+// case <name>@@<version> will be used to resolve references to <name>.
+static StringRef stripDefaultVersion(StringRef name) {
   // Since this is a hot path, the following string search code is
   // optimized for speed. StringRef::find(char) is much faster than
   // StringRef::find(StringRef).
   size_t pos = name.find('@');
   if (pos != StringRef::npos && pos + 1 < name.size() && name[pos + 1] == '@')
-    name = name.take_front(pos);
+    return name.take_front(pos);
+  return name;
+}
+
+uint32_t SymbolTable::hashName(StringRef name) {
+  return CachedHashStringRef(stripDefaultVersion(name)).hash();
+}
+
+void SymbolTable::reserve(size_t numSymbols) {
+  symMap.reserve(numSymbols);
+  symVector.reserve(numSymbols);
+}
+
+// Find an existing symbol or create a new one.
+Symbol *SymbolTable::insert(StringRef name) {
+  return insert(CachedHashStringRef(stripDefaultVersion(name)));
+}
 
-  auto p = symMap.insert({CachedHashStringRef(name), (int)symVector.size()});
+Symbol *SymbolTable::insert(StringRef name, uint32_t hash) {
+  return insert(CachedHashStringRef(stripDefaultVersion(name), hash));
+}
+
+Symbol *SymbolTable::insert(CachedHashStringRef key) {
+  auto p = symMap.insert({key, (int)symVector.size()});
   int &symIndex = p.first->second;
   bool isNew = p.second;
 
@@ -117,7 +136,7 @@ Symbol *SymbolTable::insert(StringRef name) {
 
   // *sym was not initialized by a constructor. Fields that may get referenced
   // when it is a placeholder must be initialized here.
-  sym->setName(name);
+  sym->setName(key.val());
   sym->symbolKind = Symbol::PlaceholderKind;
   sym->versionId = VER_NDX_GLOBAL;
   sym->visibility = STV_DEFAULT;
@@ -148,6 +167,16 @@ Symbol *SymbolTable::find(StringRef name) {
   return sym;
 }
 
+Symbol *SymbolTable::find(StringRef name, uint32_t hash) {
+  auto it = symMap.find(CachedHashStringRef(stripDefaultVersion(name), hash));
+  if (it == symMap.end())
+    return nullptr;
+  Symbol *sym = symVector[it->second];
+  if (sym->isPlaceholder())
+    return nullptr;
+  return sym;
+}
+
 // A version script/dynamic list is only meaningful for a Defined symbol.
 // A CommonSymbol will be converted to a Defined in replaceCommonSymbols().
 // A lazy symbol may be made Defined if an LTO libcall fetches it.
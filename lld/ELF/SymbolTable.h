@@ -47,12 +47,27 @@ public:
 
   Symbol *insert(StringRef name);
 
+  // Same as insert(name), but with the hash of the name computed in advance
+  // by hashName(). See prehashSymbolNames().
+  Symbol *insert(StringRef name, uint32_t hash);
+
   Symbol *addSymbol(const Symbol &newSym);
 
   void scanVersionScript();
 
   Symbol *find(StringRef name);
 
+  // Like insert(name, hash), this looks up <name> for <name>@@<version>, but
+  // it does not create a symbol if there is none.
+  Symbol *find(StringRef name, uint32_t hash);
+
+  // Returns the hash of the key under which insert() stores a symbol name.
+  // This is thread-safe.
+  static uint32_t hashName(StringRef name);
+
+  // Reserves space for the given number of distinct symbol names.
+  void reserve(size_t numSymbols);
+
   void handleDynamicList();
 
   // Set of .so files to not link the same shared object file more than once.
@@ -70,6 +85,8 @@ public:
   std::vector<Symbol*> &getSymbols() { return symVector; }
 
 private:
+  Symbol *insert(llvm::CachedHashStringRef key);
+
   std::vector<Symbol *> findByVersion(SymbolVersion ver);
   std::vector<Symbol *> findAllByVersion(SymbolVersion ver);
 
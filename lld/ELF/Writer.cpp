@@ -31,6 +31,7 @@
 #include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/SHA256.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/xxhash.h"
 #include <climits>
@@ -46,6 +47,37 @@ using namespace lld;
 using namespace lld::elf;
 
 namespace {
+using HashFn = std::function<void(uint8_t *dest, ArrayRef<uint8_t> arr)>;
+
+// Computes the --build-id hash the same way as computeHash(), but hashes each
+// chunk of the output as soon as every output section overlapping it has been
+// written. This overlaps most of the hashing with writing the rest of the
+// output, leaving only the hash of the chunk hashes for the end of the link.
+class StreamingHasher {
+public:
+  StreamingHasher(ArrayRef<uint8_t> data, size_t hashSize, HashFn hashFn);
+
+  // Registers an output section that has yet to be written. If writtenBy is
+  // non-null, sec's contents are filled in while writing writtenBy instead.
+  void addPending(OutputSection *sec, OutputSection *writtenBy = nullptr);
+  // Starts hashing the chunks that no pending section overlaps.
+  void start();
+  void markWritten(OutputSection *sec);
+  void finish(MutableArrayRef<uint8_t> hashBuf);
+
+private:
+  void hashChunk(size_t i);
+  void release(OutputSection *sec);
+
+  ArrayRef<uint8_t> data;
+  size_t hashSize;
+  HashFn hashFn;
+  std::vector<unsigned> pendingWrites;
+  std::vector<uint8_t> hashes;
+  DenseMap<OutputSection *, SmallVector<OutputSection *, 1>> writtenBy;
+  ThreadPool pool;
+};
+
 // The writer writes a SymbolTable result to a file.
 template <class ELFT> class Writer {
 public:
@@ -82,8 +114,10 @@ private:
   void writeSections();
   void writeSectionsBinary();
   void writeBuildId();
+  void startBuildIdHasher();
 
   std::unique_ptr<FileOutputBuffer> &buffer;
+  std::unique_ptr<StreamingHasher> buildIdHasher;
 
   void addRelIpltSymbols();
   void addStartEndSymbols();
@@ -816,6 +850,10 @@ static bool includeInSymtab(const Symbol &b) {
 template <class ELFT> void Writer<ELFT>::copyLocalSymbols() {
   if (!in.symTab)
     return;
+  // With --discard-all, no local symbol is kept (see shouldKeepInSymtab()).
+  // Don't create the ones that were never needed just to drop them.
+  if (config->discard == DiscardPolicy::All && !config->copyRelocs)
+    return;
   llvm::TimeTraceScope timeScope("Add local symbols");
   if (config->copyRelocs && config->discard != DiscardPolicy::None)
     markUsedLocalSymbols<ELFT>();
@@ -1768,6 +1806,57 @@ static void finalizeSynthetic(SyntheticSection *sec) {
   }
 }
 
+namespace {
+// Finalizes a set of synthetic sections, running the ones that do not depend
+// on each other in parallel. Sections are grouped into waves: a section runs
+// in a later wave than the sections it depends on, and than any earlier
+// section in the same output section, because finalizeContents() sets the
+// sh_link, sh_info and flags of the parent.
+class SyntheticFinalizer {
+public:
+  // Adds sec, to be finalized after the sections with the given handles.
+  // Returns a handle for sec.
+  size_t add(SyntheticSection *sec, ArrayRef<size_t> deps = {}) {
+    unsigned wave = 0;
+    for (size_t dep : deps)
+      wave = std::max(wave, nodes[dep].wave + 1);
+    if (sec && sec->getParent())
+      for (const Node &node : nodes)
+        if (node.sec && node.sec->getParent() == sec->getParent())
+          wave = std::max(wave, node.wave + 1);
+    nodes.push_back({sec, wave});
+    numWaves = std::max(numWaves, wave + 1);
+    return nodes.size() - 1;
+  }
+
+  // Adds sec, to be finalized after every section added so far.
+  size_t addLast(SyntheticSection *sec) {
+    nodes.push_back({sec, numWaves});
+    return nodes.size() - 1;
+  }
+
+  void run() {
+    for (const Node &node : nodes)
+      numWaves = std::max(numWaves, node.wave + 1);
+    for (unsigned wave = 0; wave != numWaves; ++wave) {
+      SmallVector<SyntheticSection *, 16> secs;
+      for (const Node &node : nodes)
+        if (node.wave == wave)
+          secs.push_back(node.sec);
+      parallelForEach(secs, finalizeSynthetic);
+    }
+  }
+
+private:
+  struct Node {
+    SyntheticSection *sec;
+    unsigned wave;
+  };
+  std::vector<Node> nodes;
+  unsigned numWaves = 0;
+};
+} // namespace
+
 // We need to generate and finalize the content that depends on the address of
 // InputSections. As the generation of the content may also alter InputSection
 // addresses we must converge to a fixed point. We do that here. See the comment
@@ -2277,36 +2366,42 @@ template <class ELFT> void Writer<ELFT>::finalizeSections() {
   {
     llvm::TimeTraceScope timeScope("Finalize synthetic sections");
 
-    finalizeSynthetic(in.bss);
-    finalizeSynthetic(in.bssRelRo);
-    finalizeSynthetic(in.symTabShndx);
-    finalizeSynthetic(in.shStrTab);
-    finalizeSynthetic(in.strTab);
-    finalizeSynthetic(in.got);
-    finalizeSynthetic(in.mipsGot);
-    finalizeSynthetic(in.igotPlt);
-    finalizeSynthetic(in.gotPlt);
-    finalizeSynthetic(in.relaIplt);
-    finalizeSynthetic(in.relaPlt);
-    finalizeSynthetic(in.plt);
-    finalizeSynthetic(in.iplt);
-    finalizeSynthetic(in.ppc32Got2);
-    finalizeSynthetic(in.partIndex);
-
-    // Dynamic section must be the last one in this list and dynamic
-    // symbol table section (dynSymTab) must be the first one.
+    SyntheticFinalizer finalizer;
+    finalizer.add(in.bss);
+    finalizer.add(in.bssRelRo);
+    finalizer.add(in.symTabShndx);
+    finalizer.add(in.shStrTab);
+    finalizer.add(in.strTab);
+    finalizer.add(in.got);
+    finalizer.add(in.mipsGot);
+    finalizer.add(in.igotPlt);
+    finalizer.add(in.gotPlt);
+    finalizer.add(in.relaIplt);
+    finalizer.add(in.relaPlt);
+    finalizer.add(in.plt);
+    finalizer.add(in.iplt);
+    finalizer.add(in.ppc32Got2);
+    size_t partIndex = finalizer.add(in.partIndex);
+
+    // .gnu.hash, .hash and .gnu.version depend on the order of the dynamic
+    // symbol table section (dynSymTab). Strings are added to .dynstr in a
+    // fixed order so that the output is deterministic. Dynamic section must
+    // be the last one.
     for (Partition &part : partitions) {
-      finalizeSynthetic(part.dynSymTab);
-      finalizeSynthetic(part.gnuHashTab);
-      finalizeSynthetic(part.hashTab);
-      finalizeSynthetic(part.verDef);
-      finalizeSynthetic(part.relaDyn);
-      finalizeSynthetic(part.relrDyn);
-      finalizeSynthetic(part.ehFrameHdr);
-      finalizeSynthetic(part.verSym);
-      finalizeSynthetic(part.verNeed);
-      finalizeSynthetic(part.dynamic);
+      size_t dynSymTab = finalizer.add(part.dynSymTab);
+      finalizer.add(part.gnuHashTab, {dynSymTab});
+      finalizer.add(part.hashTab, {dynSymTab});
+      size_t verDef = &part == mainPart ? finalizer.add(part.verDef, {partIndex})
+                                        : finalizer.add(part.verDef);
+      finalizer.add(part.relaDyn);
+      finalizer.add(part.relrDyn);
+      finalizer.add(part.ehFrameHdr);
+      finalizer.add(part.verSym, {dynSymTab});
+      finalizer.add(part.verNeed, {verDef});
     }
+    for (Partition &part : partitions)
+      finalizer.addLast(part.dynamic);
+    finalizer.run();
   }
 
   if (!script->hasSectionsCommand && !config->relocatable)
@@ -3695,9 +3790,16 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
     if (sec->type == SHT_REL || sec->type == SHT_RELA)
       sec->writeTo<ELFT>(Out::bufferStart + sec->offset);
 
-  for (OutputSection *sec : outputSections)
-    if (sec->type != SHT_REL && sec->type != SHT_RELA)
+  if (config->streamOutput)
+    startBuildIdHasher();
+
+  for (OutputSection *sec : outputSections) {
+    if (sec->type != SHT_REL && sec->type != SHT_RELA) {
       sec->writeTo<ELFT>(Out::bufferStart + sec->offset);
+      if (buildIdHasher)
+        buildIdHasher->markWritten(sec);
+    }
+  }
 
   // Write a compartment report, if requested.
   CompartmentReportWriter{config->outputFile, Out::bufferStart,
@@ -3711,15 +3813,15 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
   }
 }
 
+static const size_t hashChunkSize = 1024 * 1024;
+
 // Computes a hash value of Data using a given hash function.
 // In order to utilize multiple cores, we first split data into 1MB
 // chunks, compute a hash for each chunk, and then compute a hash value
 // of the hash values.
-static void
-computeHash(llvm::MutableArrayRef<uint8_t> hashBuf,
-            llvm::ArrayRef<uint8_t> data,
-            std::function<void(uint8_t *dest, ArrayRef<uint8_t> arr)> hashFn) {
-  std::vector<ArrayRef<uint8_t>> chunks = split(data, 1024 * 1024);
+static void computeHash(llvm::MutableArrayRef<uint8_t> hashBuf,
+                        llvm::ArrayRef<uint8_t> data, HashFn hashFn) {
+  std::vector<ArrayRef<uint8_t>> chunks = split(data, hashChunkSize);
   std::vector<uint8_t> hashes(chunks.size() * hashBuf.size());
 
   // Compute hash values.
@@ -3731,6 +3833,108 @@ computeHash(llvm::MutableArrayRef<uint8_t> hashBuf,
   hashFn(hashBuf.data(), hashes);
 }
 
+StreamingHasher::StreamingHasher(ArrayRef<uint8_t> data, size_t hashSize,
+                                 HashFn hashFn)
+    : data(data), hashSize(hashSize), hashFn(std::move(hashFn)),
+      pendingWrites(divideCeil(data.size(), hashChunkSize)),
+      hashes(pendingWrites.size() * hashSize), pool(parallel::strategy) {}
+
+void StreamingHasher::addPending(OutputSection *sec, OutputSection *by) {
+  if (sec->type == SHT_NOBITS || sec->size == 0)
+    return;
+  for (size_t i = sec->offset / hashChunkSize,
+              e = (sec->offset + sec->size - 1) / hashChunkSize;
+       i <= e; ++i)
+    ++pendingWrites[i];
+  writtenBy[by ? by : sec].push_back(sec);
+}
+
+void StreamingHasher::hashChunk(size_t i) {
+  pool.async([=] {
+    hashFn(hashes.data() + i * hashSize,
+           data.slice(i * hashChunkSize).take_front(hashChunkSize));
+  });
+}
+
+void StreamingHasher::start() {
+  for (size_t i = 0, e = pendingWrites.size(); i != e; ++i)
+    if (pendingWrites[i] == 0)
+      hashChunk(i);
+}
+
+void StreamingHasher::release(OutputSection *sec) {
+  if (sec->type == SHT_NOBITS || sec->size == 0)
+    return;
+  for (size_t i = sec->offset / hashChunkSize,
+              e = (sec->offset + sec->size - 1) / hashChunkSize;
+       i <= e; ++i)
+    if (--pendingWrites[i] == 0)
+      hashChunk(i);
+}
+
+void StreamingHasher::markWritten(OutputSection *sec) {
+  auto it = writtenBy.find(sec);
+  if (it == writtenBy.end())
+    return;
+  for (OutputSection *written : it->second)
+    release(written);
+  writtenBy.erase(it);
+}
+
+void StreamingHasher::finish(MutableArrayRef<uint8_t> hashBuf) {
+  pool.wait();
+  assert(writtenBy.empty() && "output sections left unwritten");
+  hashFn(hashBuf.data(), hashes);
+}
+
+static HashFn getBuildIdHashFn(size_t hashSize) {
+  switch (config->buildId) {
+  case BuildIdKind::Fast:
+    return [](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      write64le(dest, xxHash64(arr));
+    };
+  case BuildIdKind::Md5:
+    return [=](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      memcpy(dest, MD5::hash(arr).data(), hashSize);
+    };
+  case BuildIdKind::Sha1:
+    return [=](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      memcpy(dest, SHA1::hash(arr).data(), hashSize);
+    };
+  default:
+    return nullptr;
+  }
+}
+
+// With --stream-output, the chunks of the output file are hashed for
+// --build-id while the remaining output sections are still being written.
+// This must be called after the headers and any relocation sections have been
+// written, as those are not tracked.
+template <class ELFT> void Writer<ELFT>::startBuildIdHasher() {
+  if (!mainPart->buildId || !mainPart->buildId->getParent())
+    return;
+  size_t hashSize = mainPart->buildId->hashSize;
+  HashFn hashFn = getBuildIdHashFn(hashSize);
+  if (!hashFn)
+    return;
+
+  buildIdHasher = std::make_unique<StreamingHasher>(
+      ArrayRef<uint8_t>(Out::bufferStart, size_t(fileSize)), hashSize,
+      std::move(hashFn));
+  for (OutputSection *sec : outputSections)
+    if (sec->type != SHT_REL && sec->type != SHT_RELA)
+      buildIdHasher->addPending(sec);
+
+  // .eh_frame_hdr is written as part of .eh_frame (see
+  // EhFrameHeader::writeTo), so it is not complete until .eh_frame is.
+  for (Partition &part : partitions)
+    if (part.ehFrameHdr && part.ehFrameHdr->getParent() &&
+        part.ehFrame->getParent())
+      buildIdHasher->addPending(part.ehFrameHdr->getParent(),
+                                part.ehFrame->getParent());
+  buildIdHasher->start();
+}
+
 template <class ELFT> void Writer<ELFT>::writeBuildId() {
   if (!mainPart->buildId || !mainPart->buildId->getParent())
     return;
@@ -3742,35 +3946,30 @@ template <class ELFT> void Writer<ELFT>::writeBuildId() {
   }
 
   // Compute a hash of all sections of the output file.
-  size_t hashSize = mainPart->buildId->hashSize;
-  std::vector<uint8_t> buildId(hashSize);
-  llvm::ArrayRef<uint8_t> buf{Out::bufferStart, size_t(fileSize)};
+  std::vector<uint8_t> buildId(mainPart->buildId->hashSize);
+  if (buildIdHasher)
+    buildIdHasher->finish(buildId);
+  else
+    computeBuildId(buildId, {Out::bufferStart, size_t(fileSize)});
+  for (Partition &part : partitions)
+    part.buildId->writeBuildId(buildId);
+}
 
+void elf::computeBuildId(MutableArrayRef<uint8_t> buildId,
+                         ArrayRef<uint8_t> output) {
   switch (config->buildId) {
   case BuildIdKind::Fast:
-    computeHash(buildId, buf, [](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      write64le(dest, xxHash64(arr));
-    });
-    break;
   case BuildIdKind::Md5:
-    computeHash(buildId, buf, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      memcpy(dest, MD5::hash(arr).data(), hashSize);
-    });
-    break;
   case BuildIdKind::Sha1:
-    computeHash(buildId, buf, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      memcpy(dest, SHA1::hash(arr).data(), hashSize);
-    });
+    computeHash(buildId, output, getBuildIdHashFn(buildId.size()));
     break;
   case BuildIdKind::Uuid:
-    if (auto ec = llvm::getRandomBytes(buildId.data(), hashSize))
+    if (auto ec = llvm::getRandomBytes(buildId.data(), buildId.size()))
       error("entropy source failure: " + ec.message());
     break;
   default:
     llvm_unreachable("unknown BuildIdKind");
   }
-  for (Partition &part : partitions)
-    part.buildId->writeBuildId(buildId);
 }
 
 template void elf::createSyntheticSections<ELF32LE>();
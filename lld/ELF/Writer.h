@@ -26,6 +26,10 @@ void combineEhSections();
 template <class ELFT> void combineCapRelocsSections();
 template <class ELFT> void writeResult();
 
+// Computes the --build-id of an output image whose build ID is zero-filled.
+void computeBuildId(llvm::MutableArrayRef<uint8_t> buildId,
+                    llvm::ArrayRef<uint8_t> output);
+
 // This describes a program header entry.
 // Each contains type, access flags and range of output sections that will be
 // placed in it.
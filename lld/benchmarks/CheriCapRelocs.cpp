@@ -0,0 +1,88 @@
+#include "benchmark/benchmark.h"
+#include "../ELF/Arch/Cheri.h"
+#include "../ELF/Config.h"
+#include "../ELF/InputSection.h"
+#include "../ELF/Symbols.h"
+#include "lld/Common/Memory.h"
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::ELF;
+using namespace lld;
+using namespace lld::elf;
+
+namespace {
+struct CapRelocInput {
+  CheriCapRelocLocation Loc;
+  Defined *Target;
+  int64_t CapabilityOffset;
+};
+} // namespace
+
+// Set up the parts of the link that CheriCapRelocsSection::addCapReloc()
+// reads: a static, non-PIC link with writable locations, so that no dynamic
+// relocations are needed.
+static void initConfig() {
+  static bool Initialized = false;
+  if (Initialized)
+    return;
+  Initialized = true;
+  config = make<Configuration>();
+  config->ekind = ELF64LEKind;
+  config->wordsize = 8;
+  config->isPic = false;
+  config->pie = false;
+  config->relativeCapRelocsOnly = false;
+  config->zText = true;
+  config->unresolvedSymbols = UnresolvedPolicy::ReportError;
+}
+
+// Each input section holds capability-sized slots that point at one of a
+// fixed set of data symbols. COMDAT-like duplicates make a quarter of the
+// entries repeat an earlier location with the same target, which is what
+// the merge has to detect.
+static std::vector<CapRelocInput> makeInputs(size_t N) {
+  const size_t NumSections = 64;
+  const size_t NumTargets = 256;
+  const uint64_t CapSize = 16;
+  std::vector<InputSection *> Sections;
+  for (size_t I = 0; I < NumSections; ++I)
+    Sections.push_back(make<InputSection>(nullptr, SHF_ALLOC | SHF_WRITE,
+                                          SHT_PROGBITS, CapSize,
+                                          ArrayRef<uint8_t>(), ".data"));
+  std::vector<Defined *> Targets;
+  for (size_t I = 0; I < NumTargets; ++I)
+    Targets.push_back(make<Defined>(nullptr, "target", STB_GLOBAL, STV_DEFAULT,
+                                    STT_OBJECT, I * 64, 64,
+                                    Sections[I % NumSections]));
+
+  std::mt19937 Rng(1);
+  std::vector<CapRelocInput> Inputs;
+  Inputs.reserve(N);
+  for (size_t I = 0; I < N; ++I) {
+    if (I > 4 && Rng() % 4 == 0) {
+      Inputs.push_back(Inputs[Rng() % I]);
+      continue;
+    }
+    CheriCapRelocLocation Loc{Sections[Rng() % NumSections], I * CapSize};
+    Inputs.push_back({Loc, Targets[Rng() % NumTargets], int64_t(Rng() % 64)});
+  }
+  return Inputs;
+}
+
+static void BM_CapRelocsMerge(benchmark::State &State) {
+  initConfig();
+  std::vector<CapRelocInput> Inputs = makeInputs(State.range(0));
+  for (auto _ : State) {
+    CheriCapRelocsSection<ELF64LE> Sec;
+    for (const CapRelocInput &In : Inputs)
+      Sec.addCapReloc(In.Loc, {In.Target, 0}, /*targetNeedsDynReloc=*/false,
+                      In.CapabilityOffset);
+    benchmark::DoNotOptimize(Sec.getSize());
+  }
+  State.SetItemsProcessed(State.iterations() * Inputs.size());
+}
+BENCHMARK(BM_CapRelocsMerge)->Arg(1 << 12)->Arg(1 << 18);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,47 @@
+# REQUIRES: x86
+## --stream-output hashes the output for --build-id while it is still being
+## written. The result must be byte-identical to hashing it afterwards. .data
+## spans several hash chunks, and .eh_frame_hdr is only complete once
+## .eh_frame has been written.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+
+# RUN: ld.lld --eh-frame-hdr --build-id=fast --stream-output %t.o -o %t.fast1
+# RUN: ld.lld --eh-frame-hdr --build-id=fast --no-stream-output %t.o -o %t.fast2
+# RUN: cmp %t.fast1 %t.fast2
+# RUN: llvm-readelf -n %t.fast1 | FileCheck %s
+
+# RUN: ld.lld --eh-frame-hdr --build-id=md5 --stream-output %t.o -o %t.md51
+# RUN: ld.lld --eh-frame-hdr --build-id=md5 --no-stream-output %t.o -o %t.md52
+# RUN: cmp %t.md51 %t.md52
+
+# RUN: ld.lld --eh-frame-hdr --build-id=sha1 --stream-output %t.o -o %t.sha11
+# RUN: ld.lld --eh-frame-hdr --build-id=sha1 --no-stream-output %t.o -o %t.sha12
+# RUN: cmp %t.sha11 %t.sha12
+
+# RUN: ld.lld --eh-frame-hdr --build-id=sha1 --stream-output --threads=1 %t.o \
+# RUN:   -o %t.sha13
+# RUN: cmp %t.sha11 %t.sha13
+
+## A given build ID is not hashed at all.
+# RUN: ld.lld --build-id=0x12345678 --stream-output %t.o -o %t.hex
+# RUN: llvm-readelf -n %t.hex | FileCheck %s --check-prefix=HEX
+
+# CHECK: Build ID: {{[0-9a-f]{16}$}}
+# HEX:   Build ID: 12345678{{$}}
+
+.globl _start
+_start:
+  .cfi_startproc
+  call foo
+  ret
+  .cfi_endproc
+
+foo:
+  .cfi_startproc
+  ret
+  .cfi_endproc
+
+.data
+.space 0x280000, 1
+.quad _start
@@ -0,0 +1,57 @@
+# Check that per-function captables assign each captable load to the function
+# that encloses it, including when several functions share one input section
+# and a zero-size function symbol is nested inside another function.
+# RUN: %cheri_purecap_llvm-mc -filetype=obj %s -o %t.o
+# RUN: ld.lld -pie --captable-scope=function %t.o -o %t.exe
+# RUN: llvm-nm %t.exe | FileCheck %s
+## fn1, fn2 and fn3 are local symbols, which are created lazily when local
+## symbols are discarded. The captable must be split in the same way.
+# RUN: ld.lld -pie --captable-scope=function --discard-all %t.o -o %t-discard.exe
+# RUN: llvm-readelf -S %t.exe | FileCheck %s --check-prefix=SECTIONS
+# RUN: llvm-readelf -S %t-discard.exe | FileCheck %s --check-prefix=SECTIONS
+# SECTIONS: .captable PROGBITS {{[0-9a-f]+}} {{[0-9a-f]+}} 000040
+
+# CHECK-DAG: d global1@CAPTABLE@fn1
+# CHECK-DAG: d global2@CAPTABLE@fn2
+# CHECK-DAG: d global3@CAPTABLE@fn2
+# CHECK-DAG: d global1@CAPTABLE@fn3
+# CHECK-NOT: @CAPTABLE@nested
+
+.text
+.global __start
+.type __start,@function
+__start:
+  nop
+.size __start, .-__start
+
+.type fn1,@function
+fn1:
+  clcbi $c1, %captab20(global1)($c26)
+  nop
+.size fn1, .-fn1
+
+.type fn2,@function
+fn2:
+  clcbi $c1, %captab20(global2)($c26)
+.type nested,@function
+nested:
+  clcbi $c1, %captab20(global3)($c26)
+  nop
+.size fn2, .-fn2
+
+.type fn3,@function
+fn3:
+  nop
+  clcbi $c1, %captab20(global1)($c26)
+.size fn3, .-fn3
+
+.data
+.global global1
+global1:
+  .8byte 0
+.global global2
+global2:
+  .8byte 0
+.global global3
+global3:
+  .8byte 0
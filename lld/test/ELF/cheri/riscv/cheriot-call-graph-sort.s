@@ -0,0 +1,113 @@
+# REQUIRES: riscv
+## Test that call graph profile sorting keeps the code of each CHERIoT
+## compartment together, and that a call into another compartment is
+## resolved through that compartment's export table.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mcpu=cheriot \
+# RUN:   -mattr=+xcheri,+cap-mode -target-abi cheriot main.s -o main.o
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mcpu=cheriot \
+# RUN:   -mattr=+xcheri,+cap-mode -target-abi cheriot a.s -o a.o
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mcpu=cheriot \
+# RUN:   -mattr=+xcheri,+cap-mode -target-abi cheriot b.s -o b.o
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mcpu=cheriot \
+# RUN:   -mattr=+xcheri,+cap-mode -target-abi cheriot c.s -o c.o
+
+## b_entry is local to compartment b, so the edges from a1 and c1 name an
+## undefined symbol. They are resolved through the export table of b. b has
+## the most cross-compartment calls and comes first, followed by a, which
+## calls it most. The hot call from a1 does not pull b_entry into the cluster
+## of a1.
+# RUN: ld.lld main.o a.o c.o b.o -o out
+# RUN: llvm-nm -n out | FileCheck %s
+# CHECK:      t b_entry
+# CHECK-NEXT: t b2
+# CHECK-NEXT: t a1
+# CHECK-NEXT: t a2
+# CHECK-NEXT: t c1
+# CHECK-NEXT: t c2
+# CHECK-NEXT: T _start
+
+## Without a call graph profile, the input order is kept.
+# RUN: ld.lld main.o a.o c.o b.o -o out.noprofile --no-call-graph-profile-sort
+# RUN: llvm-nm -n out.noprofile | FileCheck %s --check-prefix=NOSORT
+# NOSORT:      T _start
+# NOSORT-NEXT: t a1
+# NOSORT-NEXT: t a2
+# NOSORT-NEXT: t c1
+# NOSORT-NEXT: t c2
+# NOSORT-NEXT: t b_entry
+# NOSORT-NEXT: t b2
+
+## b_entry is exported by two compartments here, so the edges to it are
+## ambiguous and dropped. There are no cross-compartment calls left, and the
+## clusters are sorted by density alone.
+# RUN: sed 's/b2/b3/g' b.s > b-dup.s
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mcpu=cheriot \
+# RUN:   -mattr=+xcheri,+cap-mode -target-abi cheriot b-dup.s -o b-dup.o
+# RUN: ld.lld main.o a.o c.o b.o b-dup.o -o out.ambiguous
+# RUN: llvm-nm -n out.ambiguous | FileCheck %s --check-prefix=AMBIGUOUS
+# AMBIGUOUS:      t a1
+# AMBIGUOUS-NEXT: t a2
+# AMBIGUOUS-NEXT: t b_entry
+# AMBIGUOUS-NEXT: t b2
+# AMBIGUOUS-NEXT: t b_entry
+# AMBIGUOUS-NEXT: t b3
+# AMBIGUOUS-NEXT: t c1
+# AMBIGUOUS-NEXT: t c2
+
+#--- main.s
+.globl _start
+.section .text._start,"ax",@progbits
+_start:
+  .zero 4
+
+#--- a.s
+.section .text.a1,"ax",@progbits
+.type a1, @function
+a1:
+  .zero 16
+
+.section .text.a2,"ax",@progbits
+.type a2, @function
+a2:
+  .zero 16
+
+.section .compartment_imports,"a",@progbits
+  .zero 4
+
+.cg_profile a1, a2, 100
+.cg_profile a1, b_entry, 1000
+
+#--- b.s
+.section .text.b_entry,"ax",@progbits
+.type b_entry, @function
+b_entry:
+  .zero 16
+
+.section .text.b2,"ax",@progbits
+.type b2, @function
+b2:
+  .zero 16
+
+.section .compartment_exports,"a",@progbits
+  .word b_entry
+
+.cg_profile b_entry, b2, 10
+
+#--- c.s
+.section .text.c1,"ax",@progbits
+.type c1, @function
+c1:
+  .zero 16
+
+.section .text.c2,"ax",@progbits
+.type c2, @function
+c2:
+  .zero 16
+
+.section .compartment_imports,"a",@progbits
+  .zero 4
+
+.cg_profile c1, c2, 5
+.cg_profile c1, b_entry, 1
@@ -0,0 +1,56 @@
+# REQUIRES: x86, zlib
+## Debug sections are compressed in 1 MiB shards in parallel. Test that a
+## section spanning several shards decompresses to the original contents and
+## that the output does not depend on the thread count.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld %t.o -o %t.plain
+# RUN: ld.lld %t.o -o %t --compress-debug-sections=zlib
+# RUN: ld.lld %t.o -o %t.1 --compress-debug-sections=zlib --threads=1
+# RUN: cmp %t %t.1
+# RUN: llvm-readelf -S %t | FileCheck %s --check-prefix=SEC
+# SEC: .debug_info PROGBITS {{[0-9a-f]+}} {{[0-9a-f]+}} {{[0-9a-f]+}} 00 C 0 0 1
+# SEC: .debug_str  PROGBITS {{[0-9a-f]+}} {{[0-9a-f]+}} {{[0-9a-f]+}} 01 MSC 0 0 1
+
+## The header holds ELFCOMPRESS_ZLIB and the uncompressed size, 0x180004.
+## The zlib stream starts with 78 01.
+# RUN: llvm-readelf -x .debug_info %t | FileCheck %s --check-prefix=HDR
+# HDR:      0x00000000 01000000 00000000 04001800 00000000
+# HDR-NEXT: 0x00000010 01000000 00000000 7801
+
+## The shards form one zlib stream with a single checksum.
+# RUN: llvm-objcopy --decompress-debug-sections %t %t.dec
+# RUN: llvm-objcopy --dump-section .debug_info=%t.info.dec %t.dec %t.junk
+# RUN: llvm-objcopy --dump-section .debug_info=%t.info %t.plain %t.junk
+# RUN: cmp %t.info %t.info.dec
+
+## -O2 uses a higher compression level. The result must still round-trip.
+# RUN: ld.lld %t.o -o %t.O2 --compress-debug-sections=zlib -O2
+# RUN: llvm-objcopy --decompress-debug-sections %t.O2 %t.O2.dec
+# RUN: llvm-objcopy --dump-section .debug_info=%t.info.O2 %t.O2.dec %t.junk
+# RUN: cmp %t.info %t.info.O2
+
+## llvm-readelf -z decompresses the section before dumping it.
+# RUN: llvm-readelf -z -p .debug_str %t | FileCheck %s --check-prefix=STR
+# STR:      String dump of section '.debug_str':
+# STR-NEXT: [ {{ *}}0] AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA
+# STR-NEXT: [ {{ *}}31] BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB
+
+.globl _start
+_start:
+  ret
+
+## 0x180004 bytes: one full shard, a partial one, and data that differs
+## across the boundary.
+.section .debug_info,"",@progbits
+.rept 0x10000
+.ascii "0123456789abcdef"
+.endr
+.rept 0x8000
+.ascii "fedcba9876543210"
+.endr
+.long 0x12345678
+
+.section .debug_str,"MS",@progbits,1
+.asciz "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+.asciz "BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB"
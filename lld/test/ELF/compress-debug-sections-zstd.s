@@ -0,0 +1,57 @@
+# REQUIRES: x86, zstd
+## Test --compress-debug-sections=zstd, and that zstd-compressed input
+## sections are decompressed.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld %t.o -o %t.plain
+# RUN: ld.lld %t.o -o %t --compress-debug-sections=zstd
+# RUN: ld.lld %t.o -o %t.1 --compress-debug-sections=zstd --threads=1
+# RUN: cmp %t %t.1
+# RUN: llvm-readelf -S %t | FileCheck %s --check-prefix=SEC
+# SEC: .debug_info PROGBITS {{[0-9a-f]+}} {{[0-9a-f]+}} {{[0-9a-f]+}} 00 C 0 0 1
+# SEC: .debug_str  PROGBITS {{[0-9a-f]+}} {{[0-9a-f]+}} {{[0-9a-f]+}} 01 MSC 0 0 1
+
+## The header holds ELFCOMPRESS_ZSTD and the uncompressed size, 0x180004.
+## The first frame starts with the zstd magic number.
+# RUN: llvm-readelf -x .debug_info %t | FileCheck %s --check-prefix=HDR
+# HDR:      0x00000000 02000000 00000000 04001800 00000000
+# HDR-NEXT: 0x00000010 01000000 00000000 28b52ffd
+
+## The section is one zstd frame per shard. They decompress in sequence.
+# RUN: llvm-objcopy --decompress-debug-sections %t %t.dec
+# RUN: llvm-objcopy --dump-section .debug_info=%t.info.dec %t.dec %t.junk
+# RUN: llvm-objcopy --dump-section .debug_info=%t.info %t.plain %t.junk
+# RUN: cmp %t.info %t.info.dec
+
+# RUN: llvm-readelf -z -p .debug_str %t | FileCheck %s --check-prefix=STR
+# STR:      String dump of section '.debug_str':
+# STR-NEXT: [ {{ *}}0] AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA
+# STR-NEXT: [ {{ *}}31] BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB
+
+## zstd-compressed input sections are decompressed and merged as usual.
+# RUN: llvm-objcopy --compress-debug-sections=zstd %t.o %t.zstd.o
+# RUN: ld.lld %t.zstd.o -o %t.in
+# RUN: llvm-objcopy --dump-section .debug_info=%t.info.in %t.in %t.junk
+# RUN: cmp %t.info %t.info.in
+# RUN: llvm-readelf -p .debug_str %t.in | FileCheck %s --check-prefix=STR
+
+# RUN: not ld.lld %t.o -o /dev/null --compress-debug-sections=zstd1 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=ERR
+# ERR: error: unknown --compress-debug-sections value: zstd1
+
+.globl _start
+_start:
+  ret
+
+.section .debug_info,"",@progbits
+.rept 0x10000
+.ascii "0123456789abcdef"
+.endr
+.rept 0x8000
+.ascii "fedcba9876543210"
+.endr
+.long 0x12345678
+
+.section .debug_str,"MS",@progbits,1
+.asciz "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+.asciz "BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB"
@@ -0,0 +1,89 @@
+# REQUIRES: x86
+## Synthetic sections that do not depend on each other are finalized in
+## parallel. Check that the output does not depend on the thread count, for a
+## link that has dynamic symbols, version definitions and needs, both hash
+## tables, RELR and partitions.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=x86_64 lib.s -o lib.o
+# RUN: ld.lld -shared lib.o --version-script=lib.ver -soname=lib.so -o lib.so
+# RUN: llvm-mc -filetype=obj -triple=x86_64 main.s -o main.o
+
+# RUN: ld.lld -shared main.o lib.so --version-script=main.ver \
+# RUN:   --hash-style=both --eh-frame-hdr --pack-dyn-relocs=relr \
+# RUN:   --threads=1 -o out1.so
+# RUN: ld.lld -shared main.o lib.so --version-script=main.ver \
+# RUN:   --hash-style=both --eh-frame-hdr --pack-dyn-relocs=relr \
+# RUN:   --threads=4 -o out4.so
+# RUN: ld.lld -shared main.o lib.so --version-script=main.ver \
+# RUN:   --hash-style=both --eh-frame-hdr --pack-dyn-relocs=relr \
+# RUN:   -o outN.so
+# RUN: cmp out1.so out4.so
+# RUN: cmp out1.so outN.so
+
+## Make sure that the sections this test is about are all there.
+# RUN: llvm-readelf -S out1.so | FileCheck %s
+# CHECK-DAG: .dynsym
+# CHECK-DAG: .gnu.version
+# CHECK-DAG: .gnu.version_d
+# CHECK-DAG: .gnu.version_r
+# CHECK-DAG: .gnu.hash
+# CHECK-DAG: .hash
+# CHECK-DAG: .dynstr
+# CHECK-DAG: .relr.dyn
+# CHECK-DAG: .eh_frame_hdr
+# CHECK-DAG: .dynamic
+# CHECK-DAG: part1
+
+## The partition has its own copy of the dynamic sections.
+# RUN: llvm-objcopy --extract-partition=part1 out1.so part1-1.so
+# RUN: llvm-objcopy --extract-partition=part1 out4.so part1-4.so
+# RUN: cmp part1-1.so part1-4.so
+# RUN: llvm-readelf -S --dyn-syms part1-1.so | FileCheck %s --check-prefix=PART
+# PART-DAG: .dynsym
+# PART-DAG: .gnu.version_d
+# PART-DAG: .gnu.hash
+# PART-DAG: .hash
+# PART-DAG: .dynamic
+# PART-DAG: f2@@MAINV2
+
+#--- lib.s
+.globl libfn
+.type libfn, @function
+libfn:
+  ret
+
+#--- lib.ver
+LIBV1 { global: libfn; local: *; };
+
+#--- main.ver
+MAINV1 { global: f1; local: *; };
+MAINV2 { global: f2; } MAINV1;
+
+#--- main.s
+.globl f1, f2
+.type f1, @function
+f1:
+  .cfi_startproc
+  call libfn@PLT
+  ret
+  .cfi_endproc
+
+.section .text.f2,"ax",@progbits
+.type f2, @function
+f2:
+  .cfi_startproc
+  call f1@PLT
+  ret
+  .cfi_endproc
+
+.section .llvm_sympart.f2,"",@llvm_sympart
+.asciz "part1"
+.quad f2
+
+.data
+.p2align 3
+local:
+.quad local
+.quad local + 8
+.quad f1
@@ -0,0 +1,152 @@
+# REQUIRES: x86
+## Test the cases in which --incremental cannot patch the previous output and
+## does a full link instead.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=x86_64 main.s -o main.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 foo.s -o foo1.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 foo-big.s -o foo-big.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 foo-section.s -o foo-section.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 foo-symbol.s -o foo-symbol.o
+# RUN: yaml2obj foo-bad.yaml -o foo-bad.o
+
+## foo grows beyond the free space left after it.
+# RUN: cp foo1.o foo.o && rm -f out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose
+# RUN: cp foo-big.o foo.o
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SLACK
+# RUN: ld.lld main.o foo.o -o full --incremental
+# RUN: cmp out full
+# SLACK: --incremental: foo.o:(.text) does not fit into its slot; doing a full link
+
+## foo.o gains a section.
+# RUN: cp foo1.o foo.o && rm -f out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose
+# RUN: cp foo-section.o foo.o
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=LAYOUT
+# LAYOUT: --incremental: foo.o has a different number of sections; doing a full link
+
+## foo.o gains a symbol.
+# RUN: cp foo1.o foo.o && rm -f out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose
+# RUN: cp foo-symbol.o foo.o
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SYMBOL
+# SYMBOL: --incremental: foo.o has a different number of symbols; doing a full link
+
+## A full link writes a new state after each fallback.
+# RUN: test -f out.incr
+
+## foo.o cannot be parsed. The error is reported, the link falls back and
+## the full link fails as well. No state is left behind.
+# RUN: cp foo1.o foo.o && rm -f out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose
+# RUN: cp foo-bad.o foo.o
+# RUN: not ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=PARSE
+# RUN: not test -f out.incr
+# PARSE: error: foo.o: non-local symbol (2) found at index < .symtab's sh_info (3)
+# PARSE: --incremental: cannot parse foo.o; doing a full link
+# PARSE: error: foo.o: non-local symbol (2) found at index < .symtab's sh_info (3)
+
+## A corrupt state file is ignored.
+# RUN: cp foo1.o foo.o && rm -f out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose
+# RUN: echo '{"version": 1' > out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=CORRUPT
+# RUN: test -f out.incr
+# CORRUPT: --incremental: cannot parse out.incr:
+
+## A state file written by another version of the linker is ignored.
+# RUN: sed -i 's/"version":1/"version":0/' out.incr
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=VERSION
+# VERSION: --incremental: the state was written by a different linker; doing a full link
+
+## So is a state that no longer describes the output.
+# RUN: ld.lld main.o foo.o -o out
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=STALE
+# STALE: --incremental: the output was modified; doing a full link
+
+## And so is a state written for another command line.
+# RUN: ld.lld --incremental main.o foo.o -o out --verbose --gc-sections 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=ARGS
+# ARGS: --incremental: the command line changed; doing a full link
+
+#--- main.s
+.globl _start, bar
+.type bar, @function
+_start:
+  call foo
+  ret
+
+bar:
+  ret
+
+#--- foo.s
+.globl foo
+.type foo, @function
+foo:
+  call bar
+  movl $1, %eax
+  ret
+.size foo, .-foo
+
+#--- foo-big.s
+.globl foo
+.type foo, @function
+foo:
+  call bar
+  movl $1, %eax
+  .fill 8, 1, 0x90
+  ret
+.size foo, .-foo
+
+#--- foo-section.s
+.globl foo
+.type foo, @function
+foo:
+  call bar
+  movl $1, %eax
+  ret
+.size foo, .-foo
+
+.data
+.long 0
+
+#--- foo-symbol.s
+.globl foo, foo2
+.type foo, @function
+foo:
+foo2:
+  call bar
+  movl $1, %eax
+  ret
+.size foo, .-foo
+
+#--- foo-bad.yaml
+## The global symbol foo is below the first global index given by sh_info.
+--- !ELF
+FileHeader:
+  Class:   ELFCLASS64
+  Data:    ELFDATA2LSB
+  Type:    ET_REL
+  Machine: EM_X86_64
+Sections:
+  - Name:    .text
+    Type:    SHT_PROGBITS
+    Flags:   [ SHF_ALLOC, SHF_EXECINSTR ]
+    Content: C3
+  - Name:    .symtab
+    Type:    SHT_SYMTAB
+    Info:    3
+Symbols:
+  - Name:    local
+    Section: .text
+  - Name:    foo
+    Section: .text
+    Binding: STB_GLOBAL
@@ -0,0 +1,77 @@
+# REQUIRES: x86
+## Test that --incremental patches a changed section in place, and that the
+## result is the same as a full link of the new inputs.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=x86_64 main.s -o main.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 foo.s -o foo1.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 foo-patch.s -o foo2.o
+
+## The first link is a full link that saves the layout next to the output.
+# RUN: cp foo1.o foo.o
+# RUN: ld.lld --incremental --build-id main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=FULL --allow-empty
+# RUN: test -f out.incr
+# RUN: cp out out.orig
+# FULL-NOT: --incremental:
+
+## Nothing changed.
+# RUN: ld.lld --incremental --build-id main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=UPTODATE
+# RUN: cmp out out.orig
+# UPTODATE: --incremental: out is up to date
+
+## foo changed but has the same size and relocations. Only its section is
+## rewritten.
+# RUN: cp foo2.o foo.o
+# RUN: ld.lld --incremental --build-id main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=PATCH
+# PATCH-NOT: doing a full link
+# PATCH: --incremental: patched 1 sections in out
+
+## The patched output matches a full link, build ID included.
+# RUN: ld.lld --incremental --build-id main.o foo.o -o full
+# RUN: cmp out full
+# RUN: llvm-objdump -d --no-show-raw-insn out | FileCheck %s --check-prefix=DISASM
+# DISASM:      <foo>:
+# DISASM-NEXT:   callq {{.*}} <bar>
+# DISASM-NEXT:   movl $2, %eax
+
+## The build ID was recomputed.
+# RUN: llvm-readelf -n out.orig out | FileCheck %s --check-prefix=BUILDID
+# BUILDID:     Build ID: [[ID:[0-9a-f]+]]
+# BUILDID-NOT: [[ID]]
+
+## The state was updated, so reverting the change is patched as well.
+# RUN: cp foo1.o foo.o
+# RUN: ld.lld --incremental --build-id main.o foo.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=PATCH
+# RUN: cmp out out.orig
+
+#--- main.s
+.globl _start, bar
+.type bar, @function
+_start:
+  call foo
+  ret
+
+bar:
+  ret
+
+#--- foo.s
+.globl foo
+.type foo, @function
+foo:
+  call bar
+  movl $1, %eax
+  ret
+.size foo, .-foo
+
+#--- foo-patch.s
+.globl foo
+.type foo, @function
+foo:
+  call bar
+  movl $2, %eax
+  ret
+.size foo, .-foo
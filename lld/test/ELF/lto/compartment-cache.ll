@@ -0,0 +1,24 @@
+; REQUIRES: x86
+;; Each compartment gets its own ThinLTO cache directory. Compartments with the
+;; same file name in different directories must not share one.
+
+; RUN: rm -rf %t && mkdir -p %t/a %t/b %t/cache
+; RUN: opt -module-summary %s -o %t/foo.o
+; RUN: ld.lld --compartment --thinlto-cache-dir=%t/cache %t/foo.o -o %t/a/comp.o
+; RUN: ld.lld --compartment --thinlto-cache-dir=%t/cache %t/foo.o -o %t/b/comp.o
+; RUN: ls %t/cache | FileCheck %s
+; RUN: ls %t/cache | count 2
+
+;; Relinking a compartment reuses its directory.
+; RUN: ld.lld --compartment --thinlto-cache-dir=%t/cache %t/foo.o -o %t/a/../a/comp.o
+; RUN: ls %t/cache | count 2
+
+; CHECK: comp.o-{{[0-9A-F]+$}}
+; CHECK: comp.o-{{[0-9A-F]+$}}
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  ret void
+}
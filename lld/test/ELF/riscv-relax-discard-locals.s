@@ -0,0 +1,50 @@
+# REQUIRES: riscv
+## With --discard-all and --strip-all, local symbols are only created when
+## something needs them. Check that relaxation still adjusts the ones that
+## relocations refer to, and that the output matches a link that keeps them.
+
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mattr=+c,+relax %s -o %t.o
+# RUN: ld.lld %t.o -o %t
+# RUN: ld.lld %t.o --discard-all -o %t.discard
+# RUN: ld.lld %t.o --strip-all -o %t.strip
+# RUN: llvm-objcopy -O binary %t %t.bin
+# RUN: llvm-objcopy -O binary %t.discard %t.discard.bin
+# RUN: llvm-objcopy -O binary %t.strip %t.strip.bin
+# RUN: cmp %t.bin %t.discard.bin
+# RUN: cmp %t.bin %t.strip.bin
+
+# RUN: llvm-readelf -s %t | FileCheck %s --check-prefix=KEEP
+# RUN: llvm-readelf -s %t.discard | FileCheck %s --check-prefix=DISCARD
+# RUN: llvm-objdump -d --no-show-raw-insn %t.discard | FileCheck %s
+
+# KEEP:        FUNC    LOCAL  DEFAULT [[#]] f
+# KEEP:        FUNC    LOCAL  DEFAULT [[#]] unused
+# DISCARD-NOT: LOCAL {{.*}} f{{$}}
+# DISCARD-NOT: LOCAL {{.*}} unused{{$}}
+
+## All three calls are relaxed, so f moves, and so does the .word that
+## refers to it.
+# CHECK:      <_start>:
+# CHECK-NEXT:   c.jal 0x[[#%x,F:]]
+# CHECK-NEXT:   c.jal 0x[[#F]]
+# CHECK-NEXT:   c.j 0x[[#F]]
+
+.global _start
+_start:
+  call f
+  call f
+  tail f
+
+.type f, @function
+f:
+  ret
+.size f, .-f
+
+.type unused, @function
+unused:
+  call f
+  ret
+.size unused, .-unused
+
+.data
+.word f
@@ -0,0 +1,51 @@
+# REQUIRES: riscv
+## With --discard-all and --strip-all, local symbols that nothing refers to are
+## only created when something needs them, such as -Map. Here g and unused are
+## not referenced at all. Check that the map file still shows their addresses
+## and sizes after relaxation.
+
+# RUN: llvm-mc -filetype=obj -triple=riscv32 -mattr=+c,+relax %s -o %t.o
+# RUN: ld.lld %t.o -Map=%t.map -o %t
+# RUN: ld.lld %t.o --discard-all -Map=%t.discard.map -o %t.discard
+# RUN: ld.lld %t.o --strip-all -Map=%t.strip.map -o %t.strip
+# RUN: FileCheck %s --input-file=%t.map
+# RUN: FileCheck %s --input-file=%t.discard.map
+# RUN: FileCheck %s --input-file=%t.strip.map
+
+## The three calls are relaxed from 8 to 2 bytes each, so _start shrinks to
+## 6 bytes and everything after it moves down by 18 bytes.
+# CHECK:      [[#%x,START:]] [[#%x,START]] 6 1 _start
+# CHECK-NEXT: [[#%x,START+6]] [[#%x,START+6]] 2 1 f
+# CHECK-NEXT: [[#%x,START+8]] [[#%x,START+8]] 4 1 g
+# CHECK-NEXT: [[#%x,START+12]] [[#%x,START+12]] 2 1 unused
+
+## The map lists the same symbols whether or not they are kept.
+# RUN: grep -E ' (_start|f|g|unused)$' %t.map > %t.syms
+# RUN: grep -E ' (_start|f|g|unused)$' %t.discard.map > %t.discard.syms
+# RUN: grep -E ' (_start|f|g|unused)$' %t.strip.map > %t.strip.syms
+# RUN: cmp %t.syms %t.discard.syms
+# RUN: cmp %t.syms %t.strip.syms
+
+.global _start
+.type _start, @function
+_start:
+  call f
+  call f
+  tail f
+.size _start, .-_start
+
+.type f, @function
+f:
+  ret
+.size f, .-f
+
+.type g, @function
+g:
+  c.nop
+  ret
+.size g, .-g
+
+.type unused, @function
+unused:
+  ret
+.size unused, .-unused
@@ -0,0 +1,63 @@
+# REQUIRES: x86
+## Global symbol names are hashed in parallel before the input files are
+## parsed, and archive members that will be fetched are hashed when their
+## archive is parsed. Test that symbols still resolve across objects and
+## archive members, and that the output does not depend on the thread count.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=x86_64 main.s -o main.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 a.s -o a.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 b.s -o b.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 c.s -o c.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 dup.s -o dup.o
+# RUN: rm -f lib.a && llvm-ar rc lib.a b.o c.o
+
+# RUN: ld.lld --threads=1 main.o a.o lib.a -o out1
+# RUN: ld.lld --threads=4 main.o a.o lib.a -o out4
+# RUN: cmp out1 out4
+# RUN: llvm-nm out1 | FileCheck %s
+
+## b.o is fetched right away, so its names were hashed with the archive.
+## c.o is only fetched for a reference from b.o.
+# CHECK:      T _start
+# CHECK-NEXT: T a
+# CHECK-NEXT: T b
+# CHECK-NEXT: T c
+# CHECK-NEXT: D shared
+
+## A name hashed in advance still collides with the same name parsed later.
+# RUN: not ld.lld --threads=4 main.o a.o dup.o lib.a -o /dev/null 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=DUP
+# DUP: error: duplicate symbol: a
+
+#--- main.s
+.globl _start
+_start:
+  call a
+  call b
+  ret
+
+#--- a.s
+.globl a, shared
+a:
+  ret
+
+.data
+shared:
+  .quad b
+
+#--- b.s
+.globl b
+b:
+  call c
+  ret
+
+#--- c.s
+.globl c
+c:
+  ret
+
+#--- dup.s
+.globl a
+a:
+  ret
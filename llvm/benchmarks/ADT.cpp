@@ -0,0 +1,115 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Pointer-like keys with the alignment of typical IR objects, as used by
+// most DenseMaps in the compiler (Value *, SDNode *, MachineInstr *, ...).
+static std::vector<uintptr_t> makePointerKeys(size_t N) {
+  std::mt19937_64 Rng(1);
+  std::vector<uintptr_t> Keys(N);
+  for (uintptr_t &K : Keys)
+    K = (Rng() & 0xffffffffffff) & ~uintptr_t(0xf);
+  return Keys;
+}
+
+static std::vector<std::string> makeSymbolNames(size_t N) {
+  std::mt19937 Rng(1);
+  std::vector<std::string> Names;
+  Names.reserve(N);
+  for (size_t I = 0; I < N; ++I)
+    Names.push_back("_ZN4llvm" + std::to_string(Rng()) + "symbol" +
+                    std::to_string(I));
+  return Names;
+}
+
+static void BM_DenseMapInsert(benchmark::State &State) {
+  std::vector<uintptr_t> Keys = makePointerKeys(State.range(0));
+  for (auto _ : State) {
+    DenseMap<void *, unsigned> Map;
+    for (uintptr_t K : Keys)
+      Map.try_emplace(reinterpret_cast<void *>(K), 0);
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_DenseMapInsert)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_DenseMapLookup(benchmark::State &State) {
+  std::vector<uintptr_t> Keys = makePointerKeys(State.range(0));
+  DenseMap<void *, unsigned> Map;
+  for (uintptr_t K : Keys)
+    Map[reinterpret_cast<void *>(K)] = K;
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (uintptr_t K : Keys)
+      Sum += Map.lookup(reinterpret_cast<void *>(K));
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_DenseMapLookup)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_StringMapInsert(benchmark::State &State) {
+  std::vector<std::string> Names = makeSymbolNames(State.range(0));
+  for (auto _ : State) {
+    StringMap<unsigned> Map;
+    for (const std::string &Name : Names)
+      Map.try_emplace(Name, 0);
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_StringMapInsert)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_StringMapLookup(benchmark::State &State) {
+  std::vector<std::string> Names = makeSymbolNames(State.range(0));
+  StringMap<unsigned> Map;
+  for (const std::string &Name : Names)
+    Map[Name] = Name.size();
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (const std::string &Name : Names)
+      Sum += Map.lookup(Name);
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_StringMapLookup)->Arg(1 << 10)->Arg(1 << 16);
+
+// Operand lists and worklists mostly stay within their inline storage; this
+// measures both that case and the growth path.
+static void BM_SmallVectorPushBack(benchmark::State &State) {
+  const size_t N = State.range(0);
+  for (auto _ : State) {
+    SmallVector<unsigned, 8> V;
+    for (size_t I = 0; I < N; ++I)
+      V.push_back(I);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallVectorPushBack)->Arg(4)->Arg(8)->Arg(64)->Arg(4096);
+
+static void BM_BumpPtrAllocate(benchmark::State &State) {
+  const size_t N = State.range(0);
+  std::mt19937 Rng(1);
+  std::vector<size_t> Sizes(N);
+  for (size_t &S : Sizes)
+    S = 8 + Rng() % 120;
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    for (size_t S : Sizes)
+      benchmark::DoNotOptimize(Alloc.Allocate(S, 8));
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_BumpPtrAllocate)->Arg(1 << 16);
+
+BENCHMARK_MAIN();
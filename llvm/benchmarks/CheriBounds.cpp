@@ -0,0 +1,89 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Analysis/CheriBounds.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+
+// Build a function with NumAllocas stack arrays in the purecap address space.
+// Each array is accessed through a chain of GEPs that merge in a phi, and
+// every fourth array escapes to an external call, so the checker has to walk
+// the whole use graph before it can decide.
+static std::string makeFunction(unsigned NumAllocas) {
+  std::string IR;
+  raw_string_ostream OS(IR);
+  OS << "target datalayout = \"e-m:e-pf200:128:128:128:64-p:64:64-i64:64-"
+        "n32:64-S128-A200-P200-G200\"\n"
+        "declare void @escape(i32 addrspace(200)*)\n"
+        "define void @f(i1 %c) {\n"
+        "entry:\n";
+  for (unsigned I = 0; I < NumAllocas; ++I)
+    OS << "  %a" << I << " = alloca [16 x i32], align 4, addrspace(200)\n";
+  OS << "  br i1 %c, label %left, label %right\n"
+        "left:\n";
+  for (unsigned I = 0; I < NumAllocas; ++I)
+    OS << "  %l" << I << " = getelementptr inbounds [16 x i32], [16 x i32] "
+       << "addrspace(200)* %a" << I << ", i64 0, i64 " << (I % 8) << "\n";
+  OS << "  br label %join\n"
+        "right:\n";
+  for (unsigned I = 0; I < NumAllocas; ++I)
+    OS << "  %r" << I << " = getelementptr inbounds [16 x i32], [16 x i32] "
+       << "addrspace(200)* %a" << I << ", i64 0, i64 " << (15 - I % 8)
+       << "\n";
+  OS << "  br label %join\n"
+        "join:\n";
+  for (unsigned I = 0; I < NumAllocas; ++I) {
+    OS << "  %p" << I << " = phi i32 addrspace(200)* [ %l" << I
+       << ", %left ], [ %r" << I << ", %right ]\n";
+    for (unsigned J = 0; J < 4; ++J)
+      OS << "  %q" << I << "." << J << " = getelementptr inbounds i32, i32 "
+         << "addrspace(200)* %p" << I << ", i64 " << (J % 2) << "\n"
+         << "  store i32 " << J << ", i32 addrspace(200)* %q" << I << "." << J
+         << "\n";
+    if (I % 4 == 0)
+      OS << "  call void @escape(i32 addrspace(200)* %p" << I << ")\n";
+  }
+  OS << "  ret void\n}\n";
+  return OS.str();
+}
+
+static void BM_CheriNeedBounds(benchmark::State &State) {
+  const bool SharedCache = State.range(1);
+  LLVMContext Context;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M =
+      parseAssemblyString(makeFunction(State.range(0)), Err, Context);
+  if (!M) {
+    State.SkipWithError("failed to parse the generated IR");
+    return;
+  }
+  Function &F = *M->getFunction("f");
+  SmallVector<AllocaInst *, 0> Allocas;
+  for (Instruction &I : instructions(F))
+    if (auto *AI = dyn_cast<AllocaInst>(&I))
+      Allocas.push_back(AI);
+
+  for (auto _ : State) {
+    CheriNeedBoundsCache Cache;
+    unsigned NumNeedBounds = 0;
+    for (AllocaInst *AI : Allocas) {
+      CheriNeedBoundsChecker Checker(AI, M->getDataLayout(),
+                                     SharedCache ? &Cache : nullptr);
+      NumNeedBounds += Checker.anyUseNeedsBounds();
+    }
+    benchmark::DoNotOptimize(NumNeedBounds);
+  }
+  State.SetItemsProcessed(State.iterations() * Allocas.size());
+}
+BENCHMARK(BM_CheriNeedBounds)
+    ->ArgNames({"allocas", "shared_cache"})
+    ->Args({256, 0})
+    ->Args({256, 1});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/CheriCompressedCap.h"
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::cheri;
+
+// Build a memory image that looks like a typical dump of capability-sized
+// words: function pointers that all share the bounds of the code segment,
+// pointers into small heap objects and NULL-derived integers (uintptr_t).
+template <class Format>
+static std::vector<uint8_t> makeCapabilityImage(size_t NumCaps,
+                                                BitVector &Tags) {
+  using Codec = CompressedCapCodec<Format>;
+  using addr_t = typename Codec::addr_t;
+  using cap_t = typename Codec::cap_t;
+  using length_t = typename Format::length_t;
+  std::mt19937_64 Rng(1);
+  const length_t MaxTop = length_t(1) << (sizeof(addr_t) * 8);
+  const addr_t TextBase = 0x100000;
+  const addr_t TextSize = 0x40000;
+  cap_t Text = Format::make_max_perms_cap(0, TextBase, MaxTop);
+  Format::setbounds(&Text, TextBase, (length_t)TextBase + TextSize);
+  std::vector<cap_t> Caps;
+  Caps.reserve(NumCaps);
+  Tags.clear();
+  while (Caps.size() < NumCaps) {
+    cap_t C;
+    unsigned Kind = Rng() % 10;
+    if (Kind < 5) {
+      C = Text;
+      C._cr_cursor = TextBase + (Rng() % TextSize & ~addr_t(3));
+    } else if (Kind < 8) {
+      addr_t Base = static_cast<addr_t>(Rng()) &
+                    (std::numeric_limits<addr_t>::max() >> 1) & ~addr_t(0xf);
+      addr_t Len = static_cast<addr_t>(16 + Rng() % 4096);
+      C = Format::make_max_perms_cap(0, Base, MaxTop);
+      Format::setbounds(&C, Base, (length_t)Base + Len);
+      C._cr_cursor = Base + Rng() % Len;
+    } else {
+      Format::decompress_mem(0, static_cast<addr_t>(Rng()), false, &C);
+    }
+    Caps.push_back(C);
+    Tags.push_back(C.cr_tag);
+  }
+  std::vector<uint8_t> Bytes(NumCaps * Codec::CapBytes);
+  Codec::encode(Caps, support::little, CapabilityWordOrder::CursorFirst,
+                Bytes);
+  return Bytes;
+}
+
+template <class Format>
+static void BM_DecodeScalar(benchmark::State &State) {
+  using Codec = CompressedCapCodec<Format>;
+  using addr_t = typename Codec::addr_t;
+  using cap_t = typename Codec::cap_t;
+  BitVector Tags;
+  std::vector<uint8_t> Bytes =
+      makeCapabilityImage<Format>(State.range(0), Tags);
+  std::vector<cap_t> Out(State.range(0));
+  for (auto _ : State) {
+    const uint8_t *P = Bytes.data();
+    for (size_t I = 0; I < Out.size(); ++I, P += Codec::CapBytes) {
+      addr_t Cursor = support::endian::read<addr_t, support::little,
+                                            support::unaligned>(P);
+      addr_t Pesbt = support::endian::read<addr_t, support::little,
+                                           support::unaligned>(
+          P + Codec::AddrBytes);
+      Format::decompress_mem(Pesbt, Cursor, Tags[I], &Out[I]);
+    }
+    benchmark::DoNotOptimize(Out.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+template <class Format>
+static void BM_DecodeBatch(benchmark::State &State) {
+  using Codec = CompressedCapCodec<Format>;
+  using cap_t = typename Codec::cap_t;
+  BitVector Tags;
+  std::vector<uint8_t> Bytes =
+      makeCapabilityImage<Format>(State.range(0), Tags);
+  std::vector<cap_t> Out(State.range(0));
+  for (auto _ : State) {
+    Codec::decode(Bytes, support::little, CapabilityWordOrder::CursorFirst,
+                  &Tags, Out);
+    benchmark::DoNotOptimize(Out.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+template <class Format>
+static void BM_EncodeBatch(benchmark::State &State) {
+  using Codec = CompressedCapCodec<Format>;
+  using cap_t = typename Codec::cap_t;
+  BitVector Tags;
+  std::vector<uint8_t> Bytes =
+      makeCapabilityImage<Format>(State.range(0), Tags);
+  std::vector<cap_t> Caps(State.range(0));
+  Codec::decode(Bytes, support::little, CapabilityWordOrder::CursorFirst,
+                &Tags, Caps);
+  for (auto _ : State) {
+    Codec::encode(Caps, support::little, CapabilityWordOrder::CursorFirst,
+                  Bytes);
+    benchmark::DoNotOptimize(Bytes.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_DecodeScalar, CompressedCap64)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_DecodeBatch, CompressedCap64)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_EncodeBatch, CompressedCap64)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_DecodeScalar, CompressedCap128)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_DecodeBatch, CompressedCap128)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_EncodeBatch, CompressedCap128)->Arg(1 << 16);
+
+BENCHMARK_MAIN();
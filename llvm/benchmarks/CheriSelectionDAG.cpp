@@ -0,0 +1,133 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include <memory>
+#include <string>
+
+using namespace llvm;
+
+extern "C" void LLVMInitializeRISCVTargetInfo();
+extern "C" void LLVMInitializeRISCVTarget();
+extern "C" void LLVMInitializeRISCVTargetMC();
+extern "C" void LLVMInitializeRISCVAsmPrinter();
+
+// Build NumFunctions functions that load and store pointers through a linked
+// structure, copy memory and set bounds: the operations that go through the
+// capability special cases in SelectionDAG (address space casts around
+// memcpy, capability loads and stores, CHERI intrinsics). With AS 0 the same
+// source is generated with integer pointers, so that the two can be compared.
+static std::string makeModule(const DataLayout &DL, unsigned NumFunctions) {
+  bool Purecap = DL.getAllocaAddrSpace() == 200;
+  std::string AS = Purecap ? " addrspace(200)" : "";
+  std::string P = Purecap ? "p200i8" : "p0i8";
+  std::string IR;
+  raw_string_ostream OS(IR);
+  OS << "target datalayout = \"" << DL.getStringRepresentation() << "\"\n"
+     << "%node = type { %node" << AS << "*, i64, [4 x i8" << AS << "*] }\n"
+     << "declare void @llvm.memcpy." << P << "." << P << ".i64(i8" << AS
+     << "*, i8" << AS << "*, i64, i1)\n";
+  if (Purecap)
+    OS << "declare i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i64("
+          "i8 addrspace(200)*, i64)\n"
+          "declare i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)*)\n";
+  for (unsigned I = 0; I < NumFunctions; ++I) {
+    OS << "define i64 @f" << I << "(%node" << AS << "* %n, i8" << AS
+       << "* %buf, i64 %len) {\n"
+       << "entry:\n"
+       << "  %next.p = getelementptr %node, %node" << AS
+       << "* %n, i64 0, i32 0\n"
+       << "  %next = load %node" << AS << "*, %node" << AS << "*" << AS
+       << "* %next.p\n"
+       << "  %v.p = getelementptr %node, %node" << AS
+       << "* %next, i64 0, i32 1\n"
+       << "  %v = load i64, i64" << AS << "* %v.p\n"
+       << "  %slot = getelementptr %node, %node" << AS
+       << "* %n, i64 0, i32 2, i64 " << I % 4 << "\n"
+       << "  %old = load i8" << AS << "*, i8" << AS << "*" << AS
+       << "* %slot\n";
+    if (Purecap)
+      OS << "  %bounded = call i8 addrspace(200)* "
+            "@llvm.cheri.cap.bounds.set.i64(i8 addrspace(200)* %buf, "
+            "i64 %len)\n"
+            "  %addr = call i64 @llvm.cheri.cap.address.get.i64("
+            "i8 addrspace(200)* %old)\n";
+    else
+      OS << "  %bounded = bitcast i8* %buf to i8*\n"
+            "  %addr = ptrtoint i8* %old to i64\n";
+    OS << "  store i8" << AS << "* %bounded, i8" << AS << "*" << AS
+       << "* %slot\n"
+       << "  %dst = bitcast %node" << AS << "* %n to i8" << AS << "*\n"
+       << "  call void @llvm.memcpy." << P << "." << P << ".i64(i8" << AS
+       << "* %dst, i8" << AS << "* %old, i64 %len, i1 false)\n"
+       << "  %sum = add i64 %v, %addr\n"
+       << "  %r = add i64 %sum, " << I << "\n"
+       << "  ret i64 %r\n"
+       << "}\n";
+  }
+  return OS.str();
+}
+
+static std::unique_ptr<TargetMachine> createTargetMachine(bool Purecap) {
+  static bool Initialized = [] {
+    LLVMInitializeRISCVTargetInfo();
+    LLVMInitializeRISCVTarget();
+    LLVMInitializeRISCVTargetMC();
+    LLVMInitializeRISCVAsmPrinter();
+    return true;
+  }();
+  (void)Initialized;
+
+  std::string Error;
+  const Target *T =
+      TargetRegistry::lookupTarget("riscv64-unknown-freebsd", Error);
+  if (!T)
+    report_fatal_error(Error);
+  TargetOptions Options;
+  Options.MCOptions.ABIName = Purecap ? "l64pc128d" : "lp64d";
+  return std::unique_ptr<TargetMachine>(T->createTargetMachine(
+      "riscv64-unknown-freebsd", "",
+      Purecap ? "+m,+a,+f,+d,+c,+xcheri,+cap-mode" : "+m,+a,+f,+d,+c",
+      Options, Reloc::PIC_, None, CodeGenOpt::Default));
+}
+
+// Run the full code generation pipeline, SelectionDAG instruction selection
+// included, on the generated module. Parsing is not timed.
+static void BM_CodeGen(benchmark::State &State) {
+  bool Purecap = State.range(0);
+  unsigned NumFunctions = State.range(1);
+  std::unique_ptr<TargetMachine> TM = createTargetMachine(Purecap);
+  std::string IR = makeModule(TM->createDataLayout(), NumFunctions);
+  for (auto _ : State) {
+    State.PauseTiming();
+    LLVMContext Ctx;
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M = parseAssemblyString(IR, Err, Ctx);
+    if (!M)
+      report_fatal_error(Err.getMessage());
+    M->setTargetTriple(TM->getTargetTriple().str());
+    SmallString<0> Obj;
+    raw_svector_ostream OS(Obj);
+    legacy::PassManager PM;
+    if (TM->addPassesToEmitFile(PM, OS, nullptr, CGFT_ObjectFile))
+      report_fatal_error("cannot emit an object file");
+    State.ResumeTiming();
+    PM.run(*M);
+    benchmark::DoNotOptimize(Obj.data());
+  }
+  State.SetItemsProcessed(State.iterations() * NumFunctions);
+  State.SetLabel(Purecap ? "purecap" : "integer pointers");
+}
+BENCHMARK(BM_CodeGen)
+    ->Args({1, 256})
+    ->Args({0, 256})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
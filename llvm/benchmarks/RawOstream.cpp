@@ -0,0 +1,64 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+
+// Roughly what the assembly printer emits for one instruction.
+static void printLine(raw_ostream &OS, unsigned I) {
+  OS << "\tcincoffset\t$c" << (I % 32) << ", $c11, " << (int)(I * 16) - 512
+     << '\n';
+}
+
+static void BM_RawSvectorOstream(benchmark::State &State) {
+  const unsigned N = State.range(0);
+  for (auto _ : State) {
+    SmallString<256> Buf;
+    raw_svector_ostream OS(Buf);
+    for (unsigned I = 0; I < N; ++I)
+      printLine(OS, I);
+    benchmark::DoNotOptimize(Buf.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_RawSvectorOstream)->Arg(1 << 12);
+
+static void BM_RawStringOstream(benchmark::State &State) {
+  const unsigned N = State.range(0);
+  for (auto _ : State) {
+    std::string Buf;
+    raw_string_ostream OS(Buf);
+    for (unsigned I = 0; I < N; ++I)
+      printLine(OS, I);
+    benchmark::DoNotOptimize(OS.str().data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_RawStringOstream)->Arg(1 << 12);
+
+static void BM_RawOstreamHex(benchmark::State &State) {
+  const unsigned N = State.range(0);
+  for (auto _ : State) {
+    SmallString<256> Buf;
+    raw_svector_ostream OS(Buf);
+    for (unsigned I = 0; I < N; ++I)
+      OS << format_hex(uint64_t(I) * 0x9E3779B97F4A7C15, 18) << '\n';
+    benchmark::DoNotOptimize(Buf.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_RawOstreamHex)->Arg(1 << 12);
+
+static void BM_RawNullOstream(benchmark::State &State) {
+  const unsigned N = State.range(0);
+  raw_null_ostream OS;
+  for (auto _ : State)
+    for (unsigned I = 0; I < N; ++I)
+      printLine(OS, I);
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_RawNullOstream)->Arg(1 << 12);
+
+BENCHMARK_MAIN();
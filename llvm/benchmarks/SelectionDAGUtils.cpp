@@ -0,0 +1,120 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+// A stand-in for SDNode: SelectionDAG CSEs nodes by profiling the opcode,
+// the value type list and the (node, result number) pair of every operand.
+struct Node : FoldingSetNode {
+  unsigned Opcode;
+  const void *VTs;
+  SmallVector<std::pair<const Node *, unsigned>, 3> Ops;
+
+  void Profile(FoldingSetNodeID &ID) const {
+    profile(ID, Opcode, VTs, Ops);
+  }
+  static void profile(FoldingSetNodeID &ID, unsigned Opcode, const void *VTs,
+                      ArrayRef<std::pair<const Node *, unsigned>> Ops) {
+    ID.AddInteger(Opcode);
+    ID.AddPointer(VTs);
+    for (const auto &Op : Ops) {
+      ID.AddPointer(Op.first);
+      ID.AddInteger(Op.second);
+    }
+  }
+};
+} // namespace
+
+// Build a DAG the way SelectionDAG::getNode does: look the node up first and
+// only create it if it does not exist. About a quarter of the requests hit an
+// existing node.
+static void BM_FoldingSetCSE(benchmark::State &State) {
+  const size_t N = State.range(0);
+  static const char VTLists[4] = {};
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    FoldingSet<Node> CSEMap;
+    std::vector<Node *> Nodes;
+    std::mt19937 Rng(1);
+    for (size_t I = 0; I < N; ++I) {
+      unsigned Opcode = Rng() % 16;
+      const void *VTs = &VTLists[Rng() % 4];
+      SmallVector<std::pair<const Node *, unsigned>, 3> Ops;
+      if (!Nodes.empty())
+        for (unsigned J = 0, E = 1 + Rng() % 2; J < E; ++J)
+          Ops.emplace_back(Nodes[Rng() % std::min<size_t>(Nodes.size(), 8)],
+                           0);
+      FoldingSetNodeID ID;
+      Node::profile(ID, Opcode, VTs, Ops);
+      void *InsertPos;
+      if (CSEMap.FindNodeOrInsertPos(ID, InsertPos))
+        continue;
+      Node *New = new (Alloc.Allocate<Node>()) Node();
+      New->Opcode = Opcode;
+      New->VTs = VTs;
+      New->Ops = Ops;
+      CSEMap.InsertNode(New, InsertPos);
+      Nodes.push_back(New);
+    }
+    benchmark::DoNotOptimize(Nodes.data());
+    for (Node *Nd : Nodes)
+      Nd->~Node();
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_FoldingSetCSE)->Arg(1 << 14);
+
+static std::vector<APInt> makeAPInts(unsigned BitWidth, size_t N) {
+  std::mt19937_64 Rng(1);
+  std::vector<APInt> Values;
+  Values.reserve(N);
+  for (size_t I = 0; I < N; ++I) {
+    SmallVector<uint64_t, 4> Words(divideCeil(BitWidth, 64));
+    for (uint64_t &W : Words)
+      W = Rng();
+    Values.emplace_back(BitWidth, Words);
+  }
+  return Values;
+}
+
+// Constant folding in getNode() on i64 and capability-sized (i128) integers.
+static void BM_APIntArith(benchmark::State &State) {
+  const unsigned BitWidth = State.range(0);
+  std::vector<APInt> Values = makeAPInts(BitWidth, 1024);
+  for (auto _ : State) {
+    APInt Acc(BitWidth, 0);
+    for (size_t I = 0; I + 1 < Values.size(); ++I) {
+      Acc += Values[I] * Values[I + 1];
+      Acc ^= Values[I].lshr(I % BitWidth);
+      Acc |= Values[I] & Values[I + 1];
+    }
+    benchmark::DoNotOptimize(Acc);
+  }
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_APIntArith)->Arg(64)->Arg(128)->Arg(256);
+
+static void BM_APIntDiv(benchmark::State &State) {
+  const unsigned BitWidth = State.range(0);
+  std::vector<APInt> Values = makeAPInts(BitWidth, 1024);
+  for (auto _ : State) {
+    unsigned Bits = 0;
+    for (size_t I = 0; I + 1 < Values.size(); ++I) {
+      // Use a divisor of half the width to exercise the long division.
+      APInt Divisor = Values[I + 1].lshr(BitWidth / 2) | 1;
+      Bits += Values[I].udiv(Divisor).countLeadingZeros();
+    }
+    benchmark::DoNotOptimize(Bits);
+  }
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_APIntDiv)->Arg(64)->Arg(128)->Arg(256);
+
+BENCHMARK_MAIN();
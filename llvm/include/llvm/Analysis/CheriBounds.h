@@ -1,21 +1,42 @@
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
 
 namespace llvm {
 
+/// Caches the results of CheriNeedBoundsChecker queries so that parts of the
+/// use graph that are reachable from multiple uses (or from multiple roots
+/// of the same size, e.g. allocas merged by a PHI) are only walked once.
+/// Results are stored per instruction, so the cache must be cleared if the
+/// users of any instruction other than the checked roots change.
+class CheriNeedBoundsCache {
+public:
+  void clear() { Results.clear(); }
+
+private:
+  friend class CheriNeedBoundsChecker;
+  /// Whether any user of the instruction needs bounds if it is at the given
+  /// offset into an object of the given size.
+  DenseMap<std::tuple<const Instruction *, int64_t, uint64_t>, bool> Results;
+};
+
 class CheriNeedBoundsChecker {
 public:
-  CheriNeedBoundsChecker(AllocaInst *AI, const DataLayout &DL)
-      : RootInst(AI), DL(DL) {
+  CheriNeedBoundsChecker(AllocaInst *AI, const DataLayout &DL,
+                         CheriNeedBoundsCache *Cache = nullptr)
+      : RootInst(AI), DL(DL), Cache(Cache ? Cache : &LocalCache) {
     auto AllocaSize = AI->getAllocationSizeInBits(DL);
     if (AllocaSize)
       MinSizeInBytes = *AllocaSize / 8;
     PointerAS = AI->getType()->getAddressSpace();
   }
   CheriNeedBoundsChecker(Instruction *I, Optional<uint64_t> MinSize,
-                         const DataLayout &DL)
-      : RootInst(I), DL(DL), MinSizeInBytes(MinSize) {
+                         const DataLayout &DL,
+                         CheriNeedBoundsCache *Cache = nullptr)
+      : RootInst(I), DL(DL), MinSizeInBytes(MinSize),
+        Cache(Cache ? Cache : &LocalCache) {
     assert(I->getType()->isPointerTy());
     PointerAS = I->getType()->getPointerAddressSpace();
   }
@@ -26,18 +47,28 @@ public:
   bool anyUseNeedsBounds() const;
 
 private:
-  bool useNeedsBounds(const Use &U, const APInt &CurrentGEPOffset,
+  bool useNeedsBounds(const Use &U, int64_t CurrentGEPOffset,
                       unsigned Depth) const;
-  bool anyUserNeedsBounds(const Instruction *I, const APInt &CurrentGEPOffset,
+  bool anyUserNeedsBounds(const Instruction *I, int64_t CurrentGEPOffset,
                           unsigned Depth) const;
   bool canLoadStoreBeOutOfBounds(const Instruction *I, const Use &U,
-                                 const APInt &CurrentGEPOffset,
+                                 int64_t CurrentGEPOffset,
                                  unsigned Depth) const;
+  bool isAccessInBounds(int64_t Offset, uint64_t Size) const;
 
   Instruction *RootInst;
   const DataLayout &DL;
   Optional<uint64_t> MinSizeInBytes;
   unsigned PointerAS = 0;
+  mutable CheriNeedBoundsCache LocalCache;
+  CheriNeedBoundsCache *Cache;
+  /// The (instruction, offset) pairs that are currently being visited. A use
+  /// that leads back to one of them does not add any new users that could
+  /// need bounds.
+  mutable SmallDenseSet<std::pair<const Instruction *, int64_t>, 8> InProgress;
+  /// Set when a result depends on an in-progress node or was cut off by the
+  /// depth limit. Such results are not cached.
+  mutable bool Incomplete = false;
 };
 
 } // namespace llvm
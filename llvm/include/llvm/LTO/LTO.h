@@ -150,6 +150,7 @@ public:
     using irsymtab::Symbol::getCOFFWeakExternalFallback;
     using irsymtab::Symbol::getSectionName;
     using irsymtab::Symbol::isExecutable;
+    using irsymtab::Symbol::isCompartmentEntry;
     using irsymtab::Symbol::isUsed;
   };
 
@@ -54,10 +54,12 @@ private:
   Decompressor(StringRef Data);
 
   Error consumeCompressedGnuHeader();
-  Error consumeCompressedZLibHeader(bool Is64Bit, bool IsLittleEndian);
+  Error consumeCompressedSectionHeader(bool Is64Bit, bool IsLittleEndian);
 
   StringRef SectionData;
   uint64_t DecompressedSize;
+  /// The ch_type of the section (ELFCOMPRESS_ZLIB for GNU-style sections).
+  uint32_t CompressionType;
 };
 
 } // end namespace object
@@ -114,6 +114,7 @@ struct Symbol {
     FB_format_specific,
     FB_unnamed_addr,
     FB_executable,
+    FB_compartment_entry,
   };
 };
 
@@ -136,7 +137,7 @@ struct Header {
   /// when the format changes, but it does not need to be incremented if a
   /// change to LLVM would cause it to create a different symbol table.
   Word Version;
-  enum { kCurrentVersion = 3 };
+  enum { kCurrentVersion = 4 };
 
   /// The producer's version string (LLVM_VERSION_STRING " " LLVM_REVISION).
   /// Consumers should rebuild the symbol table from IR if the producer's
@@ -211,6 +212,13 @@ struct Symbol {
   bool isUnnamedAddr() const { return (Flags >> S::FB_unnamed_addr) & 1; }
   bool isExecutable() const { return (Flags >> S::FB_executable) & 1; }
 
+  /// Returns whether this is a CHERI compartment entry point or library
+  /// function, i.e. a function that gets an export table entry and so must
+  /// stay visible outside its compartment.
+  bool isCompartmentEntry() const {
+    return (Flags >> S::FB_compartment_entry) & 1;
+  }
+
   uint64_t getCommonSize() const {
     assert(isCommon());
     return CommonSize;
@@ -0,0 +1,190 @@
+//===- CheriCompressedCap.h - Batch CHERI capability encode/decode --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides a C++ wrapper around the cheri-compressed-cap library
+// that encodes and decodes arrays of capabilities at once. It is intended for
+// tools that need to decode large numbers of capabilities (e.g. when dumping
+// memory images or capability tables).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CHERICOMPRESSEDCAP_H
+#define LLVM_SUPPORT_CHERICOMPRESSEDCAP_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/CHERI/cheri-compressed-cap/cheri_compressed_cap.h"
+#include "llvm/Support/Endian.h"
+#include <algorithm>
+#include <cassert>
+
+namespace llvm {
+namespace cheri {
+
+/// Describes the per-format constants that are not exposed by the
+/// CompressedCap64/CompressedCap128 wrapper classes.
+template <class Format> struct CompressedCapTraits;
+
+template <> struct CompressedCapTraits<CompressedCap64> {
+  static constexpr unsigned MantissaWidth = CC64_MANTISSA_WIDTH;
+  static constexpr unsigned MaxExponent = CC64_MAX_EXPONENT;
+  static constexpr cc64_addr_t NullXorMask = CC64_NULL_XOR_MASK;
+};
+
+template <> struct CompressedCapTraits<CompressedCap128> {
+  static constexpr unsigned MantissaWidth = CC128_MANTISSA_WIDTH;
+  static constexpr unsigned MaxExponent = CC128_MAX_EXPONENT;
+  static constexpr cc128_addr_t NullXorMask = CC128_NULL_XOR_MASK;
+};
+
+/// Order of the two words of a capability in memory.
+enum class CapabilityWordOrder {
+  /// The address is stored at the lower address (e.g. CHERI-RISC-V).
+  CursorFirst,
+  /// The metadata (pesbt) word is stored at the lower address (CHERI-MIPS).
+  PesbtFirst,
+};
+
+/// Encodes and decodes arrays of capabilities in the in-memory format
+/// (i.e. with the NULL XOR mask applied to the metadata word).
+///
+/// Decoding a capability's bounds only depends on the metadata word and the
+/// address bits above the mantissa. Capabilities stored in memory often share
+/// metadata (untagged integers in capability slots, or many pointers into the
+/// same object), so the batch decoder reuses previously decoded bounds
+/// whenever they are guaranteed to be identical and only falls back to the
+/// full decompression otherwise.
+template <class Format> class CompressedCapCodec {
+public:
+  using addr_t = typename Format::addr_t;
+  using cap_t = typename Format::cap_t;
+  static constexpr size_t AddrBytes = sizeof(addr_t);
+  static constexpr size_t CapBytes = 2 * sizeof(addr_t);
+
+  /// Decode Pesbt.size() capabilities into Out. If Tags is null all
+  /// capabilities are treated as untagged.
+  static void decode(ArrayRef<addr_t> Pesbt, ArrayRef<addr_t> Cursor,
+                     const BitVector *Tags, MutableArrayRef<cap_t> Out) {
+    assert(Pesbt.size() == Cursor.size() && Pesbt.size() == Out.size());
+    assert(!Tags || Tags->size() >= Out.size());
+    Decoder D;
+    for (size_t I = 0, E = Out.size(); I != E; ++I)
+      D.decode(Pesbt[I], Cursor[I], Tags && (*Tags)[I], Out[I]);
+  }
+
+  /// Decode the raw in-memory representation of Out.size() capabilities that
+  /// are stored contiguously in Bytes.
+  static void decode(ArrayRef<uint8_t> Bytes, support::endianness Endian,
+                     CapabilityWordOrder Order, const BitVector *Tags,
+                     MutableArrayRef<cap_t> Out) {
+    assert(Bytes.size() == Out.size() * CapBytes && "Size mismatch");
+    assert(!Tags || Tags->size() >= Out.size());
+    const size_t CursorOff =
+        Order == CapabilityWordOrder::CursorFirst ? 0 : AddrBytes;
+    const size_t PesbtOff = AddrBytes - CursorOff;
+    const uint8_t *P = Bytes.data();
+    Decoder D;
+    for (size_t I = 0, E = Out.size(); I != E; ++I, P += CapBytes) {
+      addr_t Cursor =
+          support::endian::read<addr_t, support::unaligned>(P + CursorOff,
+                                                            Endian);
+      addr_t Pesbt =
+          support::endian::read<addr_t, support::unaligned>(P + PesbtOff,
+                                                            Endian);
+      D.decode(Pesbt, Cursor, Tags && (*Tags)[I], Out[I]);
+    }
+  }
+
+  /// Encode Caps into the raw in-memory representation. Bytes must be exactly
+  /// Caps.size() * CapBytes large.
+  static void encode(ArrayRef<cap_t> Caps, support::endianness Endian,
+                     CapabilityWordOrder Order, MutableArrayRef<uint8_t> Bytes) {
+    assert(Bytes.size() == Caps.size() * CapBytes && "Size mismatch");
+    const size_t CursorOff =
+        Order == CapabilityWordOrder::CursorFirst ? 0 : AddrBytes;
+    const size_t PesbtOff = AddrBytes - CursorOff;
+    uint8_t *P = Bytes.data();
+    for (const cap_t &C : Caps) {
+      support::endian::write<addr_t, support::unaligned>(P + CursorOff,
+                                                         C.address(), Endian);
+      support::endian::write<addr_t, support::unaligned>(
+          P + PesbtOff, Format::compress_mem(&C), Endian);
+      P += CapBytes;
+    }
+  }
+
+private:
+  /// Decodes one capability at a time, remembering recent full
+  /// decompressions in a small direct-mapped cache keyed by the metadata word.
+  ///
+  /// compute_base_top() only depends on the cursor through
+  /// Cursor >> (E + MantissaWidth - 3). Splitting that value K into
+  /// ATop = K >> 3 and A3 = K & 7, the decoded bounds only depend on
+  /// ATop - (A3 < R3), where R3 is the top three bits of B minus one. This
+  /// difference is the same for all eight consecutive values of K starting at
+  /// (ATop - (A3 < R3)) * 8 + R3 (i.e. the representable region), so we can
+  /// reuse the decoded bounds for any cursor that falls into this range.
+  class Decoder {
+    using Traits = CompressedCapTraits<Format>;
+    static constexpr unsigned CacheBits = 6;
+    struct CacheEntry {
+      addr_t Pesbt;
+      int64_t RegionStart;
+      uint8_t Shift;
+      bool Valid;
+      uint8_t BoundsValid;
+      uint8_t Exp;
+      addr_t Base;
+      typename Format::length_t Top;
+    };
+    CacheEntry Cache[1 << CacheBits] = {};
+
+  public:
+    void decode(addr_t Pesbt, addr_t Cursor, bool Tag, cap_t &Out) {
+      CacheEntry &Entry =
+          Cache[(uint64_t(Pesbt) * UINT64_C(0x9E3779B97F4A7C15)) >>
+                (64 - CacheBits)];
+      if (Entry.Valid && Entry.Pesbt == Pesbt &&
+          uint64_t(int64_t(Cursor >> Entry.Shift) - Entry.RegionStart) < 8) {
+        Out._cr_cursor = Cursor;
+        Out.cr_pesbt = Pesbt ^ Traits::NullXorMask;
+        Out._cr_top = Entry.Top;
+        Out.cr_base = Entry.Base;
+        Out.cr_tag = Tag;
+        Out.cr_bounds_valid = Entry.BoundsValid;
+        Out.cr_exp = Entry.Exp;
+        return;
+      }
+      Format::decompress_mem(Pesbt, Cursor, Tag, &Out);
+      const unsigned E = std::min<unsigned>(Out.cr_exp, Traits::MaxExponent);
+      const unsigned Shift = E + Traits::MantissaWidth - 3;
+      const typename Format::bounds_bits Bounds =
+          Format::extract_bounds_bits(Out.cr_pesbt);
+      const unsigned R3 = ((Bounds.B >> (Traits::MantissaWidth - 3)) - 1) & 7;
+      const addr_t K = Cursor >> Shift;
+      const int64_t ATop = K >> 3;
+      Entry.Pesbt = Pesbt;
+      Entry.RegionStart = (ATop - ((K & 7) < R3)) * 8 + R3;
+      Entry.Shift = Shift;
+      Entry.Valid = true;
+      Entry.BoundsValid = Out.cr_bounds_valid;
+      Entry.Exp = Out.cr_exp;
+      Entry.Base = Out.cr_base;
+      Entry.Top = Out._cr_top;
+    }
+  };
+};
+
+using CompressedCap64Codec = CompressedCapCodec<CompressedCap64>;
+using CompressedCap128Codec = CompressedCapCodec<CompressedCap128>;
+
+} // end namespace cheri
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_CHERICOMPRESSEDCAP_H
@@ -15,9 +15,12 @@
 #ifndef LLVM_SUPPORT_CHERISETBOUNDS_H
 #define LLVM_SUPPORT_CHERISETBOUNDS_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/FunctionExtras.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Alignment.h"
@@ -78,12 +81,52 @@ private:
   SmallVector<Entry, 32> Entries;
 };
 
+/// CSetBounds statistics aggregated by site. Unlike the CSV and JSON output,
+/// the binary serialization of this profile can be concatenated (e.g. by many
+/// compiler invocations appending to the same stats file) and merged again
+/// later with llvm-csetbounds-stats.
+///
+/// Each chunk of the binary format consists of the magic "CSBSTATS", a
+/// little-endian uint32_t version, a string table and a list of records. All
+/// integers other than the version are ULEB128-encoded.
+class CSetBoundsProfile {
+public:
+  struct Record {
+    CSetBoundsStatistics::Entry Site;
+    uint64_t Count = 0;
+  };
+  static constexpr uint32_t Version = 1;
+
+  /// Add Count occurrences of the site described by E.
+  void add(const CSetBoundsStatistics::Entry &E, uint64_t Count = 1);
+  /// Merge all other records into this profile.
+  void merge(const CSetBoundsProfile &Other);
+  /// Parse and merge all binary chunks in Data.
+  Error read(StringRef Data);
+  /// Write this profile as a single binary chunk.
+  void write(raw_ostream &OS) const;
+
+  ArrayRef<Record> records() const { return Records; }
+  uint64_t totalCount() const;
+  static bool hasBinaryMagic(StringRef Data);
+
+private:
+  std::vector<Record> Records;
+  StringMap<size_t> Index;
+};
+
 enum StatsFormat {
   StatsOff = 0,
   StatsCSV,
   StatsJSON,
+  StatsBinary,
 };
 
+/// Returns the single letter used for \p Kind in the CSV output.
+char getPointerKindLetter(SetBoundsPointerSource Kind);
+/// Returns a human-readable description of \p Kind (e.g. for remarks).
+StringRef getPointerKindName(SetBoundsPointerSource Kind);
+
 extern StatsFormat ShouldCollectCSetBoundsStats;
 extern ManagedStatic<CSetBoundsStatistics> CSetBoundsStats;
 
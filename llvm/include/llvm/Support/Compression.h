@@ -41,8 +41,47 @@ Error uncompress(StringRef InputBuffer,
 
 uint32_t crc32(StringRef Buffer);
 
+/// Compress InputBuffer as one piece of a raw (headerless) deflate stream and
+/// append the result to CompressedBuffer. All pieces but the last one are
+/// terminated with a sync flush so that they end on a byte boundary and can
+/// be compressed independently and then concatenated. The concatenation of
+/// the pieces has to be wrapped with a zlib header and the adler32 checksum
+/// of the uncompressed data to form a valid zlib stream.
+Error compressChunk(StringRef InputBuffer,
+                    SmallVectorImpl<char> &CompressedBuffer, int Level,
+                    bool IsLast);
+
+uint32_t adler32(StringRef Buffer);
+
+/// Return the adler32 checksum of the concatenation of two buffers, given
+/// the checksums of both buffers and the length of the second one.
+uint32_t adler32Combine(uint32_t Adler1, uint32_t Adler2, size_t Len2);
+
 }  // End of namespace zlib
 
+namespace zstd {
+
+static constexpr int NoCompression = -5;
+static constexpr int BestSpeedCompression = 1;
+static constexpr int DefaultCompression = 5;
+static constexpr int BestSizeCompression = 12;
+
+bool isAvailable();
+
+/// Compress InputBuffer as a single zstd frame. Independently compressed
+/// frames may be concatenated; uncompress() decodes all of them.
+Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
+               int Level = DefaultCompression);
+
+Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                 size_t &UncompressedSize);
+
+Error uncompress(StringRef InputBuffer,
+                 SmallVectorImpl<char> &UncompressedBuffer,
+                 size_t UncompressedSize);
+
+}  // End of namespace zstd
+
 } // End of namespace llvm
 
 #endif
@@ -16,6 +16,7 @@
 #include "llvm/Support/Threading.h"
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -72,6 +73,9 @@ public:
   void sync() const { L.sync(); }
 };
 
+/// Returns the number of threads in the default executor.
+size_t getThreadCount();
+
 const ptrdiff_t MinParallelSize = 1024;
 
 /// Inclusive median.
@@ -122,11 +126,34 @@ void parallel_sort(RandomAccessIterator Start, RandomAccessIterator End,
 }
 
 // TaskGroup has a relatively high overhead, so we want to reduce
-// the number of spawn() calls. We'll create up to 1024 tasks here.
+// the number of spawn() calls. Inputs are split into up to 1024 chunks here.
 // (Note that 1024 is an arbitrary number. This code probably needs
 // improving to take the number of available cores into account.)
 enum { MaxTasksPerGroup = 1024 };
 
+/// Calls Fn(ChunkBegin, ChunkEnd) for the consecutive chunks of at most
+/// ChunkSize items that cover [0, NumItems). Rather than spawning a task per
+/// chunk, this spawns at most one task per thread; the tasks, including the
+/// calling thread, claim chunks from a shared counter until none are left.
+/// This keeps the executor out of the loop while still balancing uneven
+/// chunks across threads.
+template <class FuncTy>
+void parallel_for_chunks(size_t NumItems, size_t ChunkSize, FuncTy Fn) {
+  assert(ChunkSize > 0 && "empty chunks");
+  const size_t NumChunks = divideCeil(NumItems, ChunkSize);
+  std::atomic<size_t> NextChunk{0};
+  auto RunChunks = [&] {
+    for (size_t I = NextChunk++; I < NumChunks; I = NextChunk++)
+      Fn(I * ChunkSize, std::min(NumItems, (I + 1) * ChunkSize));
+  };
+
+  TaskGroup TG;
+  size_t NumTasks = std::min(NumChunks, getThreadCount());
+  for (size_t I = 1; I < NumTasks; ++I)
+    TG.spawn(RunChunks);
+  RunChunks();
+}
+
 template <class IterTy, class FuncTy>
 void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
   // If we have zero or one items, then do not incur the overhead of spinning up
@@ -140,18 +167,12 @@ void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
     return;
   }
 
-  // Limit the number of tasks to MaxTasksPerGroup to limit job scheduling
+  // Limit the number of chunks to MaxTasksPerGroup to limit scheduling
   // overhead on large inputs.
-  ptrdiff_t TaskSize = NumItems / MaxTasksPerGroup;
-  if (TaskSize == 0)
-    TaskSize = 1;
-
-  TaskGroup TG;
-  while (TaskSize < std::distance(Begin, End)) {
-    TG.spawn([=, &Fn] { std::for_each(Begin, Begin + TaskSize, Fn); });
-    Begin += TaskSize;
-  }
-  std::for_each(Begin, End, Fn);
+  size_t ChunkSize = std::max<size_t>(NumItems / MaxTasksPerGroup, 1);
+  parallel_for_chunks(NumItems, ChunkSize, [&](size_t B, size_t E) {
+    std::for_each(Begin + B, Begin + E, Fn);
+  });
 }
 
 template <class IndexTy, class FuncTy>
@@ -167,22 +188,13 @@ void parallel_for_each_n(IndexTy Begin, IndexTy End, FuncTy Fn) {
     return;
   }
 
-  // Limit the number of tasks to MaxTasksPerGroup to limit job scheduling
+  // Limit the number of chunks to MaxTasksPerGroup to limit scheduling
   // overhead on large inputs.
-  ptrdiff_t TaskSize = NumItems / MaxTasksPerGroup;
-  if (TaskSize == 0)
-    TaskSize = 1;
-
-  TaskGroup TG;
-  IndexTy I = Begin;
-  for (; I + TaskSize < End; I += TaskSize) {
-    TG.spawn([=, &Fn] {
-      for (IndexTy J = I, E = I + TaskSize; J != E; ++J)
-        Fn(J);
-    });
-  }
-  for (IndexTy J = I; J < End; ++J)
-    Fn(J);
+  size_t ChunkSize = std::max<size_t>(NumItems / MaxTasksPerGroup, 1);
+  parallel_for_chunks(NumItems, ChunkSize, [&](size_t B, size_t E) {
+    for (IndexTy J = Begin + B, JE = Begin + E; J != JE; ++J)
+      Fn(J);
+  });
 }
 
 template <class IterTy, class ResultTy, class ReduceFuncTy,
@@ -190,38 +202,25 @@ template <class IterTy, class ResultTy, class ReduceFuncTy,
 ResultTy parallel_transform_reduce(IterTy Begin, IterTy End, ResultTy Init,
                                    ReduceFuncTy Reduce,
                                    TransformFuncTy Transform) {
-  // Limit the number of tasks to MaxTasksPerGroup to limit job scheduling
+  // Limit the number of chunks to MaxTasksPerGroup to limit scheduling
   // overhead on large inputs.
   size_t NumInputs = std::distance(Begin, End);
   if (NumInputs == 0)
     return std::move(Init);
-  size_t NumTasks = std::min(static_cast<size_t>(MaxTasksPerGroup), NumInputs);
-  std::vector<ResultTy> Results(NumTasks, Init);
-  {
-    // Each task processes either TaskSize or TaskSize+1 inputs. Any inputs
-    // remaining after dividing them equally amongst tasks are distributed as
-    // one extra input over the first tasks.
-    TaskGroup TG;
-    size_t TaskSize = NumInputs / NumTasks;
-    size_t RemainingInputs = NumInputs % NumTasks;
-    IterTy TBegin = Begin;
-    for (size_t TaskId = 0; TaskId < NumTasks; ++TaskId) {
-      IterTy TEnd = TBegin + TaskSize + (TaskId < RemainingInputs ? 1 : 0);
-      TG.spawn([=, &Transform, &Reduce, &Results] {
-        // Reduce the result of transformation eagerly within each task.
-        ResultTy R = Init;
-        for (IterTy It = TBegin; It != TEnd; ++It)
-          R = Reduce(R, Transform(*It));
-        Results[TaskId] = R;
-      });
-      TBegin = TEnd;
-    }
-    assert(TBegin == End);
-  }
+  size_t ChunkSize = divideCeil(NumInputs, MaxTasksPerGroup);
+  std::vector<ResultTy> Results(divideCeil(NumInputs, ChunkSize), Init);
+  parallel_for_chunks(NumInputs, ChunkSize, [&](size_t B, size_t E) {
+    // Reduce the result of transformation eagerly within each chunk.
+    ResultTy R = Init;
+    for (IterTy It = Begin + B, TEnd = Begin + E; It != TEnd; ++It)
+      R = Reduce(R, Transform(*It));
+    Results[B / ChunkSize] = R;
+  });
 
-  // Do a final reduction. There are at most 1024 tasks, so this only adds
-  // constant single-threaded overhead for large inputs. Hopefully most
-  // reductions are cheaper than the transformation.
+  // Do a final reduction in chunk order, so that the result does not depend
+  // on scheduling. There are at most 1024 chunks, so this only adds constant
+  // single-threaded overhead for large inputs. Hopefully most reductions are
+  // cheaper than the transformation.
   ResultTy FinalResult = std::move(Results.front());
   for (ResultTy &PartialResult :
        makeMutableArrayRef(Results.data() + 1, Results.size() - 1))
@@ -14,6 +14,7 @@
 #ifndef LLVM_TRANSFORMS_SCALAR_LOWERATOMIC_H
 #define LLVM_TRANSFORMS_SCALAR_LOWERATOMIC_H
 
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/PassManager.h"
 
 namespace llvm {
@@ -25,11 +26,19 @@ public:
   static bool isRequired() { return true; }
 };
 
-class AtomicRMWInst;
+class IRBuilderBase;
+/// Convert the given CmpXchg into primitive load and compare,
+/// assuming that doing so is legal. Return true if the lowering
+/// succeeds.
+bool lowerAtomicCmpXchgInst(AtomicCmpXchgInst *CXI);
 /// Convert the given RMWI into primitive load and stores,
 /// assuming that doing so is legal. Return true if the lowering
 /// succeeds.
 bool lowerAtomicRMWInst(AtomicRMWInst *RMWI);
+/// Emit IR to implement the given atomicrmw operation on values in registers,
+/// returning the new value.
+Value *buildAtomicRMWValue(AtomicRMWInst::BinOp Op, IRBuilderBase &Builder,
+                           Value *Loaded, Value *Inc);
 }
 
 #endif // LLVM_TRANSFORMS_SCALAR_LOWERATOMIC_H
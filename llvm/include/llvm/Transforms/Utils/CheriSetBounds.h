@@ -44,12 +44,27 @@ inline SetBoundsPointerSource inferPointerSource(const Value *V) {
   return SetBoundsPointerSource::Unknown;
 }
 
-// These 3 helpers should probably be somewhere else
+/// Look through casts and GEPs to find out whether V points to a subobject,
+/// a stack allocation, a global, a function or a heap allocation. Unlike
+/// inferPointerSource() this is only used for remarks, so it does not change
+/// the pointer kinds recorded in the CSetBounds statistics.
+SetBoundsPointerSource inferUnderlyingPointerSource(const Value *V);
+
+/// Rough estimate of the number of instructions needed to set bounds of
+/// length \p Length: the bounds instruction itself plus materializing constant
+/// lengths that do not fit into a 12-bit immediate.
+unsigned estimateSetBoundsCost(const Value *Length);
+
+// These helpers should probably be somewhere else
 
 // Look at the attached debug info to get the name of the local variable or if
 // not known return the name of the allocainst
 std::string inferLocalVariableName(AllocaInst *AI);
 
+// Returns the debug location of Inst or, for instructions such as allocas that
+// don't have one attached, the location of the first llvm.dbg.declare() use.
+DebugLoc inferDebugLoc(Instruction *Inst);
+
 // returns a source file + line if debug info is present valid, otherwise falls
 // back to "<somewhere in $FUNCTION_NAME>"
 std::string inferSourceLocation(Instruction *Inst);
@@ -1,5 +1,7 @@
 #include "llvm/Analysis/CheriBounds.h"
 #include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
@@ -19,8 +21,8 @@ bool CheriNeedBoundsChecker::check(const Use &U) const {
                 U.getUser()->dump());
     return true;
   }
-  APInt CurrentGEPOffset = APInt(DL.getIndexSizeInBits(PointerAS), 0);
-  bool Result = useNeedsBounds(U, CurrentGEPOffset, 1);
+  Incomplete = false;
+  bool Result = useNeedsBounds(U, 0, 1);
   if (Result) {
     DBG_MESSAGE("Found alloca use that needs bounds: "; U.getUser()->dump());
   }
@@ -48,13 +50,21 @@ bool CheriNeedBoundsChecker::anyUseNeedsBounds() const {
   return false;
 }
 
+bool CheriNeedBoundsChecker::isAccessInBounds(int64_t Offset,
+                                              uint64_t Size) const {
+  assert(MinSizeInBytes && "dynamic size alloca should have been checked earlier");
+  return Offset >= 0 && Size <= *MinSizeInBytes &&
+         static_cast<uint64_t>(Offset) <= *MinSizeInBytes - Size;
+}
+
 bool CheriNeedBoundsChecker::useNeedsBounds(const Use &U,
-                                            const APInt &CurrentGEPOffset,
+                                            int64_t CurrentGEPOffset,
                                             unsigned Depth) const {
   const Instruction *I = cast<Instruction>(U.getUser());
   // Value *V = U->get();
   if (Depth > 10) {
     DBG_INDENTED("reached max depth, assuming bounds needed.\n");
+    Incomplete = true;
     return true;
   }
 
@@ -109,10 +119,8 @@ bool CheriNeedBoundsChecker::useNeedsBounds(const Use &U,
       auto SizeArg = I->getOperand(1);
       if (auto CI = dyn_cast<ConstantInt>(SizeArg)) {
         if (MinSizeInBytes) {
-          APInt Zero(CurrentGEPOffset.getBitWidth(), 0);
-          APInt Max(CurrentGEPOffset.getBitWidth(), *MinSizeInBytes);
-          APInt LastAddr = CurrentGEPOffset + CI->getValue();
-          if (CurrentGEPOffset.slt(Zero) || LastAddr.sgt(Max)) {
+          if (CI->getValue().getActiveBits() > 64 ||
+              !isAccessInBounds(CurrentGEPOffset, CI->getZExtValue())) {
             DBG_INDENTED(I->getFunction()->getName()
                              << ": setbounds use offset OUT OF BOUNDS and will "
                                 "trap -> adding csetbounds: ";
@@ -198,13 +206,20 @@ bool CheriNeedBoundsChecker::useNeedsBounds(const Use &U,
                    I->dump());
       return true;
     }
-    APInt NewGepOffset(CurrentGEPOffset);
-    if (!GEPI->accumulateConstantOffset(DL, NewGepOffset)) {
+    APInt GEPOffset(DL.getIndexSizeInBits(PointerAS), 0);
+    if (!GEPI->accumulateConstantOffset(DL, GEPOffset)) {
       DBG_INDENTED("Could not accumulate constant GEP Offset -> need bounds: ";
                    I->dump());
       return true;
     }
-    return anyUserNeedsBounds(GEPI, NewGepOffset, Depth);
+    int64_t NewGEPOffset;
+    if (GEPOffset.getMinSignedBits() > 64 ||
+        AddOverflow(CurrentGEPOffset, GEPOffset.getSExtValue(), NewGEPOffset)) {
+      DBG_INDENTED("GEP offset does not fit in 64 bits -> need bounds: ";
+                   I->dump());
+      return true;
+    }
+    return anyUserNeedsBounds(GEPI, NewGEPOffset, Depth);
   }
   case Instruction::PHI:
   case Instruction::Select:
@@ -237,25 +252,49 @@ bool CheriNeedBoundsChecker::useNeedsBounds(const Use &U,
 }
 
 bool CheriNeedBoundsChecker::anyUserNeedsBounds(const Instruction *I,
-                                                const APInt &CurrentGEPOffset,
+                                                int64_t CurrentGEPOffset,
                                                 unsigned Depth) const {
+  assert(MinSizeInBytes && "dynamic size alloca should have been checked earlier");
+  const auto Key = std::make_tuple(I, CurrentGEPOffset, *MinSizeInBytes);
+  auto Cached = Cache->Results.find(Key);
+  if (Cached != Cache->Results.end()) {
+    DBG_INDENTED("Reusing cached result for " << I->getOpcodeName() << ": "
+                                              << Cached->second << "\n");
+    return Cached->second;
+  }
+  // A cycle (e.g. through a PHI) at the same offset does not reach any new
+  // users, so it can't add a use that needs bounds.
+  if (!InProgress.insert({I, CurrentGEPOffset}).second) {
+    DBG_INDENTED("Already checking " << I->getOpcodeName() << ": "; I->dump());
+    Incomplete = true;
+    return false;
+  }
   DBG_INDENTED("Checking if " << I->getOpcodeName() << " needs stack bounds: ";
                I->dump());
+  const bool OuterIncomplete = Incomplete;
+  Incomplete = false;
+  bool Result = false;
   for (const Use &U : I->uses()) {
     if (useNeedsBounds(U, CurrentGEPOffset, Depth + 1)) {
       DBG_INDENTED("Adding stack bounds since " << I->getOpcodeName()
                                                 << " user needs bounds: ";
                    U.getUser()->dump());
-      return true;
+      Result = true;
+      break;
     }
   }
-  DBG_INDENTED("no " << I->getOpcodeName() << " users need bounds: ";
-               I->dump());
-  return false;
+  if (!Result)
+    DBG_INDENTED("no " << I->getOpcodeName() << " users need bounds: ";
+                 I->dump());
+  InProgress.erase({I, CurrentGEPOffset});
+  if (!Incomplete)
+    Cache->Results.try_emplace(Key, Result);
+  Incomplete |= OuterIncomplete;
+  return Result;
 }
 
 bool CheriNeedBoundsChecker::canLoadStoreBeOutOfBounds(
-    const Instruction *I, const Use &U, const APInt &CurrentGEPOffset,
+    const Instruction *I, const Use &U, int64_t CurrentGEPOffset,
     unsigned Depth) const {
   DBG_INDENTED("Checking if load/store needs bounds (GEP offset is "
                    << CurrentGEPOffset << "): ";
@@ -295,10 +334,7 @@ bool CheriNeedBoundsChecker::canLoadStoreBeOutOfBounds(
                    << Size << ", alloca size=" << MinSizeInBytes
                    << ", current GEP offset=" << CurrentGEPOffset << " for ";
                LoadStoreType->dump(););
-  APInt Zero(CurrentGEPOffset.getBitWidth(), 0);
-  APInt Max(CurrentGEPOffset.getBitWidth(), *MinSizeInBytes);
-  APInt LastAddr = CurrentGEPOffset + Size;
-  if (CurrentGEPOffset.slt(Zero) || LastAddr.sgt(Max)) {
+  if (!isAccessInBounds(CurrentGEPOffset, Size.getFixedSize())) {
     DBG_INDENTED(I->getFunction()->getName()
                      << ": stack load/store offset OUT OF BOUNDS -> adding "
                         "csetbounds: ";
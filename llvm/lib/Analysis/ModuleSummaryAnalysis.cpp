@@ -234,6 +234,19 @@ static bool isNonVolatileStore(const Instruction *I) {
   return false;
 }
 
+// A call into another CHERI compartment goes through the callee's export table
+// and the compartment switcher, so the callee must never be imported into (and
+// then inlined across) the compartment boundary.
+static bool isCrossCompartmentCall(const Function &Caller, const CallBase &CB,
+                                   const Function &Callee) {
+  if (CB.getCallingConv() != CallingConv::CHERI_CCall &&
+      Callee.getCallingConv() != CallingConv::CHERI_CCall &&
+      Callee.getCallingConv() != CallingConv::CHERI_CCallee)
+    return false;
+  return Callee.getFnAttribute("cheri-compartment").getValueAsString() !=
+         Caller.getFnAttribute("cheri-compartment").getValueAsString();
+}
+
 static void computeFunctionSummary(
     ModuleSummaryIndex &Index, const Module &M, const Function &F,
     BlockFrequencyInfo *BFI, ProfileSummaryInfo *PSI, DominatorTree &DT,
@@ -336,6 +349,13 @@ static void computeFunctionSummary(
         }
         // We should have named any anonymous globals
         assert(CalledFunction->hasName());
+        // Record cross-compartment calls as plain references: the callee is
+        // kept alive but is not a candidate for importing.
+        if (isCrossCompartmentCall(F, *CB, *CalledFunction)) {
+          RefEdges.insert(
+              Index.getOrInsertValueInfo(cast<GlobalValue>(CalledValue)));
+          continue;
+        }
         auto ScaledCount = PSI->getProfileCount(*CB, BFI);
         auto Hotness = ScaledCount ? getHotness(ScaledCount.getValue(), PSI)
                                    : CalleeInfo::HotnessType::Unknown;
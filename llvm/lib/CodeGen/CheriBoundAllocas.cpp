@@ -1,6 +1,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Analysis/CheriBounds.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
 #include "llvm/Analysis/Utils/Local.h"
 #include "llvm/CodeGen/TargetLowering.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
@@ -126,6 +127,7 @@ public:
     // Give up if this function has no allocas
     if (Allocas.empty())
       return false;
+    OptimizationRemarkEmitter ORE(&F);
 
     LLVM_DEBUG(dbgs() << "\nChecking function " << F.getName() << "\n");
 
@@ -154,6 +156,10 @@ public:
         Intrinsic::getDeclaration(M, Intrinsic::cheri_bounded_stack_cap, SizeTy);
 
     IRBuilder<> B(C);
+    // Only the uses of the allocas themselves are changed below, so the
+    // results for the instructions further down the use graphs stay valid
+    // for the whole function.
+    CheriNeedBoundsCache BoundsCache;
 
     for (AllocaInst *AI : Allocas) {
       const uint64_t TotalUses = AI->getNumUses();
@@ -197,7 +203,7 @@ public:
       if (BoundsMode == StackBoundsMethod::Never) {
         NeedBounds = false;
       } else {
-        CheriNeedBoundsChecker BoundsChecker(AI, DL);
+        CheriNeedBoundsChecker BoundsChecker(AI, DL, &BoundsCache);
         // With -O0 or =always we set bounds on every stack allocation even
         // if it is not necessary
         bool BoundAll = IsOptNone || BoundsMode == StackBoundsMethod::AllUses;
@@ -225,6 +231,16 @@ public:
       if (!NeedBounds) {
         NumCompletelyUnboundedAllocas++;
         DBG_MESSAGE("No need to set bounds on stack alloca"; AI->dump());
+        if (BoundsMode != StackBoundsMethod::Never) {
+          ORE.emit([&]() {
+            return OptimizationRemark(DEBUG_TYPE, "StackBoundsElided",
+                                      cheri::inferDebugLoc(AI), AI->getParent())
+                   << "no bounds needed on "
+                   << ore::NV("Variable", cheri::inferLocalVariableName(AI))
+                   << ": all " << ore::NV("Uses", TotalUses)
+                   << " uses are known to be in bounds";
+          });
+        }
         continue;
       }
 
@@ -253,12 +269,12 @@ public:
       if (AI->isArrayAllocation())
         Size = B.CreateMul(Size, ArraySize);
 
+      TailPaddingAmount TailPadding = TailPaddingAmount::None;
       if (AI->isStaticAlloca() && ForcedAlignment != Align()) {
         // Pad to ensure bounds don't overlap adjacent objects
         uint64_t AllocaSize =
             cast<ConstantInt>(Size)->getValue().getLimitedValue();
-        TailPaddingAmount TailPadding =
-          TLI->getTailPaddingForPreciseBounds(AllocaSize);
+        TailPadding = TLI->getTailPaddingForPreciseBounds(AllocaSize);
         if (TailPadding != TailPaddingAmount::None) {
           Type *AllocatedType =
               AI->isArrayAllocation()
@@ -302,6 +318,7 @@ public:
                         << (S ? Twine(*S) : Twine("<unknown>"));
                  AI->dump());
 
+      unsigned NumIntrinsics = 1;
       if (ReuseSingleIntrinsicCall) {
         // If we use a single instrinsic for all uses, we can simply update
         // all uses to point at the newly inserted intrinsic.
@@ -370,7 +387,32 @@ public:
           }
           U->set(BoundedAlloca);
         }
+        NumIntrinsics = ReplacedUses.size();
       }
+      ORE.emit([&]() {
+        OptimizationRemarkMissed R(DEBUG_TYPE, "StackBounds",
+                                   cheri::inferDebugLoc(AI), AI->getParent());
+        R << "bounds set on "
+          << ore::NV("Variable", cheri::inferLocalVariableName(AI)) << " ("
+          << ore::NV("Reason", TailPadding != TailPaddingAmount::None
+                                   ? "representability padding"
+                                   : "stack")
+          << ")";
+        if (Optional<uint64_t> S = cheri::inferConstantValue(Size))
+          R << " with size " << ore::NV("Size", *S);
+        else
+          R << " with dynamic size";
+        if (TailPadding != TailPaddingAmount::None)
+          R << " including "
+            << ore::NV("Padding", static_cast<uint64_t>(TailPadding))
+            << " bytes of padding";
+        R << " for " << ore::NV("UsesWithBounds", UsesThatNeedBounds.size())
+          << " of " << ore::NV("Uses", TotalUses) << " uses (estimated cost: "
+          << ore::NV("Cost",
+                     NumIntrinsics * cheri::estimateSetBoundsCost(Size))
+          << ")";
+        return R;
+      });
     }
     return true;
   }
@@ -17,6 +17,7 @@
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Comdat.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalObject.h"
 #include "llvm/IR/Mangler.h"
@@ -272,6 +273,10 @@ Error Builder::addSymbol(const ModuleSymbolTable &Msymtab,
   if (GV->canBeOmittedFromSymbolTable())
     Sym.Flags |= 1 << storage::Symbol::FB_may_omit;
   Sym.Flags |= unsigned(GV->getVisibility()) << storage::Symbol::FB_visibility;
+  if (auto *F = dyn_cast<Function>(GV))
+    if (F->getCallingConv() == CallingConv::CHERI_CCallee ||
+        F->getCallingConv() == CallingConv::CHERI_LibCall)
+      Sym.Flags |= 1 << storage::Symbol::FB_compartment_entry;
 
   if (Flags & object::BasicSymbolRef::SF_Common) {
     auto *GVar = dyn_cast<GlobalVariable>(GV);
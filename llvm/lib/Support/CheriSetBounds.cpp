@@ -14,7 +14,10 @@
 
 #include "llvm/Support/CheriSetBounds.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LEB128.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/YAMLParser.h"
 
@@ -35,7 +38,10 @@ struct CreateCollectSetBoundsStats {
                          clEnumValN(llvm::cheri::StatsCSV, "csv",
                                     "Print stats in CSV format"),
                          clEnumValN(llvm::cheri::StatsJSON, "json",
-                                    "Print stats in JSON format")));
+                                    "Print stats in JSON format"),
+                         clEnumValN(llvm::cheri::StatsBinary, "binary",
+                                    "Append stats in the mergeable binary "
+                                    "format read by llvm-csetbounds-stats")));
   }
 };
 
@@ -126,25 +132,204 @@ void CSetBoundsStatistics::print(llvm::raw_ostream &OS, StringRef MainFile,
           OS << "<unknown>";
       }
 
-      if (E.PointerKind == SetBoundsPointerSource::Stack) {
-        OS << ",s";
-      } else if (E.PointerKind == SetBoundsPointerSource::Heap) {
-        OS << ",h";
-      } else if (E.PointerKind == SetBoundsPointerSource::SubObject) {
-        OS << ",o";
-      } else if (E.PointerKind == SetBoundsPointerSource::GlobalVar) {
-        OS << ",g";
-      } else if (E.PointerKind == SetBoundsPointerSource::CodePointer) {
-        OS << ",c";
-      } else {
-        OS << ",?";
-      }
+      OS << ',' << getPointerKindLetter(E.PointerKind);
       OS << ",\"" << llvm::yaml::escape(E.SourceLocation) << '"';
       OS << ",\"" << llvm::yaml::escape(E.Pass) << '"';
       OS << ",\"" << llvm::yaml::escape(E.Details) << '"';
       OS << "\n";
     }
+  } else if (ShouldCollectCSetBoundsStats == StatsBinary) {
+    CSetBoundsProfile Profile;
+    for (const Entry &E : Entries)
+      Profile.add(E);
+    Profile.write(OS);
+  }
+}
+
+char getPointerKindLetter(SetBoundsPointerSource Kind) {
+  switch (Kind) {
+  case SetBoundsPointerSource::Stack:
+    return 's';
+  case SetBoundsPointerSource::Heap:
+    return 'h';
+  case SetBoundsPointerSource::SubObject:
+    return 'o';
+  case SetBoundsPointerSource::GlobalVar:
+    return 'g';
+  case SetBoundsPointerSource::CodePointer:
+    return 'c';
+  case SetBoundsPointerSource::Unknown:
+    break;
+  }
+  return '?';
+}
+
+StringRef getPointerKindName(SetBoundsPointerSource Kind) {
+  switch (Kind) {
+  case SetBoundsPointerSource::Stack:
+    return "stack";
+  case SetBoundsPointerSource::Heap:
+    return "heap";
+  case SetBoundsPointerSource::SubObject:
+    return "subobject";
+  case SetBoundsPointerSource::GlobalVar:
+    return "global";
+  case SetBoundsPointerSource::CodePointer:
+    return "code pointer";
+  case SetBoundsPointerSource::Unknown:
+    break;
+  }
+  return "unknown";
+}
+
+static const char ProfileMagic[] = "CSBSTATS";
+static constexpr size_t ProfileMagicSize = sizeof(ProfileMagic) - 1;
+
+enum : uint8_t {
+  RecordHasSize = 1 << 0,
+  RecordHasSizeMultiple = 1 << 1,
+};
+
+/// Returns a string that uniquely identifies the site described by E. Records
+/// with the same key are merged by summing their counts.
+static std::string getProfileKey(const CSetBoundsStatistics::Entry &E) {
+  std::string Key;
+  raw_string_ostream OS(Key);
+  OS << static_cast<unsigned>(E.PointerKind) << ',' << Log2(E.KnownAlignment)
+     << ',';
+  if (E.RequestedSize)
+    OS << *E.RequestedSize;
+  OS << ',';
+  if (E.RequestedSizeMultipleOf)
+    OS << *E.RequestedSizeMultipleOf;
+  OS << ',' << E.SourceLocation << '\0' << E.Pass << '\0' << E.Details;
+  return OS.str();
+}
+
+void CSetBoundsProfile::add(const CSetBoundsStatistics::Entry &E,
+                            uint64_t Count) {
+  auto Inserted = Index.try_emplace(getProfileKey(E), Records.size());
+  if (Inserted.second)
+    Records.push_back({E, 0});
+  Records[Inserted.first->second].Count += Count;
+}
+
+void CSetBoundsProfile::merge(const CSetBoundsProfile &Other) {
+  for (const Record &R : Other.Records)
+    add(R.Site, R.Count);
+}
+
+uint64_t CSetBoundsProfile::totalCount() const {
+  uint64_t Total = 0;
+  for (const Record &R : Records)
+    Total += R.Count;
+  return Total;
+}
+
+bool CSetBoundsProfile::hasBinaryMagic(StringRef Data) {
+  return Data.startswith(StringRef(ProfileMagic, ProfileMagicSize));
+}
+
+void CSetBoundsProfile::write(raw_ostream &OS) const {
+  StringMap<uint64_t> StringIDs;
+  std::vector<StringRef> Strings;
+  auto GetStringID = [&](StringRef S) {
+    auto Inserted = StringIDs.try_emplace(S, Strings.size());
+    if (Inserted.second)
+      Strings.push_back(Inserted.first->getKey());
+    return Inserted.first->second;
+  };
+  for (const Record &R : Records) {
+    GetStringID(R.Site.SourceLocation);
+    GetStringID(R.Site.Pass);
+    GetStringID(R.Site.Details);
+  }
+
+  OS.write(ProfileMagic, ProfileMagicSize);
+  support::endian::write<uint32_t>(OS, Version, support::little);
+  encodeULEB128(Strings.size(), OS);
+  for (StringRef S : Strings) {
+    encodeULEB128(S.size(), OS);
+    OS << S;
+  }
+  encodeULEB128(Records.size(), OS);
+  for (const Record &R : Records) {
+    const CSetBoundsStatistics::Entry &E = R.Site;
+    encodeULEB128(StringIDs[E.SourceLocation], OS);
+    encodeULEB128(StringIDs[E.Pass], OS);
+    encodeULEB128(StringIDs[E.Details], OS);
+    uint8_t Flags = 0;
+    if (E.RequestedSize)
+      Flags |= RecordHasSize;
+    if (E.RequestedSizeMultipleOf)
+      Flags |= RecordHasSizeMultiple;
+    OS << static_cast<char>(E.PointerKind)
+       << static_cast<char>(Log2(E.KnownAlignment)) << static_cast<char>(Flags);
+    if (E.RequestedSize)
+      encodeULEB128(*E.RequestedSize, OS);
+    if (E.RequestedSizeMultipleOf)
+      encodeULEB128(*E.RequestedSizeMultipleOf, OS);
+    encodeULEB128(R.Count, OS);
+  }
+}
+
+Error CSetBoundsProfile::read(StringRef Data) {
+  DataExtractor DE(Data, /*IsLittleEndian=*/true, /*AddressSize=*/8);
+  DataExtractor::Cursor C(0);
+  auto Malformed = [&](const Twine &Msg) {
+    return createStringError(inconvertibleErrorCode(),
+                             "malformed CSetBounds profile at offset 0x%" PRIx64
+                             ": %s",
+                             C.tell(), Msg.str().c_str());
+  };
+  while (C && !DE.eof(C)) {
+    StringRef Magic = DE.getBytes(C, ProfileMagicSize);
+    if (C && !hasBinaryMagic(Magic))
+      return Malformed("invalid magic");
+    uint32_t ChunkVersion = DE.getU32(C);
+    if (C && ChunkVersion != Version)
+      return Malformed("unsupported version " + Twine(ChunkVersion));
+
+    uint64_t NumStrings = DE.getULEB128(C);
+    std::vector<StringRef> Strings;
+    for (uint64_t I = 0; C && I < NumStrings; ++I) {
+      uint64_t Len = DE.getULEB128(C);
+      Strings.push_back(DE.getBytes(C, Len));
+    }
+
+    uint64_t NumRecords = DE.getULEB128(C);
+    for (uint64_t I = 0; C && I < NumRecords; ++I) {
+      uint64_t LocID = DE.getULEB128(C);
+      uint64_t PassID = DE.getULEB128(C);
+      uint64_t DetailsID = DE.getULEB128(C);
+      uint8_t Kind = DE.getU8(C);
+      uint8_t AlignLog2 = DE.getU8(C);
+      uint8_t Flags = DE.getU8(C);
+      if (!C)
+        break;
+      if (LocID >= Strings.size() || PassID >= Strings.size() ||
+          DetailsID >= Strings.size())
+        return Malformed("invalid string index");
+      if (Kind > static_cast<uint8_t>(SetBoundsPointerSource::SubObject))
+        return Malformed("invalid pointer kind " + Twine(Kind));
+      if (AlignLog2 >= 64)
+        return Malformed("invalid alignment");
+      CSetBoundsStatistics::Entry E;
+      E.PointerKind = static_cast<SetBoundsPointerSource>(Kind);
+      E.KnownAlignment = Align(uint64_t(1) << AlignLog2);
+      if (Flags & RecordHasSize)
+        E.RequestedSize = DE.getULEB128(C);
+      if (Flags & RecordHasSizeMultiple)
+        E.RequestedSizeMultipleOf = DE.getULEB128(C);
+      E.SourceLocation = Strings[LocID].str();
+      E.Pass = Strings[PassID].str();
+      E.Details = Strings[DetailsID].str();
+      uint64_t Count = DE.getULEB128(C);
+      if (C)
+        add(E, Count);
+    }
   }
+  return C.takeError();
 }
 
 CSetBoundsStatistics::CSetBoundsStatistics() {
@@ -20,13 +20,19 @@
 #if LLVM_ENABLE_ZLIB
 #include <zlib.h>
 #endif
+#if LLVM_ENABLE_ZSTD
+#include <zstd.h>
+#endif
 
 using namespace llvm;
 
-#if LLVM_ENABLE_ZLIB
+#if LLVM_ENABLE_ZLIB || LLVM_ENABLE_ZSTD
 static Error createError(StringRef Err) {
   return make_error<StringError>(Err, inconvertibleErrorCode());
 }
+#endif
+
+#if LLVM_ENABLE_ZLIB
 
 static StringRef convertZlibCodeToString(int Code) {
   switch (Code) {
@@ -85,6 +91,47 @@ uint32_t zlib::crc32(StringRef Buffer) {
   return ::crc32(0, (const Bytef *)Buffer.data(), Buffer.size());
 }
 
+Error zlib::compressChunk(StringRef InputBuffer,
+                          SmallVectorImpl<char> &CompressedBuffer, int Level,
+                          bool IsLast) {
+  z_stream S = {};
+  // Negative window bits produce a raw deflate stream without the zlib header
+  // and trailer.
+  int Res = deflateInit2(&S, Level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return createError(convertZlibCodeToString(Res));
+  S.next_in = (Bytef *)InputBuffer.data();
+  S.avail_in = InputBuffer.size();
+
+  size_t Pos = CompressedBuffer.size();
+  // A sync flush appends at most a few bytes on top of deflateBound().
+  CompressedBuffer.resize(Pos + deflateBound(&S, InputBuffer.size()) + 16);
+  do {
+    if (Pos == CompressedBuffer.size())
+      CompressedBuffer.resize(Pos + Pos / 2 + 64);
+    S.next_out = (Bytef *)CompressedBuffer.data() + Pos;
+    S.avail_out = CompressedBuffer.size() - Pos;
+    Res = deflate(&S, IsLast ? Z_FINISH : Z_SYNC_FLUSH);
+    Pos = (char *)S.next_out - CompressedBuffer.data();
+  } while (S.avail_out == 0 && Res != Z_STREAM_ERROR);
+  deflateEnd(&S);
+  // Tell MemorySanitizer that zlib output buffer is fully initialized.
+  __msan_unpoison(CompressedBuffer.data(), Pos);
+  CompressedBuffer.resize(Pos);
+  if (Res == Z_STREAM_ERROR)
+    return createError(convertZlibCodeToString(Res));
+  assert(S.avail_in == 0 && "input was not fully consumed");
+  return Error::success();
+}
+
+uint32_t zlib::adler32(StringRef Buffer) {
+  return ::adler32(1, (const Bytef *)Buffer.data(), Buffer.size());
+}
+
+uint32_t zlib::adler32Combine(uint32_t Adler1, uint32_t Adler2, size_t Len2) {
+  return ::adler32_combine(Adler1, Adler2, Len2);
+}
+
 #else
 bool zlib::isAvailable() { return false; }
 Error zlib::compress(StringRef InputBuffer,
@@ -103,4 +150,76 @@ Error zlib::uncompress(StringRef InputBuffer,
 uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
+Error zlib::compressChunk(StringRef InputBuffer,
+                          SmallVectorImpl<char> &CompressedBuffer, int Level,
+                          bool IsLast) {
+  llvm_unreachable("zlib::compressChunk is unavailable");
+}
+uint32_t zlib::adler32(StringRef Buffer) {
+  llvm_unreachable("zlib::adler32 is unavailable");
+}
+uint32_t zlib::adler32Combine(uint32_t Adler1, uint32_t Adler2, size_t Len2) {
+  llvm_unreachable("zlib::adler32Combine is unavailable");
+}
+#endif
+
+#if LLVM_ENABLE_ZSTD
+bool zstd::isAvailable() { return true; }
+
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  size_t CompressedBufferSize = ::ZSTD_compressBound(InputBuffer.size());
+  CompressedBuffer.reserve(CompressedBufferSize);
+  size_t CompressedSize =
+      ::ZSTD_compress(CompressedBuffer.data(), CompressedBufferSize,
+                      InputBuffer.data(), InputBuffer.size(), Level);
+  if (ZSTD_isError(CompressedSize))
+    return createError(ZSTD_getErrorName(CompressedSize));
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(CompressedBuffer.data(), CompressedSize);
+  CompressedBuffer.set_size(CompressedSize);
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  // ZSTD_decompress decodes all concatenated frames in InputBuffer.
+  const size_t Res =
+      ::ZSTD_decompress(UncompressedBuffer, UncompressedSize,
+                        InputBuffer.data(), InputBuffer.size());
+  if (ZSTD_isError(Res))
+    return createError(ZSTD_getErrorName(Res));
+  UncompressedSize = Res;
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(UncompressedBuffer, UncompressedSize);
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  UncompressedBuffer.reserve(UncompressedSize);
+  Error E =
+      uncompress(InputBuffer, UncompressedBuffer.data(), UncompressedSize);
+  UncompressedBuffer.set_size(UncompressedSize);
+  return E;
+}
+
+#else
+bool zstd::isAvailable() { return false; }
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  llvm_unreachable("zstd::compress is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
 #endif
@@ -8,12 +8,14 @@
 
 #include "llvm/Support/Parallel.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Threading.h"
 
 #include <atomic>
+#include <deque>
 #include <future>
-#include <stack>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -32,22 +34,37 @@ class Executor {
 public:
   virtual ~Executor() = default;
   virtual void add(std::function<void()> func) = 0;
+  virtual size_t getThreadCount() const = 0;
 
   static Executor *getDefaultExecutor();
 };
 
+/// The index of the ThreadPoolExecutor worker running on this thread, or -1U
+/// for threads that do not belong to the pool.
+static LLVM_THREAD_LOCAL unsigned WorkerIndex = -1U;
+
 /// An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+///   using work stealing.
+///
+/// Every worker owns a deque of tasks. Tasks added by a worker go to the back
+/// of its own deque and are taken back from there in filo order, which keeps
+/// recursive algorithms working on hot data. A worker whose deque is empty
+/// steals from the front of the other workers' deques. Tasks added from
+/// outside the pool are distributed round-robin. Workers only touch the
+/// shared mutex when they run out of work and go to sleep.
 class ThreadPoolExecutor : public Executor {
 public:
-  explicit ThreadPoolExecutor(ThreadPoolStrategy S = hardware_concurrency()) {
-    unsigned ThreadCount = S.compute_thread_count();
+  explicit ThreadPoolExecutor(ThreadPoolStrategy S = hardware_concurrency())
+      : ThreadCount(S.compute_thread_count()) {
+    Queues.reserve(ThreadCount);
+    for (unsigned I = 0; I < ThreadCount; ++I)
+      Queues.push_back(std::make_unique<WorkQueue>());
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     Threads.reserve(ThreadCount);
     Threads.resize(1);
     std::lock_guard<std::mutex> Lock(Mutex);
-    Threads[0] = std::thread([this, ThreadCount, S] {
+    Threads[0] = std::thread([this, S] {
       for (unsigned I = 1; I < ThreadCount; ++I) {
         Threads.emplace_back([=] { work(S, I); });
         if (Stop)
@@ -87,30 +104,82 @@ public:
   };
 
   void add(std::function<void()> F) override {
+    unsigned Index = WorkerIndex;
+    if (Index >= ThreadCount)
+      Index = NextQueue.fetch_add(1, std::memory_order_relaxed) % ThreadCount;
+    // Count the task before publishing it so that Pending never underflows.
+    // A worker that sees the count before the task just looks again.
+    ++Pending;
     {
-      std::lock_guard<std::mutex> Lock(Mutex);
-      WorkStack.push(F);
+      WorkQueue &Q = *Queues[Index];
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      Q.Tasks.push_back(std::move(F));
+    }
+    // A worker increments Idle before checking Pending, and we increment
+    // Pending before checking Idle, so either it sees the task or we see it
+    // and wake it up. Taking the mutex orders the notification after the
+    // worker has started waiting.
+    if (Idle > 0) {
+      { std::lock_guard<std::mutex> Lock(Mutex); }
+      Cond.notify_one();
     }
-    Cond.notify_one();
   }
 
+  size_t getThreadCount() const override { return ThreadCount; }
+
 private:
+  struct WorkQueue {
+    std::mutex Mutex;
+    std::deque<std::function<void()>> Tasks;
+  };
+
+  bool popOwn(unsigned ThreadID, std::function<void()> &Task) {
+    WorkQueue &Q = *Queues[ThreadID];
+    std::lock_guard<std::mutex> Lock(Q.Mutex);
+    if (Q.Tasks.empty())
+      return false;
+    Task = std::move(Q.Tasks.back());
+    Q.Tasks.pop_back();
+    --Pending;
+    return true;
+  }
+
+  bool steal(unsigned ThreadID, std::function<void()> &Task) {
+    for (unsigned I = 1; I < ThreadCount; ++I) {
+      WorkQueue &Q = *Queues[(ThreadID + I) % ThreadCount];
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      if (Q.Tasks.empty())
+        continue;
+      Task = std::move(Q.Tasks.front());
+      Q.Tasks.pop_front();
+      --Pending;
+      return true;
+    }
+    return false;
+  }
+
   void work(ThreadPoolStrategy S, unsigned ThreadID) {
     S.apply_thread_strategy(ThreadID);
-    while (true) {
+    WorkerIndex = ThreadID;
+    while (!Stop) {
+      std::function<void()> Task;
+      if (popOwn(ThreadID, Task) || steal(ThreadID, Task)) {
+        Task();
+        continue;
+      }
       std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
-      if (Stop)
-        break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
+      ++Idle;
+      Cond.wait(Lock, [&] { return Stop || Pending > 0; });
+      --Idle;
     }
   }
 
+  const unsigned ThreadCount;
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
+  std::atomic<size_t> Pending{0};
+  std::atomic<unsigned> Idle{0};
+  std::atomic<unsigned> NextQueue{0};
+  std::vector<std::unique_ptr<WorkQueue>> Queues;
   std::mutex Mutex;
   std::condition_variable Cond;
   std::promise<void> ThreadsCreated;
@@ -153,6 +222,10 @@ static std::atomic<int> TaskGroupInstances;
 TaskGroup::TaskGroup() : Parallel(TaskGroupInstances++ == 0) {}
 TaskGroup::~TaskGroup() { --TaskGroupInstances; }
 
+size_t getThreadCount() {
+  return Executor::getDefaultExecutor()->getThreadCount();
+}
+
 void TaskGroup::spawn(std::function<void()> F) {
   if (Parallel) {
     L.inc();
@@ -28,6 +28,7 @@ class MCInst;
 class MCOperand;
 class MachineInstr;
 class MachineOperand;
+class ModulePass;
 class PassRegistry;
 
 /// Information about imported functions.
@@ -101,6 +102,12 @@ void initializeRISCVInsertVSETVLIPass(PassRegistry &);
 FunctionPass *createRISCVCheriCleanupOptPass();
 void initializeRISCVCheriCleanupOptPass(PassRegistry &);
 
+FunctionPass *createRISCVCheriRoundTripOptPass();
+void initializeRISCVCheriRoundTripOptPass(PassRegistry &);
+
+ModulePass *createRISCVCheriotInterruptAtomicsPass();
+void initializeRISCVCheriotInterruptAtomicsPass(PassRegistry &);
+
 InstructionSelector *createRISCVInstructionSelector(const RISCVTargetMachine &,
                                                     RISCVSubtarget &,
                                                     RISCVRegisterBankInfo &);
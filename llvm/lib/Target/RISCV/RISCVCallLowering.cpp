@@ -9,27 +9,132 @@
 /// \file
 /// This file implements the lowering of LLVM calls to machine code calls for
 /// GlobalISel.
+///
+/// Arguments and return values are assigned with the same CC_RISCV function
+/// as SelectionDAG. The generic value handlers cannot be used for them, since
+/// they describe every location with an integer LLT and know nothing about
+/// capabilities, so the copies to and from physical registers are built here.
+/// Only values passed directly in registers are handled; anything passed on
+/// the stack, indirectly or split over several registers falls back to
+/// SelectionDAG.
 //
 //===----------------------------------------------------------------------===//
 
 #include "RISCVCallLowering.h"
+#include "MCTargetDesc/RISCVBaseInfo.h"
 #include "RISCVISelLowering.h"
+#include "RISCVSubtarget.h"
 #include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
 
 using namespace llvm;
 
 RISCVCallLowering::RISCVCallLowering(const RISCVTargetLowering &TLI)
     : CallLowering(&TLI) {}
 
+// Returns the type CC_RISCV assigns a value of type Ty as, or an invalid MVT
+// if GlobalISel cannot lower such a value yet.
+static MVT getValueLocVT(const RISCVSubtarget &STI, const DataLayout &DL,
+                         Type *Ty) {
+  if (Ty->isIntegerTy() && Ty->getIntegerBitWidth() <= STI.getXLen())
+    return STI.getXLenVT();
+  if (auto *PTy = dyn_cast<PointerType>(Ty)) {
+    unsigned AS = PTy->getAddressSpace();
+    if (DL.isFatPointer(AS))
+      return STI.typeForCapabilities();
+    if (DL.getPointerSizeInBits(AS) == STI.getXLen())
+      return STI.getXLenVT();
+  }
+  return MVT();
+}
+
+// Assigns a location to each value in Args with CC_RISCV. Returns false if a
+// value is of an unsupported type or is not passed directly in a register.
+static bool assignRegLocs(MachineFunction &MF, CallingConv::ID CallConv,
+                          bool IsVarArg, bool IsRet,
+                          ArrayRef<CallLowering::ArgInfo> Args,
+                          SmallVectorImpl<CCValAssign> &Locs) {
+  const RISCVSubtarget &STI = MF.getSubtarget<RISCVSubtarget>();
+  const DataLayout &DL = MF.getDataLayout();
+  CCState CCInfo(CallConv, IsVarArg, MF, Locs, MF.getFunction().getContext());
+
+  for (unsigned I = 0, E = Args.size(); I != E; ++I) {
+    const CallLowering::ArgInfo &Arg = Args[I];
+    if (Arg.Regs.size() != 1 || Arg.Flags[0].isByVal())
+      return false;
+    MVT VT = getValueLocVT(STI, DL, Arg.Ty);
+    if (!VT.isValid())
+      return false;
+    unsigned NumLocs = Locs.size();
+    if (RISCV::CC_RISCV(DL, STI.getTargetABI(), I, VT, VT, CCValAssign::Full,
+                        Arg.Flags[0], CCInfo, Arg.IsFixed, IsRet, Arg.Ty,
+                        *STI.getTargetLowering(), None))
+      return false;
+    if (Locs.size() != NumLocs + 1 || !Locs.back().isRegLoc() ||
+        Locs.back().getLocInfo() != CCValAssign::Full)
+      return false;
+  }
+  return true;
+}
+
+// Copies an incoming value out of the register it was assigned, truncating it
+// if it was promoted to XLen.
+static void copyFromLoc(MachineIRBuilder &MIRBuilder, Register ValReg,
+                        const CCValAssign &VA) {
+  LLT ValTy = MIRBuilder.getMRI()->getType(ValReg);
+  unsigned LocSize = VA.getLocVT().getSizeInBits();
+  if (ValTy.getSizeInBits() == LocSize) {
+    MIRBuilder.buildCopy(ValReg, VA.getLocReg());
+    return;
+  }
+  auto Copy = MIRBuilder.buildCopy(LLT::scalar(LocSize), VA.getLocReg());
+  MIRBuilder.buildTrunc(ValReg, Copy);
+}
+
+// Copies an outgoing value into the register it was assigned, extending it
+// as its attributes require if it is narrower than XLen.
+static void copyToLoc(MachineIRBuilder &MIRBuilder, Register ValReg,
+                      const CCValAssign &VA, ISD::ArgFlagsTy Flags) {
+  LLT ValTy = MIRBuilder.getMRI()->getType(ValReg);
+  unsigned LocSize = VA.getLocVT().getSizeInBits();
+  if (ValTy.getSizeInBits() != LocSize) {
+    LLT LocTy = LLT::scalar(LocSize);
+    if (Flags.isSExt())
+      ValReg = MIRBuilder.buildSExt(LocTy, ValReg).getReg(0);
+    else if (Flags.isZExt())
+      ValReg = MIRBuilder.buildZExt(LocTy, ValReg).getReg(0);
+    else
+      ValReg = MIRBuilder.buildAnyExt(LocTy, ValReg).getReg(0);
+  }
+  MIRBuilder.buildCopy(VA.getLocReg(), ValReg);
+}
+
 bool RISCVCallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
                                     const Value *Val, ArrayRef<Register> VRegs,
                                     FunctionLoweringInfo &FLI) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  const Function &F = MF.getFunction();
+  const auto &STI = MF.getSubtarget<RISCVSubtarget>();
+  unsigned RetOpc = RISCVABI::isCheriPureCapABI(STI.getTargetABI())
+                        ? RISCV::PseudoCRET
+                        : RISCV::PseudoRET;
+  MachineInstrBuilder Ret = MIRBuilder.buildInstrNoInsert(RetOpc);
 
-  MachineInstrBuilder Ret = MIRBuilder.buildInstrNoInsert(RISCV::PseudoRET);
+  if (Val && !VRegs.empty()) {
+    if (!FLI.CanLowerReturn || F.getCallingConv() != CallingConv::C)
+      return false;
 
-  if (Val != nullptr) {
-    return false;
+    ArgInfo RetInfo(VRegs, Val->getType(), 0);
+    setArgFlags(RetInfo, AttributeList::ReturnIndex, MF.getDataLayout(), F);
+    SmallVector<CCValAssign, 2> RetLocs;
+    if (!assignRegLocs(MF, F.getCallingConv(), F.isVarArg(), /*IsRet=*/true,
+                       RetInfo, RetLocs))
+      return false;
+
+    copyToLoc(MIRBuilder, RetInfo.Regs[0], RetLocs[0], RetInfo.Flags[0]);
+    Ret.addUse(RetLocs[0].getLocReg(), RegState::Implicit);
   }
+
   MIRBuilder.insertInstr(Ret);
   return true;
 }
@@ -38,14 +143,103 @@ bool RISCVCallLowering::lowerFormalArguments(MachineIRBuilder &MIRBuilder,
                                              const Function &F,
                                              ArrayRef<ArrayRef<Register>> VRegs,
                                              FunctionLoweringInfo &FLI) const {
-
   if (F.arg_empty())
     return true;
+  if (F.getCallingConv() != CallingConv::C || F.isVarArg())
+    return false;
+
+  MachineFunction &MF = MIRBuilder.getMF();
+  const DataLayout &DL = MF.getDataLayout();
+  SmallVector<ArgInfo, 8> Args;
+  unsigned Idx = 0;
+  for (const Argument &Arg : F.args()) {
+    ArgInfo OrigArg(VRegs[Idx], Arg, Idx);
+    setArgFlags(OrigArg, Idx + AttributeList::FirstArgIndex, DL, F);
+    Args.push_back(OrigArg);
+    ++Idx;
+  }
 
-  return false;
+  SmallVector<CCValAssign, 8> ArgLocs;
+  if (!assignRegLocs(MF, F.getCallingConv(), F.isVarArg(), /*IsRet=*/false,
+                     Args, ArgLocs))
+    return false;
+
+  MachineBasicBlock &MBB = MIRBuilder.getMBB();
+  for (unsigned I = 0, E = Args.size(); I != E; ++I) {
+    Register PhysReg = ArgLocs[I].getLocReg();
+    MF.getRegInfo().addLiveIn(PhysReg);
+    MBB.addLiveIn(PhysReg);
+    copyFromLoc(MIRBuilder, Args[I].Regs[0], ArgLocs[I]);
+  }
+  return true;
 }
 
 bool RISCVCallLowering::lowerCall(MachineIRBuilder &MIRBuilder,
                                   CallLoweringInfo &Info) const {
-  return false;
+  if (Info.CallConv != CallingConv::C || Info.IsVarArg ||
+      Info.IsMustTailCall || !Info.CanLowerReturn || Info.SwiftErrorVReg)
+    return false;
+  if (!Info.Callee.isReg() && !Info.Callee.isGlobal() &&
+      !Info.Callee.isSymbol())
+    return false;
+
+  MachineFunction &MF = MIRBuilder.getMF();
+  const auto &STI = MF.getSubtarget<RISCVSubtarget>();
+  const RISCVInstrInfo &TII = *STI.getInstrInfo();
+  const RISCVRegisterInfo *TRI = STI.getRegisterInfo();
+  bool IsPureCap = RISCVABI::isCheriPureCapABI(STI.getTargetABI());
+
+  SmallVector<CCValAssign, 8> ArgLocs;
+  if (!assignRegLocs(MF, Info.CallConv, Info.IsVarArg, /*IsRet=*/false,
+                     Info.OrigArgs, ArgLocs))
+    return false;
+
+  bool HasRet = !Info.OrigRet.Ty->isVoidTy();
+  SmallVector<CCValAssign, 2> RetLocs;
+  if (HasRet && !assignRegLocs(MF, Info.CallConv, Info.IsVarArg,
+                               /*IsRet=*/true, Info.OrigRet, RetLocs))
+    return false;
+
+  // Nothing is passed on the stack, so the call frame is empty.
+  MIRBuilder.buildInstr(TII.getCallFrameSetupOpcode()).addImm(0).addImm(0);
+
+  unsigned Opc;
+  if (Info.Callee.isReg())
+    Opc = IsPureCap ? RISCV::PseudoCCALLIndirect : RISCV::PseudoCALLIndirect;
+  else
+    Opc = IsPureCap ? RISCV::PseudoCCALL : RISCV::PseudoCALL;
+  MachineInstrBuilder Call = MIRBuilder.buildInstrNoInsert(Opc);
+  Call.add(Info.Callee);
+  if (!Info.Callee.isReg()) {
+    unsigned OpFlags = RISCVII::MO_CCALL;
+    if (!IsPureCap) {
+      const GlobalValue *GV =
+          Info.Callee.isGlobal() ? Info.Callee.getGlobal() : nullptr;
+      const Module &M = *MF.getFunction().getParent();
+      OpFlags = MF.getTarget().shouldAssumeDSOLocal(M, GV) ? RISCVII::MO_CALL
+                                                           : RISCVII::MO_PLT;
+    }
+    Call->getOperand(0).setTargetFlags(OpFlags);
+  }
+  Call.addRegMask(TRI->getCallPreservedMask(MF, Info.CallConv));
+
+  for (unsigned I = 0, E = Info.OrigArgs.size(); I != E; ++I) {
+    const ArgInfo &Arg = Info.OrigArgs[I];
+    copyToLoc(MIRBuilder, Arg.Regs[0], ArgLocs[I], Arg.Flags[0]);
+    Call.addUse(ArgLocs[I].getLocReg(), RegState::Implicit);
+  }
+
+  MIRBuilder.insertInstr(Call);
+  if (Info.Callee.isReg())
+    constrainOperandRegClass(MF, *TRI, MF.getRegInfo(), TII,
+                             *STI.getRegBankInfo(), *Call, Call->getDesc(),
+                             Call->getOperand(0), 0);
+
+  if (HasRet) {
+    Call.addDef(RetLocs[0].getLocReg(), RegState::Implicit);
+    copyFromLoc(MIRBuilder, Info.OrigRet.Regs[0], RetLocs[0]);
+  }
+
+  MIRBuilder.buildInstr(TII.getCallFrameDestroyOpcode()).addImm(0).addImm(0);
+  return true;
 }
@@ -20,7 +20,10 @@
 #include "RISCVSubtarget.h"
 #include "RISCVTargetMachine.h"
 
+#include "llvm/ADT/MapVector.h"
 #include "llvm/CodeGen/LivePhysRegs.h"
+#include "llvm/CodeGen/MachineConstantPool.h"
+#include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -42,9 +45,71 @@ public:
 
   bool runOnMachineFunction(MachineFunction &MF) override;
 
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+    AU.addRequired<MachineDominatorTree>();
+    AU.addPreserved<MachineDominatorTree>();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
   StringRef getPassName() const override { return RISCV_CHERI_CLEANUP_NAME; }
+
+private:
+  bool hoistConstantPoolAddresses(MachineFunction &MF);
 };
 
+// Each basic block is selected separately, so a literal pool entry that is
+// loaded in several blocks has its address materialised in each of them.
+// Share a single address per entry, placed in the nearest common dominator of
+// those blocks.  The literal pool cost model in RISCVISelLowering assumes this.
+bool RISCVCheriCleanupOpt::hoistConstantPoolAddresses(MachineFunction &MF) {
+  auto &MRI = MF.getRegInfo();
+  auto &MDT = getAnalysis<MachineDominatorTree>();
+  MapVector<std::pair<int, int64_t>, SmallVector<MachineInstr *, 4>> Addrs;
+  for (auto &MBB : MF)
+    for (auto &MI : MBB)
+      if (MI.getOpcode() == RISCV::PseudoCLLC && MI.getOperand(1).isCPI())
+        Addrs[{MI.getOperand(1).getIndex(), MI.getOperand(1).getOffset()}]
+            .push_back(&MI);
+
+  bool Modified = false;
+  for (auto &Entry : Addrs) {
+    SmallVectorImpl<MachineInstr *> &Defs = Entry.second;
+    if (Defs.size() < 2)
+      continue;
+    MachineBasicBlock *Dom = Defs.front()->getParent();
+    for (MachineInstr *MI : drop_begin(Defs))
+      Dom = MDT.findNearestCommonDominator(Dom, MI->getParent());
+    if (!Dom)
+      continue;
+
+    // Keep an address that is already in the dominator, otherwise move one
+    // there.  It has no register operands, so it can go anywhere before the
+    // terminators.
+    MachineInstr *Keep = nullptr;
+    for (MachineInstr *MI : Defs)
+      if (MI->getParent() == Dom) {
+        Keep = MI;
+        break;
+      }
+    if (!Keep) {
+      Keep = Defs.front();
+      Dom->splice(Dom->getFirstTerminator(), Keep->getParent(), Keep);
+    }
+
+    Register KeepReg = Keep->getOperand(0).getReg();
+    for (MachineInstr *MI : Defs) {
+      if (MI == Keep)
+        continue;
+      MRI.replaceRegWith(MI->getOperand(0).getReg(), KeepReg);
+      MI->eraseFromParent();
+    }
+    MRI.clearKillFlags(KeepReg);
+    Modified = true;
+  }
+  return Modified;
+}
+
 bool RISCVCheriCleanupOpt::runOnMachineFunction(MachineFunction &MF) {
   if (static_cast<const RISCVSubtarget &>(MF.getSubtarget()).getTargetABI() !=
       RISCVABI::ABI_CHERIOT)
@@ -52,19 +117,28 @@ bool RISCVCheriCleanupOpt::runOnMachineFunction(MachineFunction &MF) {
 
   auto &MRI = MF.getRegInfo();
   TII = static_cast<const RISCVInstrInfo *>(MF.getSubtarget().getInstrInfo());
-  bool Modified = false;
+  bool Modified = hoistConstantPoolAddresses(MF);
   for (auto &MBB : MF)
     for (auto &MI : MBB)
       if (MI.getOpcode() == RISCV::PseudoCLLC) {
-        // If this is not a load of a global then this is surprising.
-        if (!MI.getOperand(1).isGlobal())
-          continue;
+        const MachineOperand &Symbol = MI.getOperand(1);
         uint32_t SafeSize = 0;
-        // If this is the definition of a global, then we know the size.  Allow
-        // any loads in that size to be safe.
-        if (auto GV = dyn_cast<GlobalVariable>(MI.getOperand(1).getGlobal()))
-          if (GV->hasInitializer())
-            SafeSize = MF.getDataLayout().getTypeAllocSize(GV->getValueType());
+        if (Symbol.isCPI()) {
+          // Literal pool entries have a known size.
+          SafeSize = MF.getConstantPool()
+                         ->getConstants()[Symbol.getIndex()]
+                         .getSizeInBytes(MF.getDataLayout());
+        } else if (Symbol.isGlobal()) {
+          // If this is the definition of a global, then we know the size.
+          // Allow any loads in that size to be safe.
+          if (auto GV = dyn_cast<GlobalVariable>(Symbol.getGlobal()))
+            if (GV->hasInitializer())
+              SafeSize =
+                  MF.getDataLayout().getTypeAllocSize(GV->getValueType());
+        } else {
+          // Anything else is surprising.
+          continue;
+        }
         bool UnsafeUse = false;
         for (auto &UI : MRI.use_instructions(MI.getOperand(0).getReg())) {
           size_t OpSize = 0;
@@ -110,8 +184,11 @@ bool RISCVCheriCleanupOpt::runOnMachineFunction(MachineFunction &MF) {
 
 } // end of anonymous namespace
 
-INITIALIZE_PASS(RISCVCheriCleanupOpt, "riscv-cheriot-expand-cllc",
-                RISCV_CHERI_CLEANUP_NAME, false, false)
+INITIALIZE_PASS_BEGIN(RISCVCheriCleanupOpt, "riscv-cheriot-expand-cllc",
+                      RISCV_CHERI_CLEANUP_NAME, false, false)
+INITIALIZE_PASS_DEPENDENCY(MachineDominatorTree)
+INITIALIZE_PASS_END(RISCVCheriCleanupOpt, "riscv-cheriot-expand-cllc",
+                    RISCV_CHERI_CLEANUP_NAME, false, false)
 
 namespace llvm {
 
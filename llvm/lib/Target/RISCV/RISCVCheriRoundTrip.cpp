@@ -0,0 +1,202 @@
+//===-- RISCVCheriRoundTrip.cpp - Remove capability address round trips ---===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass removes capability address and offset round trips that survive
+// instruction selection, typically because the get and the set ended up in
+// different basic blocks.  It transforms:
+//   cgetaddr   vreg1, cvreg0
+//   csetaddr   cvreg2, cvreg0, vreg1
+//
+//   Into a use of cvreg0, and similarly for cgetoffset/csetoffset.  In the
+//   pure-capability ABI, where inttoptr is lowered to a cincoffset of the null
+//   capability, it also transforms:
+//   cincoffset cvreg1, cnull, vreg0
+//   cgetaddr   vreg2, cvreg1
+//
+//   Into a use of vreg0.
+//
+// Provenance is unchanged in every case: the capability that is used instead
+// is the one the round trip started from.
+//===----------------------------------------------------------------------===//
+
+#include "RISCV.h"
+#include "RISCVInstrInfo.h"
+#include "RISCVSubtarget.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/Debug.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "riscv-cheri-round-trip"
+#define RISCV_CHERI_ROUND_TRIP_NAME "RISCV CHERI capability round trip removal"
+
+STATISTIC(NumRoundTrips, "Number of capability round trips removed");
+
+namespace {
+
+class RISCVCheriRoundTripOpt : public MachineFunctionPass {
+public:
+  static char ID;
+
+  RISCVCheriRoundTripOpt() : MachineFunctionPass(ID) {
+    initializeRISCVCheriRoundTripOptPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  MachineFunctionProperties getRequiredProperties() const override {
+    return MachineFunctionProperties().set(
+        MachineFunctionProperties::Property::IsSSA);
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  StringRef getPassName() const override {
+    return RISCV_CHERI_ROUND_TRIP_NAME;
+  }
+
+private:
+  MachineRegisterInfo *MRI;
+  bool IsPureCap;
+
+  MachineInstr *getVRegDef(const MachineOperand &MO) const;
+  bool isDead(const MachineInstr &MI) const;
+  bool replaceWith(MachineInstr &MI, Register NewReg);
+  bool foldSetOfGet(MachineInstr &MI, unsigned GetOpc);
+  bool foldGetAddr(MachineInstr &MI);
+};
+
+} // end anonymous namespace
+
+char RISCVCheriRoundTripOpt::ID = 0;
+
+// Returns the unique definition of the virtual register read by MO, or null if
+// MO is not a plain virtual register use.
+MachineInstr *
+RISCVCheriRoundTripOpt::getVRegDef(const MachineOperand &MO) const {
+  if (!MO.isReg() || MO.getSubReg() || !MO.getReg().isVirtual())
+    return nullptr;
+  return MRI->getUniqueVRegDef(MO.getReg());
+}
+
+// Returns true if MI can be erased because nothing reads any of its results
+// and it has no other effect, in the same way as DeadMachineInstructionElim.
+bool RISCVCheriRoundTripOpt::isDead(const MachineInstr &MI) const {
+  // Volatile and atomic loads must stay even if their result is unused.
+  bool SawStore = false;
+  if (!MI.isSafeToMove(nullptr, SawStore) || MI.hasOrderedMemoryRef())
+    return false;
+  for (const MachineOperand &MO : MI.operands())
+    if (MO.isReg() && MO.isDef() &&
+        (!MO.getReg().isVirtual() || !MRI->use_nodbg_empty(MO.getReg())))
+      return false;
+  return true;
+}
+
+// Replaces all uses of the register defined by MI with NewReg and erases MI,
+// along with the definitions of any of its operands that become dead.
+bool RISCVCheriRoundTripOpt::replaceWith(MachineInstr &MI, Register NewReg) {
+  Register OldReg = MI.getOperand(0).getReg();
+  if (!OldReg.isVirtual() || !NewReg.isVirtual() ||
+      !MRI->constrainRegClass(NewReg, MRI->getRegClass(OldReg)))
+    return false;
+
+  LLVM_DEBUG(dbgs() << "  Removing round trip: " << MI);
+  SmallSetVector<MachineInstr *, 2> Operands;
+  for (const MachineOperand &MO : MI.uses())
+    if (MachineInstr *Def = getVRegDef(MO))
+      Operands.insert(Def);
+
+  MRI->replaceRegWith(OldReg, NewReg);
+  MRI->clearKillFlags(NewReg);
+  MI.eraseFromParent();
+  for (MachineInstr *Def : Operands) {
+    if (!isDead(*Def))
+      continue;
+    LLVM_DEBUG(dbgs() << "  Erasing dead operand: " << *Def);
+    for (const MachineOperand &MO : Def->defs())
+      MRI->markUsesInDebugValueAsUndef(MO.getReg());
+    Def->eraseFromParent();
+  }
+  ++NumRoundTrips;
+  return true;
+}
+
+// Folds csetaddr(x, cgetaddr(x)) and csetoffset(x, cgetoffset(x)) to x.
+bool RISCVCheriRoundTripOpt::foldSetOfGet(MachineInstr &MI, unsigned GetOpc) {
+  const MachineOperand &Cap = MI.getOperand(1);
+  MachineInstr *Get = getVRegDef(MI.getOperand(2));
+  if (!Get || Get->getOpcode() != GetOpc || !Cap.isReg() || Cap.getSubReg())
+    return false;
+  const MachineOperand &GetCap = Get->getOperand(1);
+  if (GetCap.getSubReg() || GetCap.getReg() != Cap.getReg())
+    return false;
+  return replaceWith(MI, Cap.getReg());
+}
+
+// Folds cgetaddr(csetaddr(x, a)) to a and, in the pure-capability ABI,
+// cgetaddr(cincoffset(cnull, a)) to a.
+bool RISCVCheriRoundTripOpt::foldGetAddr(MachineInstr &MI) {
+  MachineInstr *Def = getVRegDef(MI.getOperand(1));
+  if (!Def)
+    return false;
+  switch (Def->getOpcode()) {
+  case RISCV::CSetAddr:
+    break;
+  case RISCV::CIncOffset:
+    if (!IsPureCap || Def->getOperand(1).getReg() != RISCV::C0)
+      return false;
+    break;
+  default:
+    return false;
+  }
+  const MachineOperand &Addr = Def->getOperand(2);
+  if (!Addr.isReg() || Addr.getSubReg())
+    return false;
+  return replaceWith(MI, Addr.getReg());
+}
+
+bool RISCVCheriRoundTripOpt::runOnMachineFunction(MachineFunction &MF) {
+  const auto &ST = MF.getSubtarget<RISCVSubtarget>();
+  if (skipFunction(MF.getFunction()) || !ST.hasCheri())
+    return false;
+
+  MRI = &MF.getRegInfo();
+  IsPureCap = RISCVABI::isCheriPureCapABI(ST.getTargetABI());
+  bool Modified = false;
+  for (MachineBasicBlock &MBB : MF) {
+    for (MachineInstr &MI : make_early_inc_range(MBB)) {
+      switch (MI.getOpcode()) {
+      case RISCV::CSetAddr:
+        Modified |= foldSetOfGet(MI, RISCV::CGetAddr);
+        break;
+      case RISCV::CSetOffset:
+        Modified |= foldSetOfGet(MI, RISCV::CGetOffset);
+        break;
+      case RISCV::CGetAddr:
+        Modified |= foldGetAddr(MI);
+        break;
+      }
+    }
+  }
+  return Modified;
+}
+
+INITIALIZE_PASS(RISCVCheriRoundTripOpt, DEBUG_TYPE,
+                RISCV_CHERI_ROUND_TRIP_NAME, false, false)
+
+FunctionPass *llvm::createRISCVCheriRoundTripOptPass() {
+  return new RISCVCheriRoundTripOpt();
+}
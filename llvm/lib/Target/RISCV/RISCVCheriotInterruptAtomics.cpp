@@ -0,0 +1,281 @@
+//===-- RISCVCheriotInterruptAtomics.cpp - Inline atomics with IRQs off ---===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// CHERIoT cores are single-hart, so code that runs with interrupts disabled
+// cannot be interleaved with anything else.  Without the A extension, every
+// atomic operation becomes an __atomic_* libcall, which on CHERIoT goes through
+// the import table.  Clang already emits these as calls for C and C++ atomics,
+// because it knows the target has no native atomics.  This pass rewrites both
+// the sized __atomic_* libcalls and any remaining atomic instructions in
+// functions that run with interrupts disabled, and in internal functions that
+// are only ever called from such functions, into plain loads and stores before
+// AtomicExpand sees them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "RISCV.h"
+#include "RISCVSubtarget.h"
+#include "RISCVTargetMachine.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Scalar/LowerAtomic.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "riscv-cheriot-interrupt-atomics"
+
+STATISTIC(NumLowered, "Number of atomics lowered with interrupts disabled");
+
+namespace {
+
+class RISCVCheriotInterruptAtomics : public ModulePass {
+public:
+  static char ID;
+
+  RISCVCheriotInterruptAtomics() : ModulePass(ID) {
+    initializeRISCVCheriotInterruptAtomicsPass(
+        *PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<TargetPassConfig>();
+  }
+
+  StringRef getPassName() const override {
+    return "RISCV CHERIoT interrupts-disabled atomic lowering";
+  }
+};
+
+} // end anonymous namespace
+
+// Returns true if every use of F is a direct call, so that all of the contexts
+// it can run in are visible in this module.
+static bool onlyCalledDirectly(const Function &F) {
+  if (!F.hasLocalLinkage() || F.use_empty())
+    return false;
+  for (const Use &U : F.uses()) {
+    const auto *CB = dyn_cast<CallBase>(U.getUser());
+    if (!CB || !CB->isCallee(&U))
+      return false;
+  }
+  return true;
+}
+
+// Collects the functions that always run with interrupts disabled: those that
+// request it explicitly, and internal functions that inherit their interrupt
+// posture and are only called from functions in the set.
+static SmallPtrSet<const Function *, 16>
+getInterruptsDisabledFunctions(Module &M) {
+  SmallPtrSet<const Function *, 16> Disabled;
+  SmallVector<const Function *, 16> Candidates;
+  for (const Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    Interrupts Status = getInterruptStatus(F);
+    if (Status == Interrupts::Disabled)
+      Disabled.insert(&F);
+    else if (Status == Interrupts::Inherit && onlyCalledDirectly(F))
+      Candidates.push_back(&F);
+  }
+  Disabled.insert(Candidates.begin(), Candidates.end());
+
+  // Start optimistically and drop any candidate with a caller outside the set
+  // until nothing changes.
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (const Function *F : Candidates) {
+      if (!Disabled.count(F))
+        continue;
+      bool AllCallersDisabled = all_of(F->users(), [&](const User *U) {
+        return Disabled.count(cast<CallBase>(U)->getFunction());
+      });
+      if (!AllCallersDisabled) {
+        Disabled.erase(F);
+        Changed = true;
+      }
+    }
+  }
+  return Disabled;
+}
+
+// Returns the operation performed by a sized __atomic_* libcall, for example
+// "fetch_add" for __atomic_fetch_add_4 or "load" for __atomic_load_cap, or an
+// empty string if Name is not one.  The generic, unsized libcalls pass their
+// operands through memory and are left alone.
+static StringRef getSizedAtomicLibcallOp(StringRef Name) {
+  if (!Name.consume_front("__atomic_"))
+    return "";
+  size_t Sep = Name.rfind('_');
+  if (Sep == StringRef::npos)
+    return "";
+  StringRef Size = Name.substr(Sep + 1);
+  if (Size != "1" && Size != "2" && Size != "4" && Size != "8" &&
+      Size != "16" && Size != "cap")
+    return "";
+  return Name.take_front(Sep);
+}
+
+static Value *castToPointerTo(IRBuilder<> &Builder, Value *Ptr, Type *Ty) {
+  unsigned AS = Ptr->getType()->getPointerAddressSpace();
+  return Builder.CreatePointerCast(Ptr, Ty->getPointerTo(AS));
+}
+
+// Rewrites a call to a sized __atomic_* libcall into plain memory operations,
+// mirroring what LowerAtomic does for the equivalent instructions.
+static bool lowerAtomicLibcall(CallInst *CI) {
+  const Function *Callee = CI->getCalledFunction();
+  if (!Callee || !Callee->isDeclaration())
+    return false;
+  StringRef Op = getSizedAtomicLibcallOp(Callee->getName());
+  if (Op.empty())
+    return false;
+
+  IRBuilder<> Builder(CI);
+  Value *Ptr = CI->getArgOperand(0);
+  Value *Res = nullptr;
+  if (Op == "load") {
+    // T __atomic_load_N(T *mem, int order)
+    if (CI->arg_size() != 2 || CI->getType()->isVoidTy())
+      return false;
+    Type *Ty = CI->getType();
+    Res = Builder.CreateLoad(Ty, castToPointerTo(Builder, Ptr, Ty));
+  } else if (Op == "store") {
+    // void __atomic_store_N(T *mem, T val, int order)
+    if (CI->arg_size() != 3)
+      return false;
+    Value *Val = CI->getArgOperand(1);
+    Builder.CreateStore(Val, castToPointerTo(Builder, Ptr, Val->getType()));
+  } else if (Op == "compare_exchange") {
+    // bool __atomic_compare_exchange_N(T *mem, T *expected, T desired,
+    //                                  int success, int failure)
+    if (CI->arg_size() != 5 || !CI->getType()->isIntegerTy())
+      return false;
+    Value *Desired = CI->getArgOperand(2);
+    Type *Ty = Desired->getType();
+    Value *MemPtr = castToPointerTo(Builder, Ptr, Ty);
+    Value *ExpectedPtr = castToPointerTo(Builder, CI->getArgOperand(1), Ty);
+    Value *Orig = Builder.CreateLoad(Ty, MemPtr);
+    Value *Expected = Builder.CreateLoad(Ty, ExpectedPtr);
+    Value *Equal = Builder.CreateICmpEQ(Orig, Expected);
+    Builder.CreateStore(Builder.CreateSelect(Equal, Desired, Orig), MemPtr);
+    // On failure *expected receives the current value; on success it already
+    // holds it.
+    Builder.CreateStore(Orig, ExpectedPtr);
+    Res = Builder.CreateZExtOrTrunc(Equal, CI->getType());
+  } else {
+    // T __atomic_exchange_N(T *mem, T val, int order)
+    // T __atomic_fetch_<op>_N(T *mem, T val, int order)
+    Optional<AtomicRMWInst::BinOp> BinOp =
+        StringSwitch<Optional<AtomicRMWInst::BinOp>>(Op)
+            .Case("exchange", AtomicRMWInst::Xchg)
+            .Case("fetch_add", AtomicRMWInst::Add)
+            .Case("fetch_sub", AtomicRMWInst::Sub)
+            .Case("fetch_and", AtomicRMWInst::And)
+            .Case("fetch_nand", AtomicRMWInst::Nand)
+            .Case("fetch_or", AtomicRMWInst::Or)
+            .Case("fetch_xor", AtomicRMWInst::Xor)
+            .Case("fetch_max", AtomicRMWInst::Max)
+            .Case("fetch_min", AtomicRMWInst::Min)
+            .Case("fetch_umax", AtomicRMWInst::UMax)
+            .Case("fetch_umin", AtomicRMWInst::UMin)
+            .Default(None);
+    if (!BinOp || CI->arg_size() != 3)
+      return false;
+    Value *Val = CI->getArgOperand(1);
+    Type *Ty = Val->getType();
+    // Arithmetic on capabilities needs the CHERI intrinsics, so only exchange
+    // is handled for the _cap variants.
+    if (Ty != CI->getType() ||
+        (*BinOp != AtomicRMWInst::Xchg && !Ty->isIntegerTy()))
+      return false;
+    Value *MemPtr = castToPointerTo(Builder, Ptr, Ty);
+    LoadInst *Orig = Builder.CreateLoad(Ty, MemPtr);
+    Builder.CreateStore(buildAtomicRMWValue(*BinOp, Builder, Orig, Val),
+                        MemPtr);
+    Res = Orig;
+  }
+
+  if (Res)
+    CI->replaceAllUsesWith(Res);
+  CI->eraseFromParent();
+  return true;
+}
+
+static bool lowerAtomics(Function &F) {
+  bool Changed = false;
+  for (Instruction &I : make_early_inc_range(instructions(F))) {
+    if (auto *CI = dyn_cast<CallInst>(&I)) {
+      if (!lowerAtomicLibcall(CI))
+        continue;
+      Changed = true;
+    } else if (auto *CXI = dyn_cast<AtomicCmpXchgInst>(&I))
+      Changed |= lowerAtomicCmpXchgInst(CXI);
+    else if (auto *RMWI = dyn_cast<AtomicRMWInst>(&I))
+      Changed |= lowerAtomicRMWInst(RMWI);
+    else if (auto *LI = dyn_cast<LoadInst>(&I)) {
+      if (!LI->isAtomic())
+        continue;
+      LI->setAtomic(AtomicOrdering::NotAtomic);
+      Changed = true;
+    } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+      if (!SI->isAtomic())
+        continue;
+      SI->setAtomic(AtomicOrdering::NotAtomic);
+      Changed = true;
+    } else {
+      continue;
+    }
+    ++NumLowered;
+  }
+  return Changed;
+}
+
+bool RISCVCheriotInterruptAtomics::runOnModule(Module &M) {
+  auto &TM = getAnalysis<TargetPassConfig>().getTM<RISCVTargetMachine>();
+
+  // Only single-hart CHERIoT cores without native atomics benefit.
+  auto NeedsLowering = [&](const Function &F) {
+    const auto &ST = TM.getSubtarget<RISCVSubtarget>(F);
+    return ST.getTargetABI() == RISCVABI::ABI_CHERIOT && !ST.hasStdExtA();
+  };
+  if (none_of(M, [&](const Function &F) {
+        return !F.isDeclaration() && NeedsLowering(F);
+      }))
+    return false;
+
+  bool Changed = false;
+  for (const Function *F : getInterruptsDisabledFunctions(M))
+    if (NeedsLowering(*F))
+      Changed |= lowerAtomics(const_cast<Function &>(*F));
+  return Changed;
+}
+
+char RISCVCheriotInterruptAtomics::ID = 0;
+
+INITIALIZE_PASS_BEGIN(RISCVCheriotInterruptAtomics, DEBUG_TYPE,
+                      "RISCV CHERIoT interrupts-disabled atomic lowering",
+                      false, false)
+INITIALIZE_PASS_DEPENDENCY(TargetPassConfig)
+INITIALIZE_PASS_END(RISCVCheriotInterruptAtomics, DEBUG_TYPE,
+                    "RISCV CHERIoT interrupts-disabled atomic lowering", false,
+                    false)
+
+ModulePass *llvm::createRISCVCheriotInterruptAtomicsPass() {
+  return new RISCVCheriotInterruptAtomics();
+}
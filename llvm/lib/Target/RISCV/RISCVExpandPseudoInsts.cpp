@@ -20,6 +20,7 @@
 
 #include "llvm/CodeGen/LivePhysRegs.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/CodeGen/MachineConstantPool.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/CodeGen/MachineOperand.h"
@@ -604,6 +605,17 @@ bool RISCVExpandPseudo::expandAuipccInstPair(
     BuildMI(NewMBB, DL, TII->get(RISCV::CSetBoundsImm), DestReg)
         .addReg(DestReg)
         .addDisp(Symbol, 0, RISCVII::MO_CHERIOT_COMPARTMENT_SIZE);
+  // Constant pool labels have no symbol size, so bound the capability to the
+  // pool entry directly.
+  if (!InBounds && IsCheriot && Symbol.isCPI()) {
+    const MachineConstantPoolEntry &CPE =
+        MF->getConstantPool()->getConstants()[Symbol.getIndex()];
+    unsigned Size = CPE.getSizeInBytes(MF->getDataLayout());
+    assert(isUInt<12>(Size) && "Constant pool entry too large to bound");
+    BuildMI(NewMBB, DL, TII->get(RISCV::CSetBoundsImm), DestReg)
+        .addReg(DestReg)
+        .addImm(Size);
+  }
 
   // Move all the rest of the instructions to NewMBB.
   NewMBB->splice(NewMBB->end(), &MBB, std::next(MBBI), MBB.end());
@@ -628,6 +640,11 @@ bool RISCVExpandPseudo::expandCapLoadLocalCap(
       RISCVABI::ABI_CHERIOT) {
     const DebugLoc DL = MBBI->getDebugLoc();
     const MachineOperand &Symbol = MBBI->getOperand(1);
+    // Literal pool entries are read-only data within PCC bounds.
+    if (Symbol.isCPI())
+      return expandAuipccInstPair(MBB, MBBI, NextMBBI,
+                                  RISCVII::MO_CHERIOT_COMPARTMENT_HI,
+                                  RISCV::CIncOffsetImm, InBounds);
     const GlobalValue *GV = Symbol.getGlobal();
     if (isa<Function>(GV) || cast<GlobalVariable>(GV)->isConstant()) {
       if (auto *Fn = dyn_cast<Function>(GV)) {
@@ -137,12 +137,20 @@ static int getLibCallID(const MachineFunction &MF,
   if (CSI.empty() || !RVFI->useSaveRestoreLibCalls(MF))
     return -1;
 
+  const TargetRegisterInfo *TRI = MF.getSubtarget().getRegisterInfo();
   Register MaxReg = RISCV::NoRegister;
-  for (auto &CS : CSI)
+  for (auto &CS : CSI) {
     // RISCVRegisterInfo::hasReservedSpillSlot assigns negative frame indexes to
     // registers which can be saved by libcall.
-    if (CS.getFrameIdx() < 0)
-      MaxReg = std::max(MaxReg.id(), CS.getReg().id());
+    if (CS.getFrameIdx() >= 0)
+      continue;
+    // The capability libcalls save the whole capability register, which
+    // occupies the same slot as its address subregister.
+    Register Reg = CS.getReg();
+    if (RISCV::GPCRRegClass.contains(Reg))
+      Reg = TRI->getSubReg(Reg, RISCV::sub_cap_addr);
+    MaxReg = std::max(MaxReg.id(), Reg.id());
+  }
 
   if (MaxReg == RISCV::NoRegister)
     return -1;
@@ -187,9 +195,28 @@ getSpillLibCallName(const MachineFunction &MF,
     "__riscv_save_12"
   };
 
+  static const char *const CapSpillLibCalls[] = {
+    "__riscv_save_cap_0",
+    "__riscv_save_cap_1",
+    "__riscv_save_cap_2",
+    "__riscv_save_cap_3",
+    "__riscv_save_cap_4",
+    "__riscv_save_cap_5",
+    "__riscv_save_cap_6",
+    "__riscv_save_cap_7",
+    "__riscv_save_cap_8",
+    "__riscv_save_cap_9",
+    "__riscv_save_cap_10",
+    "__riscv_save_cap_11",
+    "__riscv_save_cap_12"
+  };
+
   int LibCallID = getLibCallID(MF, CSI);
   if (LibCallID == -1)
     return nullptr;
+  const auto &STI = MF.getSubtarget<RISCVSubtarget>();
+  if (RISCVABI::isCheriPureCapABI(STI.getTargetABI()))
+    return CapSpillLibCalls[LibCallID];
   return SpillLibCalls[LibCallID];
 }
 
@@ -214,12 +241,39 @@ getRestoreLibCallName(const MachineFunction &MF,
     "__riscv_restore_12"
   };
 
+  static const char *const CapRestoreLibCalls[] = {
+    "__riscv_restore_cap_0",
+    "__riscv_restore_cap_1",
+    "__riscv_restore_cap_2",
+    "__riscv_restore_cap_3",
+    "__riscv_restore_cap_4",
+    "__riscv_restore_cap_5",
+    "__riscv_restore_cap_6",
+    "__riscv_restore_cap_7",
+    "__riscv_restore_cap_8",
+    "__riscv_restore_cap_9",
+    "__riscv_restore_cap_10",
+    "__riscv_restore_cap_11",
+    "__riscv_restore_cap_12"
+  };
+
   int LibCallID = getLibCallID(MF, CSI);
   if (LibCallID == -1)
     return nullptr;
+  const auto &STI = MF.getSubtarget<RISCVSubtarget>();
+  if (RISCVABI::isCheriPureCapABI(STI.getTargetABI()))
+    return CapRestoreLibCalls[LibCallID];
   return RestoreLibCalls[LibCallID];
 }
 
+// Get the size of each slot in the frame managed by the save/restore libcalls.
+// The purecap libcalls save whole capability registers.
+static int64_t getLibCallSlotSize(const RISCVSubtarget &STI) {
+  if (RISCVABI::isCheriPureCapABI(STI.getTargetABI()))
+    return STI.getRegisterInfo()->getSpillSize(RISCV::GPCRRegClass);
+  return STI.getXLen() / 8;
+}
+
 bool RISCVFrameLowering::hasFP(const MachineFunction &MF) const {
   const TargetRegisterInfo *RegInfo = MF.getSubtarget().getRegisterInfo();
 
@@ -383,6 +437,13 @@ void RISCVFrameLowering::emitPrologue(MachineFunction &MF,
     // out into a helper function, but they're also rare (returning on-stack
     // structures or taking many arguments are both generally a bad idea for
     // cross-compartment calls).
+    //
+    // The checks must run before the callee can use either capability, so
+    // they always go at the start of the entry block, even if shrink-wrapping
+    // has moved the rest of the prologue.  Nothing has been spilled at that
+    // point, so the failure path can return directly.
+    MachineBasicBlock &EntryMBB = MF.front();
+    MachineBasicBlock::iterator EntryMBBI = EntryMBB.begin();
     MachineBasicBlock *failMBB = nullptr;
     auto createFailMBB = [&]() {
       if (failMBB != nullptr)
@@ -401,49 +462,49 @@ void RISCVFrameLowering::emitPrologue(MachineFunction &MF,
       BuildMI(*failMBB, failMBBI, DL, TII->get(RISCV::PseudoCRET))
           .addReg(RISCV::X10, RegState::Implicit)
           .addReg(RISCV::X11, RegState::Implicit);
-      MBB.addSuccessor(failMBB);
+      EntryMBB.addSuccessor(failMBB);
     };
     auto createChecks = [&](unsigned Reg, uint64_t Size) {
       createFailMBB();
       // x6 (t1) and x7 (t2) are unused in the prolog, so we can use them
       // here without any problems.
       // Check that the base is equal to the start
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::CGetAddr))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::CGetAddr))
           .addDef(RISCV::X6)
           .addReg(Reg);
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::CGetBase))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::CGetBase))
           .addDef(RISCV::X7)
           .addReg(Reg);
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::BNE))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::BNE))
           .addDef(RISCV::X6)
           .addReg(RISCV::X7)
           .addMBB(failMBB);
       // Check that the base is above the current stack pointer.
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::BLT))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::BLT))
           .addReg(RISCV::X6)
           .addReg(RISCV::X2) // sp
           .addMBB(failMBB);
       // Check that the length is at least the expected size
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::CGetLen))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::CGetLen))
           .addDef(RISCV::X6)
           .addReg(Reg);
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::ADDI))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::ADDI))
           .addDef(RISCV::X7)
           .addReg(RISCV::X0)
           .addImm(Size);
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::BLT))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::BLT))
           .addReg(RISCV::X6)
           .addReg(RISCV::X7)
           .addMBB(failMBB);
       // Check that we have the expected permissions
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::CGetPerm))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::CGetPerm))
           .addDef(RISCV::X6)
           .addReg(Reg);
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::ADDI))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::ADDI))
           .addDef(RISCV::X7)
           .addReg(RISCV::X0)
           .addImm(0x7e); // RWclgm permissions.
-      BuildMI(MBB, MBBI, DL, TII->get(RISCV::BNE))
+      BuildMI(EntryMBB, EntryMBBI, DL, TII->get(RISCV::BNE))
           .addReg(RISCV::X6)
           .addReg(RISCV::X7)
           .addMBB(failMBB);
@@ -493,7 +554,8 @@ void RISCVFrameLowering::emitPrologue(MachineFunction &MF,
   if (int LibCallRegs = getLibCallID(MF, MFI.getCalleeSavedInfo()) + 1) {
     // Calculate the size of the frame managed by the libcall. The libcalls are
     // implemented such that the stack will always be 16 byte aligned.
-    unsigned LibCallFrameSize = alignTo((STI.getXLen() / 8) * LibCallRegs, 16);
+    unsigned LibCallFrameSize =
+        alignTo(getLibCallSlotSize(STI) * LibCallRegs, 16);
     RVFI->setLibCallStackSize(LibCallFrameSize);
   }
 
@@ -548,7 +610,7 @@ void RISCVFrameLowering::emitPrologue(MachineFunction &MF,
     // Offsets for objects with fixed locations (IE: those saved by libcall) are
     // simply calculated from the frame index.
     if (FrameIdx < 0)
-      Offset = FrameIdx * (int64_t) STI.getXLen() / 8;
+      Offset = FrameIdx * getLibCallSlotSize(STI);
     else
       Offset = MFI.getObjectOffset(Entry.getFrameIdx()) -
                RVFI->getLibCallStackSize();
@@ -1178,12 +1240,15 @@ bool RISCVFrameLowering::spillCalleeSavedRegisters(
 
   const char *SpillLibCall = getSpillLibCallName(*MF, CSI);
   if (SpillLibCall) {
-    assert(!RISCVABI::isCheriPureCapABI(STI.getTargetABI()) &&
-           "Save/restore libcall not implemented for purecap");
-    // Add spill libcall via non-callee-saved register t0.
-    BuildMI(MBB, MI, DL, TII.get(RISCV::PseudoCALLReg), RISCV::X5)
-        .addExternalSymbol(SpillLibCall, RISCVII::MO_CALL)
-        .setMIFlag(MachineInstr::FrameSetup);
+    // Add spill libcall via non-callee-saved register t0 (ct0 for purecap).
+    if (RISCVABI::isCheriPureCapABI(STI.getTargetABI()))
+      BuildMI(MBB, MI, DL, TII.get(RISCV::PseudoCCALLReg), RISCV::C5)
+          .addExternalSymbol(SpillLibCall, RISCVII::MO_CALL)
+          .setMIFlag(MachineInstr::FrameSetup);
+    else
+      BuildMI(MBB, MI, DL, TII.get(RISCV::PseudoCALLReg), RISCV::X5)
+          .addExternalSymbol(SpillLibCall, RISCVII::MO_CALL)
+          .setMIFlag(MachineInstr::FrameSetup);
 
     // Add registers spilled in libcall as liveins.
     for (auto &CS : CSI)
@@ -1232,17 +1297,18 @@ bool RISCVFrameLowering::restoreCalleeSavedRegisters(
 
   const char *RestoreLibCall = getRestoreLibCallName(*MF, CSI);
   if (RestoreLibCall) {
-    assert(!RISCVABI::isCheriPureCapABI(STI.getTargetABI()) &&
-           "Save/restore libcall not implemented for purecap");
+    bool IsPureCap = RISCVABI::isCheriPureCapABI(STI.getTargetABI());
     // Add restore libcall via tail call.
     MachineBasicBlock::iterator NewMI =
-        BuildMI(MBB, MI, DL, TII.get(RISCV::PseudoTAIL))
+        BuildMI(MBB, MI, DL,
+                TII.get(IsPureCap ? RISCV::PseudoCTAIL : RISCV::PseudoTAIL))
             .addExternalSymbol(RestoreLibCall, RISCVII::MO_CALL)
             .setMIFlag(MachineInstr::FrameDestroy);
 
     // Remove trailing returns, since the terminator is now a tail call to the
     // restore function.
-    if (MI != MBB.end() && MI->getOpcode() == RISCV::PseudoRET) {
+    if (MI != MBB.end() &&
+        MI->getOpcode() == (IsPureCap ? RISCV::PseudoCRET : RISCV::PseudoRET)) {
       NewMI->copyImplicitOps(*MF, *MI);
       MI->eraseFromParent();
     }
@@ -1251,6 +1317,19 @@ bool RISCVFrameLowering::restoreCalleeSavedRegisters(
   return true;
 }
 
+bool RISCVFrameLowering::enableShrinkWrapping(
+    const MachineFunction &MF) const {
+  // Keep the conventional code flow when not optimizing.
+  if (MF.getFunction().hasOptNone())
+    return false;
+
+  // CHERIoT callee-saved registers are capabilities, so every spill and
+  // reload moves twice as much data as on a plain RV32E core.  Compartment
+  // entry points often return early after argument or permission checks, and
+  // shrink-wrapping lets those paths skip the spills entirely.
+  return STI.getTargetABI() == RISCVABI::ABI_CHERIOT;
+}
+
 bool RISCVFrameLowering::canUseAsPrologue(const MachineBasicBlock &MBB) const {
   MachineBasicBlock *TmpMBB = const_cast<MachineBasicBlock *>(&MBB);
   const MachineFunction *MF = MBB.getParent();
@@ -1260,8 +1339,8 @@ bool RISCVFrameLowering::canUseAsPrologue(const MachineBasicBlock &MBB) const {
     return true;
 
   // Inserting a call to a __riscv_save libcall requires the use of the register
-  // t0 (X5) to hold the return address. Therefore if this register is already
-  // used we can't insert the call.
+  // t0 (X5, or C5 for purecap) to hold the return address. Therefore if this
+  // register is already used we can't insert the call.
 
   RegScavenger RS;
   RS.enterBasicBlock(*TmpMBB);
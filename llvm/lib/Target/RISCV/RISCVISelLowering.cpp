@@ -50,6 +50,18 @@ static cl::opt<bool>
                                            "pure-capability function calls"),
                                   cl::init(false), cl::Hidden);
 
+static cl::opt<bool> DisableIntLiteralPool(
+    "riscv-disable-int-literal-pool",
+    cl::desc("Never load repeated integer constants from the constant pool "
+             "on CHERIoT"),
+    cl::init(false), cl::Hidden);
+
+static cl::opt<unsigned> LiteralPoolAddrCost(
+    "riscv-literal-pool-addr-cost",
+    cl::desc("Number of instructions assumed to materialise the address of a "
+             "constant pool entry once per function"),
+    cl::init(2), cl::Hidden);
+
 RISCVTargetLowering::RISCVTargetLowering(const TargetMachine &TM,
                                          const RISCVSubtarget &STI)
     : TargetLowering(TM), Subtarget(STI) {
@@ -419,6 +431,11 @@ RISCVTargetLowering::RISCVTargetLowering(const TargetMachine &TM,
 
   setOperationAction(ISD::GlobalTLSAddress, XLenVT, Custom);
 
+  // CHERIoT read-only data is within PCC bounds, so constants that are used
+  // repeatedly can be loaded PC-relative from a per-function literal pool.
+  if (ABI == RISCVABI::ABI_CHERIOT && !DisableIntLiteralPool)
+    setOperationAction(ISD::Constant, XLenVT, Custom);
+
   if (Subtarget.hasCheri()) {
     MVT CLenVT = Subtarget.typeForCapabilities();
     setOperationAction(ISD::BR_CC, CLenVT, Expand);
@@ -449,6 +466,9 @@ RISCVTargetLowering::RISCVTargetLowering(const TargetMachine &TM,
   // pass.
   if (Subtarget.hasCheri())
     setTargetDAGCombine(ISD::INTRINSIC_WO_CHAIN);
+  // Fold capability address round trips created by ptrtoint/inttoptr.
+  if (RISCVABI::isCheriPureCapABI(ABI))
+    setTargetDAGCombine(ISD::PTRTOINT);
 
   if (Subtarget.hasStdExtA()) {
     setMaxAtomicSizeInBitsSupported(Subtarget.getXLen());
@@ -2145,11 +2165,65 @@ SDValue RISCVTargetLowering::expandUnalignedRVVStore(SDValue Op,
                       Store->getMemOperand()->getFlags());
 }
 
+// Decides whether an integer constant should be materialised inline or loaded
+// from the constant pool.  Returns Op to keep it inline, or an empty SDValue to
+// let the legalizer expand it into a constant pool load.
+static SDValue lowerConstant(SDValue Op, SelectionDAG &DAG,
+                             const RISCVSubtarget &Subtarget) {
+  auto *CN = cast<ConstantSDNode>(Op);
+  int64_t Imm = CN->getSExtValue();
+  // Constants that a single instruction can build, including all the ones
+  // used as immediate operands, are never worth a load.
+  RISCVMatInt::InstSeq Seq =
+      RISCVMatInt::generateInstSeq(Imm, Subtarget.getFeatureBits());
+  if (Seq.size() <= 1 || DAG.getTarget().getOptLevel() == CodeGenOpt::None)
+    return Op;
+
+  // The pool entry is shared by the whole function.  Its address is built in
+  // each block that loads it, but RISCVCheriCleanupOpt then keeps a single
+  // copy in a block that dominates them all, which only happens when
+  // optimising.  Inline, the constant is built once per basic block that uses
+  // it, since each block is selected as one DAG.  So count the blocks that use
+  // the same constant.  ConstantInts are uniqued per
+  // context and may be used all over the module, so walk this function once
+  // instead of each constant's users.  Constants created during lowering have
+  // no IR uses and are costed as used once.
+  MachineFunction &MF = DAG.getMachineFunction();
+  auto *RVFI = MF.getInfo<RISCVMachineFunctionInfo>();
+  DenseMap<const ConstantInt *, unsigned> &Uses = RVFI->getIntConstantUses();
+  if (!RVFI->hasCountedIntConstantUses()) {
+    SmallPtrSet<const ConstantInt *, 8> Seen;
+    for (const BasicBlock &BB : MF.getFunction()) {
+      Seen.clear();
+      for (const Instruction &I : BB)
+        for (const Value *V : I.operand_values())
+          if (const auto *CI = dyn_cast<ConstantInt>(V))
+            if (Seen.insert(CI).second)
+              ++Uses[CI];
+    }
+    RVFI->setCountedIntConstantUses();
+  }
+  unsigned NumUses = std::max(1u, Uses.lookup(CN->getConstantIntValue()));
+
+  // A pool load is one instruction, but it adds load latency to every use, so
+  // only accept it when optimising for size unless the inline sequence is
+  // longer than the load.
+  unsigned InlineCost = Seq.size() * NumUses;
+  unsigned LoadCost = DAG.shouldOptForSize() ? 1 : 2;
+  unsigned PoolCost = LiteralPoolAddrCost + LoadCost * NumUses;
+  if (PoolCost >= InlineCost)
+    return Op;
+
+  return SDValue();
+}
+
 SDValue RISCVTargetLowering::LowerOperation(SDValue Op,
                                             SelectionDAG &DAG) const {
   switch (Op.getOpcode()) {
   default:
     report_fatal_error("unimplemented operand");
+  case ISD::Constant:
+    return lowerConstant(Op, DAG, Subtarget);
   case ISD::GlobalAddress:
     return lowerGlobalAddress(Op, DAG);
   case ISD::BlockAddress:
@@ -6017,6 +6091,54 @@ static SDValue performANY_EXTENDCombine(SDNode *N,
   return SDValue(N, 0);
 }
 
+// Returns true if V is the address of the capability Cap: either an explicit
+// cheri.cap.address.get, or a ptrtoint in the pure-capability ABI, where it is
+// lowered to cgetaddr.
+static bool isCapAddressOf(SDValue V, SDValue Cap,
+                           const RISCVSubtarget &Subtarget) {
+  if (V.getOpcode() == ISD::PTRTOINT)
+    return RISCVABI::isCheriPureCapABI(Subtarget.getTargetABI()) &&
+           V.getOperand(0) == Cap;
+  return V.getOpcode() == ISD::INTRINSIC_WO_CHAIN &&
+         V.getConstantOperandVal(0) == Intrinsic::cheri_cap_address_get &&
+         V.getOperand(1) == Cap;
+}
+
+// Folds setaddr(x, getaddr(x)) -> x and setoffset(x, getoffset(x)) -> x, which
+// is what InstSimplify does for the same pattern in IR.  These round trips are
+// commonly created by the lowering of address space casts and ptrtoint/inttoptr
+// pairs, and cost a csetaddr and an extra live register when left in place.
+static SDValue combineCapSetOfGet(SDNode *N, unsigned IID,
+                                  const RISCVSubtarget &Subtarget) {
+  SDValue Cap = N->getOperand(1);
+  SDValue Val = N->getOperand(2);
+  if (IID == Intrinsic::cheri_cap_address_set)
+    return isCapAddressOf(Val, Cap, Subtarget) ? Cap : SDValue();
+  if (Val.getOpcode() == ISD::INTRINSIC_WO_CHAIN &&
+      Val.getConstantOperandVal(0) == Intrinsic::cheri_cap_offset_get &&
+      Val.getOperand(1) == Cap)
+    return Cap;
+  return SDValue();
+}
+
+// Folds the address of a capability whose address was just set back to the
+// integer it was set from: getaddr(setaddr(x, a)) -> a, and in the
+// pure-capability ABI, where inttoptr derives from the null capability,
+// getaddr(inttoptr(a)) -> a.
+static SDValue combineCapAddressGet(SDNode *N, SDValue Cap,
+                                    const RISCVSubtarget &Subtarget) {
+  SDValue Addr;
+  if (Cap.getOpcode() == ISD::INTRINSIC_WO_CHAIN &&
+      Cap.getConstantOperandVal(0) == Intrinsic::cheri_cap_address_set)
+    Addr = Cap.getOperand(2);
+  else if (Cap.getOpcode() == ISD::INTTOPTR &&
+           RISCVABI::isCheriPureCapABI(Subtarget.getTargetABI()))
+    Addr = Cap.getOperand(0);
+  if (!Addr || Addr.getValueType() != N->getValueType(0))
+    return SDValue();
+  return Addr;
+}
+
 SDValue RISCVTargetLowering::PerformDAGCombine(SDNode *N,
                                                DAGCombinerInfo &DCI) const {
   SelectionDAG &DAG = DCI.DAG;
@@ -6064,6 +6186,15 @@ SDValue RISCVTargetLowering::PerformDAGCombine(SDNode *N,
       return DAG.getSetCC(DL, MVT::i1, IntRes,
                           DAG.getConstant(0, DL, XLenVT), ISD::SETNE);
     }
+    case Intrinsic::cheri_cap_address_set:
+    case Intrinsic::cheri_cap_offset_set:
+      if (SDValue V = combineCapSetOfGet(N, IID, Subtarget))
+        return V;
+      break;
+    case Intrinsic::cheri_cap_address_get:
+      if (SDValue V = combineCapAddressGet(N, N->getOperand(1), Subtarget))
+        return V;
+      break;
     // Constant fold CRRL/CRAM when possible
     case Intrinsic::cheri_round_representable_length: {
       KnownBits Known = DAG.computeKnownBits(SDValue(N, 0));
@@ -6081,6 +6212,12 @@ SDValue RISCVTargetLowering::PerformDAGCombine(SDNode *N,
 
     break;
   }
+  case ISD::PTRTOINT:
+    if (RISCVABI::isCheriPureCapABI(Subtarget.getTargetABI()) &&
+        N->getOperand(0).getValueType().isFatPointer())
+      if (SDValue V = combineCapAddressGet(N, N->getOperand(0), Subtarget))
+        return V;
+    break;
   case RISCVISD::SplitF64: {
     SDValue Op0 = N->getOperand(0);
     // If the input to SplitF64 is just BuildPairF64 then the operation is
@@ -7406,7 +7543,7 @@ static unsigned allocateRVVReg(MVT ValVT, unsigned ValNo,
 }
 
 // Implements the RISC-V calling convention. Returns true upon failure.
-static bool CC_RISCV(const DataLayout &DL, RISCVABI::ABI ABI, unsigned ValNo,
+bool RISCV::CC_RISCV(const DataLayout &DL, RISCVABI::ABI ABI, unsigned ValNo,
                      MVT ValVT, MVT LocVT, CCValAssign::LocInfo LocInfo,
                      ISD::ArgFlagsTy ArgFlags, CCState &State, bool IsFixed,
                      bool IsRet, Type *OrigTy, const RISCVTargetLowering &TLI,
@@ -8095,7 +8232,7 @@ SDValue RISCVTargetLowering::LowerFormalArguments(
   else
     analyzeInputArgs(MF, CCInfo, Ins, /*IsRet=*/false,
                      CallConv == CallingConv::Fast ? CC_RISCV_FastCC
-                                                   : CC_RISCV);
+                                                   : RISCV::CC_RISCV);
 
   uint64_t stackArgumentSize = 0;
   for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
@@ -8336,7 +8473,7 @@ SDValue RISCVTargetLowering::LowerCall(CallLoweringInfo &CLI,
   else
     analyzeOutputArgs(MF, ArgCCInfo, Outs, /*IsRet=*/false, &CLI,
                       CallConv == CallingConv::Fast ? CC_RISCV_FastCC
-                                                    : CC_RISCV);
+                                                    : RISCV::CC_RISCV);
 
   // Check if it's really possible to do a tail call.
   if (IsTailCall)
@@ -8649,7 +8786,7 @@ SDValue RISCVTargetLowering::LowerCall(CallLoweringInfo &CLI,
   // Assign locations to each value returned by this call.
   SmallVector<CCValAssign, 16> RVLocs;
   CCState RetCCInfo(CallConv, IsVarArg, MF, RVLocs, *DAG.getContext());
-  analyzeInputArgs(MF, RetCCInfo, Ins, /*IsRet=*/true, CC_RISCV);
+  analyzeInputArgs(MF, RetCCInfo, Ins, /*IsRet=*/true, RISCV::CC_RISCV);
 
   auto ArgGPRs { Subtarget.isRV32E() ? ArrayRef<MCPhysReg>{ArgGPRsE} :
       ArrayRef<MCPhysReg>{ArgGPRsFull} };
@@ -8695,9 +8832,9 @@ bool RISCVTargetLowering::CanLowerReturn(
     MVT VT = Outs[i].VT;
     ISD::ArgFlagsTy ArgFlags = Outs[i].Flags;
     RISCVABI::ABI ABI = MF.getSubtarget<RISCVSubtarget>().getTargetABI();
-    if (CC_RISCV(MF.getDataLayout(), ABI, i, VT, VT, CCValAssign::Full,
-                 ArgFlags, CCInfo, /*IsFixed=*/true, /*IsRet=*/true, nullptr,
-                 *this, FirstMaskArgument))
+    if (RISCV::CC_RISCV(MF.getDataLayout(), ABI, i, VT, VT, CCValAssign::Full,
+                        ArgFlags, CCInfo, /*IsFixed=*/true, /*IsRet=*/true,
+                        nullptr, *this, FirstMaskArgument))
       return false;
   }
   return true;
@@ -8720,7 +8857,7 @@ RISCVTargetLowering::LowerReturn(SDValue Chain, CallingConv::ID CallConv,
                  *DAG.getContext());
 
   analyzeOutputArgs(DAG.getMachineFunction(), CCInfo, Outs, /*IsRet=*/true,
-                    nullptr, CC_RISCV);
+                    nullptr, RISCV::CC_RISCV);
 
   if (CallConv == CallingConv::GHC && !RVLocs.empty())
     report_fatal_error("GHC functions return void only");
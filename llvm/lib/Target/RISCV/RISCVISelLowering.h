@@ -640,6 +640,14 @@ private:
 namespace RISCV {
 // We use 64 bits as the known part in the scalable vector types.
 static constexpr unsigned RVVBitsPerBlock = 64;
+
+// Implements the RISC-V calling convention, including the CHERI purecap
+// ABIs. Returns true upon failure. Also used by GlobalISel call lowering.
+bool CC_RISCV(const DataLayout &DL, RISCVABI::ABI ABI, unsigned ValNo,
+              MVT ValVT, MVT LocVT, CCValAssign::LocInfo LocInfo,
+              ISD::ArgFlagsTy ArgFlags, CCState &State, bool IsFixed,
+              bool IsRet, Type *OrigTy, const RISCVTargetLowering &TLI,
+              Optional<unsigned> FirstMaskArgument);
 } // namespace RISCV
 
 namespace RISCVVIntrinsicsTable {
@@ -16,6 +16,8 @@
 #include "RISCVTargetMachine.h"
 #include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
 #include "llvm/CodeGen/GlobalISel/InstructionSelectorImpl.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/IR/IntrinsicsRISCV.h"
 #include "llvm/Support/Debug.h"
 
@@ -41,6 +43,15 @@ public:
 private:
   bool selectImpl(MachineInstr &I, CodeGenCoverage &CoverageInfo) const;
 
+  const TargetRegisterClass *getRegClassForBank(const RegisterBank &RB) const;
+  bool isCapability(Register Reg, const MachineRegisterInfo &MRI) const;
+  bool selectCopy(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectConstant(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectFrameIndex(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectPtrAdd(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectCapLoadStore(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectCheriIntrinsic(MachineInstr &I, MachineRegisterInfo &MRI) const;
+
   const RISCVSubtarget &STI;
   const RISCVInstrInfo &TII;
   const RISCVRegisterInfo &TRI;
@@ -81,13 +92,248 @@ RISCVInstructionSelector::RISCVInstructionSelector(
 {
 }
 
+const TargetRegisterClass *
+RISCVInstructionSelector::getRegClassForBank(const RegisterBank &RB) const {
+  if (RB.getID() == RISCV::GPCRRegBankID)
+    return &RISCV::GPCRRegClass;
+  return &RISCV::GPRRegClass;
+}
+
+bool RISCVInstructionSelector::isCapability(
+    Register Reg, const MachineRegisterInfo &MRI) const {
+  return RBI.getRegBank(Reg, MRI, TRI)->getID() == RISCV::GPCRRegBankID;
+}
+
+bool RISCVInstructionSelector::selectCopy(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  for (const MachineOperand &MO : I.operands()) {
+    Register Reg = MO.getReg();
+    if (Reg.isPhysical() || MRI.getRegClassOrNull(Reg))
+      continue;
+    const RegisterBank *RB = RBI.getRegBank(Reg, MRI, TRI);
+    if (!RB || !RBI.constrainGenericRegister(Reg, *getRegClassForBank(*RB),
+                                             MRI))
+      return false;
+  }
+  return true;
+}
+
+bool RISCVInstructionSelector::selectConstant(MachineInstr &I,
+                                              MachineRegisterInfo &MRI) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  Register DstReg = I.getOperand(0).getReg();
+  const MachineOperand &Imm = I.getOperand(1);
+
+  if (isCapability(DstReg, MRI)) {
+    // The only capability constant is the null capability.
+    if (!Imm.getCImm()->isZero())
+      return false;
+    BuildMI(MBB, I, I.getDebugLoc(), TII.get(TargetOpcode::COPY), DstReg)
+        .addReg(RISCV::C0);
+    I.eraseFromParent();
+    return RBI.constrainGenericRegister(DstReg, RISCV::GPCRRegClass, MRI);
+  }
+
+  int64_t Val = Imm.getCImm()->getSExtValue();
+  if (!isInt<12>(Val))
+    return false;
+  BuildMI(MBB, I, I.getDebugLoc(), TII.get(RISCV::ADDI), DstReg)
+      .addReg(RISCV::X0)
+      .addImm(Val);
+  I.eraseFromParent();
+  return RBI.constrainGenericRegister(DstReg, RISCV::GPRRegClass, MRI);
+}
+
+bool RISCVInstructionSelector::selectFrameIndex(
+    MachineInstr &I, MachineRegisterInfo &MRI) const {
+  Register DstReg = I.getOperand(0).getReg();
+  if (!isCapability(DstReg, MRI))
+    return false;
+  I.setDesc(TII.get(RISCV::CIncOffsetImm));
+  I.addOperand(MachineOperand::CreateImm(0));
+  return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
+}
+
+bool RISCVInstructionSelector::selectPtrAdd(MachineInstr &I,
+                                            MachineRegisterInfo &MRI) const {
+  Register DstReg = I.getOperand(0).getReg();
+  if (!isCapability(DstReg, MRI))
+    return false;
+
+  // Fold small constant offsets into the immediate form.
+  Register OffsetReg = I.getOperand(2).getReg();
+  if (Optional<int64_t> Offset = getConstantVRegSExtVal(OffsetReg, MRI)) {
+    if (isInt<12>(*Offset)) {
+      I.setDesc(TII.get(RISCV::CIncOffsetImm));
+      I.getOperand(2).ChangeToImmediate(*Offset);
+      return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
+    }
+  }
+  I.setDesc(TII.get(RISCV::CIncOffset));
+  return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
+}
+
+bool RISCVInstructionSelector::selectCapLoadStore(
+    MachineInstr &I, MachineRegisterInfo &MRI) const {
+  Register ValReg = I.getOperand(0).getReg();
+  Register PtrReg = I.getOperand(1).getReg();
+  if (!isCapability(PtrReg, MRI) || !I.hasOneMemOperand())
+    return false;
+
+  unsigned GenericOpc = I.getOpcode();
+  bool IsStore = GenericOpc == TargetOpcode::G_STORE;
+  bool IsZExt = GenericOpc == TargetOpcode::G_ZEXTLOAD;
+  unsigned Opc = 0;
+  if (isCapability(ValReg, MRI)) {
+    if (STI.is64Bit())
+      Opc = IsStore ? RISCV::CSC_128 : RISCV::CLC_128;
+    else
+      Opc = IsStore ? RISCV::CSC_64 : RISCV::CLC_64;
+  } else {
+    switch ((*I.memoperands_begin())->getSize()) {
+    default:
+      return false;
+    case 1:
+      Opc = IsStore ? RISCV::CSB : IsZExt ? RISCV::CLBU : RISCV::CLB;
+      break;
+    case 2:
+      Opc = IsStore ? RISCV::CSH : IsZExt ? RISCV::CLHU : RISCV::CLH;
+      break;
+    case 4:
+      Opc = IsStore ? RISCV::CSW
+                    : (IsZExt && STI.is64Bit()) ? RISCV::CLWU : RISCV::CLW;
+      break;
+    case 8:
+      if (!STI.is64Bit())
+        return false;
+      Opc = IsStore ? RISCV::CSD : RISCV::CLD;
+      break;
+    }
+  }
+
+  I.setDesc(TII.get(Opc));
+  I.addOperand(MachineOperand::CreateImm(0));
+  return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
+}
+
+// Returns the instruction implementing a CHERI intrinsic whose operands map
+// one-to-one onto the instruction operands, or 0 if there is none.
+static unsigned getCheriIntrinsicOpcode(Intrinsic::ID IID) {
+  switch (IID) {
+  default:
+    return 0;
+  case Intrinsic::cheri_cap_perms_get:
+    return RISCV::CGetPerm;
+  case Intrinsic::cheri_cap_type_get:
+    return RISCV::CGetType;
+  case Intrinsic::cheri_cap_base_get:
+    return RISCV::CGetBase;
+  case Intrinsic::cheri_cap_length_get:
+    return RISCV::CGetLen;
+  case Intrinsic::cheri_cap_offset_get:
+    return RISCV::CGetOffset;
+  case Intrinsic::cheri_cap_flags_get:
+    return RISCV::CGetFlags;
+  case Intrinsic::cheri_cap_address_get:
+    return RISCV::CGetAddr;
+  case Intrinsic::cheri_cap_seal:
+    return RISCV::CSeal;
+  case Intrinsic::cheri_cap_unseal:
+    return RISCV::CUnseal;
+  case Intrinsic::cheri_cap_perms_and:
+    return RISCV::CAndPerm;
+  case Intrinsic::cheri_cap_flags_set:
+    return RISCV::CSetFlags;
+  case Intrinsic::cheri_cap_offset_set:
+    return RISCV::CSetOffset;
+  case Intrinsic::cheri_cap_address_set:
+    return RISCV::CSetAddr;
+  case Intrinsic::cheri_cap_bounds_set:
+  case Intrinsic::cheri_bounded_stack_cap:
+  case Intrinsic::cheri_bounded_stack_cap_dynamic:
+    return RISCV::CSetBounds;
+  case Intrinsic::cheri_cap_bounds_set_exact:
+    return RISCV::CSetBoundsExact;
+  case Intrinsic::cheri_cap_tag_clear:
+    return RISCV::CClearTag;
+  case Intrinsic::cheri_cap_build:
+    return RISCV::CBuildCap;
+  case Intrinsic::cheri_cap_type_copy:
+    return RISCV::CCopyType;
+  case Intrinsic::cheri_cap_conditional_seal:
+    return RISCV::CCSeal;
+  case Intrinsic::cheri_cap_seal_entry:
+    return RISCV::CSealEntry;
+  case Intrinsic::cheri_cap_diff:
+    return RISCV::CSub;
+  case Intrinsic::cheri_cap_load_tags:
+    return RISCV::CLoadTags;
+  }
+}
+
+bool RISCVInstructionSelector::selectCheriIntrinsic(
+    MachineInstr &I, MachineRegisterInfo &MRI) const {
+  // G_INTRINSIC has a single def followed by the intrinsic ID.
+  if (I.getNumExplicitDefs() != 1)
+    return false;
+  unsigned Opc =
+      getCheriIntrinsicOpcode(Intrinsic::ID(I.getOperand(1).getIntrinsicID()));
+  if (!Opc)
+    return false;
+
+  MachineInstrBuilder MIB =
+      BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Opc),
+              I.getOperand(0).getReg());
+  for (const MachineOperand &MO : drop_begin(I.operands(), 2))
+    MIB.addReg(MO.getReg());
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(*MIB, TII, TRI, RBI);
+}
+
 bool RISCVInstructionSelector::select(MachineInstr &I) {
+  MachineRegisterInfo &MRI = I.getMF()->getRegInfo();
 
   if (!isPreISelGenericOpcode(I.getOpcode())) {
     // Certain non-generic instructions also need some special handling.
+    if (I.isCopy())
+      return selectCopy(I, MRI);
     return true;
   }
 
+  switch (I.getOpcode()) {
+  default:
+    break;
+  case TargetOpcode::G_IMPLICIT_DEF: {
+    Register DstReg = I.getOperand(0).getReg();
+    I.setDesc(TII.get(TargetOpcode::IMPLICIT_DEF));
+    return RBI.constrainGenericRegister(
+        DstReg, *getRegClassForBank(*RBI.getRegBank(DstReg, MRI, TRI)), MRI);
+  }
+  case TargetOpcode::G_ANYEXT:
+  case TargetOpcode::G_TRUNC:
+    // Both sides live in a GPR, so this is just a copy.
+    I.setDesc(TII.get(TargetOpcode::COPY));
+    return selectCopy(I, MRI);
+  case TargetOpcode::G_CONSTANT:
+    return selectConstant(I, MRI);
+  case TargetOpcode::G_FRAME_INDEX:
+    return selectFrameIndex(I, MRI);
+  case TargetOpcode::G_PTR_ADD:
+    return selectPtrAdd(I, MRI);
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_SEXTLOAD:
+  case TargetOpcode::G_ZEXTLOAD:
+  case TargetOpcode::G_STORE:
+    if (selectCapLoadStore(I, MRI))
+      return true;
+    break;
+  case TargetOpcode::G_INTRINSIC:
+  case TargetOpcode::G_INTRINSIC_W_SIDE_EFFECTS:
+    if (selectCheriIntrinsic(I, MRI))
+      return true;
+    break;
+  }
+
   if (selectImpl(I, *CoverageInfo))
     return true;
 
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "RISCVLegalizerInfo.h"
+#include "RISCVSubtarget.h"
 #include "llvm/CodeGen/TargetOpcodes.h"
 #include "llvm/CodeGen/ValueTypes.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -18,6 +19,56 @@
 
 using namespace llvm;
 
+using namespace TargetOpcode;
+using namespace LegalityPredicates;
+
 RISCVLegalizerInfo::RISCVLegalizerInfo(const RISCVSubtarget &ST) {
+  const unsigned XLen = ST.getXLen();
+  const LLT XLenLLT = LLT::scalar(XLen);
+  const LLT s8 = LLT::scalar(8);
+  const LLT s16 = LLT::scalar(16);
+  const LLT s32 = LLT::scalar(32);
+
+  // Values narrower than XLen are promoted to XLen when they are passed in
+  // registers.
+  getActionDefinitionsBuilder(G_ANYEXT)
+      .legalIf(all(typeIs(0, XLenLLT), scalarNarrowerThan(1, XLen)));
+  getActionDefinitionsBuilder(G_TRUNC)
+      .legalIf(all(typeIs(1, XLenLLT), scalarNarrowerThan(0, XLen)));
+
+  if (ST.hasCheri()) {
+    // Capabilities are fat pointers in address space 200, twice as wide as
+    // XLen.
+    const unsigned CLen = ST.typeForCapabilities().getSizeInBits();
+    const LLT CapLLT = LLT::pointer(200, CLen);
+
+    getActionDefinitionsBuilder(G_IMPLICIT_DEF).legalFor({XLenLLT, CapLLT});
+    // The only capability constant is null, which is a copy of c0.
+    getActionDefinitionsBuilder(G_CONSTANT)
+        .legalFor({XLenLLT, CapLLT})
+        .clampScalar(0, XLenLLT, XLenLLT);
+    getActionDefinitionsBuilder(G_FRAME_INDEX).legalFor({CapLLT});
+    getActionDefinitionsBuilder(G_PTR_ADD)
+        .legalFor({{CapLLT, XLenLLT}})
+        .clampScalar(1, XLenLLT, XLenLLT);
+
+    // Loads and stores through a capability. Narrow integer accesses extend
+    // to XLen in the register.
+    std::initializer_list<LegalityPredicates::TypePairAndMemDesc> CapMem = {
+        {XLenLLT, CapLLT, s8, 8},
+        {XLenLLT, CapLLT, s16, 16},
+        {XLenLLT, CapLLT, s32, 32},
+        {XLenLLT, CapLLT, XLenLLT, XLen},
+        {CapLLT, CapLLT, CapLLT, CLen}};
+    getActionDefinitionsBuilder({G_LOAD, G_STORE})
+        .legalForTypesWithMemDesc(CapMem)
+        .clampScalar(0, XLenLLT, XLenLLT);
+    getActionDefinitionsBuilder({G_SEXTLOAD, G_ZEXTLOAD})
+        .legalForTypesWithMemDesc({{XLenLLT, CapLLT, s8, 8},
+                                   {XLenLLT, CapLLT, s16, 16},
+                                   {XLenLLT, CapLLT, s32, 32}})
+        .clampScalar(0, XLenLLT, XLenLLT);
+  }
+
   getLegacyLegalizerInfo().computeTables();
 }
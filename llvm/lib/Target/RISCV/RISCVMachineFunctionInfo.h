@@ -14,6 +14,7 @@
 #define LLVM_LIB_TARGET_RISCV_RISCVMACHINEFUNCTIONINFO_H
 
 #include "RISCVSubtarget.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
 
@@ -40,6 +41,10 @@ private:
   unsigned CalleeSavedStackSize = 0;
   /// Size of on-stack arguments
   uint64_t StackArgumentSize;
+  /// Number of basic blocks using each integer constant in the IR function,
+  /// counted once for the CHERIoT literal pool.
+  DenseMap<const ConstantInt *, unsigned> IntConstantUses;
+  bool IntConstantUsesCounted = false;
 
 public:
   RISCVMachineFunctionInfo(const MachineFunction &MF) {}
@@ -79,6 +84,12 @@ public:
 
   unsigned getCalleeSavedStackSize() const { return CalleeSavedStackSize; }
   void setCalleeSavedStackSize(unsigned Size) { CalleeSavedStackSize = Size; }
+
+  bool hasCountedIntConstantUses() const { return IntConstantUsesCounted; }
+  void setCountedIntConstantUses() { IntConstantUsesCounted = true; }
+  DenseMap<const ConstantInt *, unsigned> &getIntConstantUses() {
+    return IntConstantUses;
+  }
 };
 
 } // end namespace llvm
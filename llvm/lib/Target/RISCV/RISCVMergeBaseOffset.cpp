@@ -21,6 +21,19 @@
 // 2) The lowered global address has only one use.
 //
 // The offset field can be in a different form. This pass handles all of them.
+//
+// For capability globals it transforms:
+//   cllc       cvreg1, s
+//   cincoffset cvreg2, cvreg1, Offset
+//   clw        vreg3, Imm(cvreg2)
+//
+//   Into:
+//   cllc       cvreg1, s
+//   clw        vreg3, Imm+Offset(cvreg1)
+//
+// The offset is never folded into the symbol, since the expansion of the
+// global may derive the bounds from it; the access keeps using the capability
+// for the whole global instead.
 //===----------------------------------------------------------------------===//
 
 #include "RISCV.h"
@@ -46,6 +59,8 @@ struct RISCVMergeBaseOffsetOpt : public MachineFunctionPass {
   void foldOffset(MachineInstr &HiLUI, MachineInstr &LoADDI, MachineInstr &Tail,
                   int64_t Offset);
   bool matchLargeOffset(MachineInstr &TailAdd, Register GSReg, int64_t &Offset);
+  bool detectCapGlobal(MachineInstr &CapGlobal);
+  bool foldCapOffsetIntoMemOps(MachineInstr &CapGlobal);
   RISCVMergeBaseOffsetOpt() : MachineFunctionPass(ID) {}
 
   MachineFunctionProperties getRequiredProperties() const override {
@@ -257,6 +272,104 @@ bool RISCVMergeBaseOffsetOpt::detectAndFoldOffset(MachineInstr &HiLUI,
   return false;
 }
 
+// Detect a capability global address lowering whose symbol has no offset.
+bool RISCVMergeBaseOffsetOpt::detectCapGlobal(MachineInstr &CapGlobal) {
+  switch (CapGlobal.getOpcode()) {
+  default:
+    return false;
+  case RISCV::PseudoCLLC:
+  case RISCV::PseudoCLLCInbounds:
+  case RISCV::PseudoCLGC:
+    break;
+  }
+  const MachineOperand &Symbol = CapGlobal.getOperand(1);
+  return Symbol.isGlobal() && Symbol.getOffset() == 0 &&
+         CapGlobal.getOperand(0).getReg().isVirtual();
+}
+
+static bool isCapMemOp(const MachineInstr &MI) {
+  switch (MI.getOpcode()) {
+  default:
+    return false;
+  case RISCV::CLB:
+  case RISCV::CLH:
+  case RISCV::CLW:
+  case RISCV::CLBU:
+  case RISCV::CLHU:
+  case RISCV::CLWU:
+  case RISCV::CLD:
+  case RISCV::CLC_64:
+  case RISCV::CLC_128:
+  case RISCV::CFLW:
+  case RISCV::CFLD:
+  case RISCV::CSB:
+  case RISCV::CSH:
+  case RISCV::CSW:
+  case RISCV::CSD:
+  case RISCV::CSC_64:
+  case RISCV::CSC_128:
+  case RISCV::CFSW:
+  case RISCV::CFSD:
+    return true;
+  }
+}
+
+// Fold every CIncOffsetImm of the global whose only users are loads and stores
+// through it into the immediate of those loads and stores. The global itself is
+// left alone so it may have any number of uses.
+bool RISCVMergeBaseOffsetOpt::foldCapOffsetIntoMemOps(MachineInstr &CapGlobal) {
+  Register CapReg = CapGlobal.getOperand(0).getReg();
+  // Folding adds uses of CapReg, so collect the candidates up front.
+  SmallVector<MachineInstr *, 4> Tails;
+  for (MachineInstr &Tail : MRI->use_nodbg_instructions(CapReg))
+    Tails.push_back(&Tail);
+
+  bool Changed = false;
+  for (MachineInstr *TailMI : Tails) {
+    MachineInstr &Tail = *TailMI;
+    if (Tail.getOpcode() != RISCV::CIncOffsetImm ||
+        Tail.getOperand(1).getReg() != CapReg || !Tail.getOperand(2).isImm())
+      continue;
+    int64_t Offset = Tail.getOperand(2).getImm();
+    Register TailReg = Tail.getOperand(0).getReg();
+    if (!TailReg.isVirtual())
+      continue;
+
+    // Every user must address memory through TailReg with a plain immediate
+    // that still fits once the offset is added. Storing TailReg itself is a
+    // use of the value, not of the address.
+    bool CanFold = !MRI->use_nodbg_empty(TailReg);
+    for (const MachineOperand &MO : MRI->use_nodbg_operands(TailReg)) {
+      const MachineInstr &UseMI = *MO.getParent();
+      if (!isCapMemOp(UseMI) || UseMI.getOperandNo(&MO) != 1 ||
+          UseMI.getOperand(0).getReg() == TailReg ||
+          !UseMI.getOperand(2).isImm() ||
+          !isInt<12>(UseMI.getOperand(2).getImm() + Offset)) {
+        CanFold = false;
+        break;
+      }
+    }
+    if (!CanFold)
+      continue;
+
+    LLVM_DEBUG(dbgs() << "  Offset Instr: " << Tail);
+    for (MachineOperand &MO :
+         make_early_inc_range(MRI->use_nodbg_operands(TailReg))) {
+      MachineInstr &UseMI = *MO.getParent();
+      MachineOperand &ImmOp = UseMI.getOperand(2);
+      ImmOp.setImm(ImmOp.getImm() + Offset);
+      MO.setReg(CapReg);
+      LLVM_DEBUG(dbgs() << "  Merged offset " << Offset << " into "
+                        << UseMI);
+    }
+    DeadInstrs.insert(&Tail);
+    Changed = true;
+  }
+  if (Changed)
+    MRI->clearKillFlags(CapReg);
+  return Changed;
+}
+
 bool RISCVMergeBaseOffsetOpt::runOnMachineFunction(MachineFunction &Fn) {
   if (skipFunction(Fn.getFunction()))
     return false;
@@ -266,6 +379,10 @@ bool RISCVMergeBaseOffsetOpt::runOnMachineFunction(MachineFunction &Fn) {
   for (MachineBasicBlock &MBB : Fn) {
     LLVM_DEBUG(dbgs() << "MBB: " << MBB.getName() << "\n");
     for (MachineInstr &HiLUI : MBB) {
+      if (detectCapGlobal(HiLUI)) {
+        foldCapOffsetIntoMemOps(HiLUI);
+        continue;
+      }
       MachineInstr *LoADDI = nullptr;
       if (!detectLuiAddiGlobal(HiLUI, LoADDI))
         continue;
@@ -20,6 +20,7 @@
 #include "llvm/CodeGen/RegisterScavenging.h"
 #include "llvm/CodeGen/TargetFrameLowering.h"
 #include "llvm/CodeGen/TargetInstrInfo.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 
 #define GET_REGINFO_TARGET_DESC
@@ -27,6 +28,12 @@
 
 using namespace llvm;
 
+static cl::opt<bool>
+    DisableRegAllocHints("riscv-disable-regalloc-hints", cl::Hidden,
+                         cl::init(false),
+                         cl::desc("Disable compressible register hints for "
+                                  "register allocation"));
+
 static_assert(RISCV::X1 == RISCV::X0 + 1, "Register list not consecutive");
 static_assert(RISCV::X31 == RISCV::X0 + 31, "Register list not consecutive");
 static_assert(RISCV::F1_H == RISCV::F0_H + 1, "Register list not consecutive");
@@ -170,7 +177,21 @@ static const std::map<unsigned, int> FixedCSRFIMap = {
   {/*s8*/  RISCV::X24,  -10},
   {/*s9*/  RISCV::X25,  -11},
   {/*s10*/ RISCV::X26,  -12},
-  {/*s11*/ RISCV::X27,  -13}
+  {/*s11*/ RISCV::X27,  -13},
+  // The purecap libcalls save the capability registers in the same slots.
+  {/*cra*/  RISCV::C1,   -1},
+  {/*cs0*/  RISCV::C8,   -2},
+  {/*cs1*/  RISCV::C9,   -3},
+  {/*cs2*/  RISCV::C18,  -4},
+  {/*cs3*/  RISCV::C19,  -5},
+  {/*cs4*/  RISCV::C20,  -6},
+  {/*cs5*/  RISCV::C21,  -7},
+  {/*cs6*/  RISCV::C22,  -8},
+  {/*cs7*/  RISCV::C23,  -9},
+  {/*cs8*/  RISCV::C24,  -10},
+  {/*cs9*/  RISCV::C25,  -11},
+  {/*cs10*/ RISCV::C26,  -12},
+  {/*cs11*/ RISCV::C27,  -13}
 };
 
 bool RISCVRegisterInfo::hasReservedSpillSlot(const MachineFunction &MF,
@@ -380,3 +401,87 @@ RISCVRegisterInfo::getLargestLegalSuperClass(const TargetRegisterClass *RC,
     return &RISCV::VRRegClass;
   return RC;
 }
+
+// Returns true if MI is a capability-mode load or store whose offset fits a
+// compressed encoding, so that it can be compressed if both its data (operand
+// 0) and base (operand 1) registers are in the compressible register set.
+static bool isCompressibleCheriMemOp(const MachineInstr &MI,
+                                     const RISCVSubtarget &STI) {
+  if (!MI.getOperand(2).isImm())
+    return false;
+  int64_t Imm = MI.getOperand(2).getImm();
+  switch (MI.getOpcode()) {
+  default:
+    return false;
+  case RISCV::CLW:
+  case RISCV::CSW:
+    return isShiftedUInt<5, 2>(Imm);
+  case RISCV::CLD:
+  case RISCV::CSD:
+    return STI.is64Bit() && isShiftedUInt<5, 3>(Imm);
+  case RISCV::CLC_64:
+  case RISCV::CSC_64:
+    return !STI.is64Bit() && isShiftedUInt<5, 3>(Imm);
+  case RISCV::CLC_128:
+  case RISCV::CSC_128:
+    return STI.is64Bit() && isShiftedUInt<5, 4>(Imm);
+  }
+}
+
+bool RISCVRegisterInfo::getRegAllocationHints(
+    Register VirtReg, ArrayRef<MCPhysReg> Order,
+    SmallVectorImpl<MCPhysReg> &Hints, const MachineFunction &MF,
+    const VirtRegMap *VRM, const LiveRegMatrix *Matrix) const {
+  bool BaseImplRetVal = TargetRegisterInfo::getRegAllocationHints(
+      VirtReg, Order, Hints, MF, VRM, Matrix);
+
+  const auto &STI = MF.getSubtarget<RISCVSubtarget>();
+  if (DisableRegAllocHints || !STI.hasStdExtC() || !STI.hasCheri() ||
+      !STI.enableCheriRVCInstrs() || !STI.isCapMode())
+    return BaseImplRetVal;
+
+  // The compressed capability loads and stores, and c.cincoffset4cspn, can
+  // only name c8-c15 (or x8-x15 for integer data).  Prefer those registers for
+  // any virtual register that would let such an instruction be compressed,
+  // after any copy hints from the generic implementation.
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+  bool NeedsCompressible = false;
+  for (const MachineOperand &MO : MRI.reg_nodbg_operands(VirtReg)) {
+    const MachineInstr &MI = *MO.getParent();
+    if (MO.getSubReg())
+      continue;
+    unsigned OpIdx = MI.getOperandNo(&MO);
+    if (OpIdx > 1)
+      continue;
+    if (isCompressibleCheriMemOp(MI, STI)) {
+      // Stack accesses compress to c.clcsp, c.cscsp and friends, which take
+      // any data register.  Frame indices usually become csp-relative too.
+      const MachineOperand &Base = MI.getOperand(1);
+      if (OpIdx == 0 &&
+          (Base.isFI() || (Base.isReg() && Base.getReg() == RISCV::C2)))
+        continue;
+      NeedsCompressible = true;
+      break;
+    }
+    if (MI.getOpcode() == RISCV::CIncOffsetImm && OpIdx == 0 &&
+        MI.getOperand(1).isReg() && MI.getOperand(1).getReg() == RISCV::C2 &&
+        MI.getOperand(2).isImm() && MI.getOperand(2).getImm() != 0 &&
+        isShiftedUInt<8, 2>(MI.getOperand(2).getImm())) {
+      NeedsCompressible = true;
+      break;
+    }
+  }
+  if (!NeedsCompressible)
+    return BaseImplRetVal;
+
+  const TargetRegisterClass *RC = MRI.getRegClass(VirtReg);
+  const TargetRegisterClass *CompressibleRC =
+      RISCV::GPCRRegClass.hasSubClassEq(RC) ? &RISCV::GPCRCRegClass
+                                            : &RISCV::GPRCRegClass;
+  for (MCPhysReg PhysReg : Order)
+    if (CompressibleRC->contains(PhysReg) && !MRI.isReserved(PhysReg) &&
+        !is_contained(Hints, PhysReg))
+      Hints.push_back(PhysReg);
+
+  return BaseImplRetVal;
+}
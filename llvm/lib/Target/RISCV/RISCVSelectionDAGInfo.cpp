@@ -71,11 +71,13 @@ SDValue EmitTargetCodeForMemOp(SelectionDAG &DAG, const SDLoc &dl,
   if ((DstAS == 0) && (SrcAS == 0))
     return SDValue();
   auto &STI = getRISCVSubtarget(DAG);
-  // If either argument is AS0, make it a capability.
+  // If either argument is AS0, make it a capability.  Pointer infos without
+  // an IR value report AS0 even for capabilities, so don't emit casts that
+  // would only be folded away again during legalization.
   MVT CapType = STI.typeForCapabilities();
-  if (DstAS == 0)
+  if (DstAS == 0 && !Dst.getValueType().isFatPointer())
     Dst = DAG.getAddrSpaceCast(dl, CapType, Dst, 0, 200);
-  if (SrcAS == 0)
+  if (SrcAS == 0 && !Src.getValueType().isFatPointer())
     Src = DAG.getAddrSpaceCast(dl, CapType, Src, 0, 200);
 
   const char *memFnName = isMemCpy ?
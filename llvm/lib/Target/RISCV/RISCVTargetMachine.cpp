@@ -41,6 +41,8 @@ extern "C" LLVM_EXTERNAL_VISIBILITY void LLVMInitializeRISCVTarget() {
   initializeRISCVMergeBaseOffsetOptPass(*PR);
   initializeRISCVExpandPseudoPass(*PR);
   initializeRISCVInsertVSETVLIPass(*PR);
+  initializeRISCVCheriotInterruptAtomicsPass(*PR);
+  initializeRISCVCheriRoundTripOptPass(*PR);
 }
 
 static std::string computeDataLayout(const Triple &TT, StringRef FS,
@@ -185,6 +187,7 @@ TargetPassConfig *RISCVTargetMachine::createPassConfig(PassManagerBase &PM) {
 }
 
 void RISCVPassConfig::addIRPasses() {
+  addPass(createRISCVCheriotInterruptAtomicsPass());
   addPass(createAtomicExpandPass());
   addPass(createCheriBoundAllocasPass());
   TargetPassConfig::addIRPasses();
@@ -231,8 +234,11 @@ void RISCVPassConfig::addPreEmitPass2() {
 
 void RISCVPassConfig::addPreRegAlloc() {
   if (TM->getOptLevel() != CodeGenOpt::None) {
-    addPass(createRISCVCheriCleanupOptPass());
+    addPass(createRISCVCheriRoundTripOptPass());
+    // Merge offsets first so that the bounds check elision sees the folded
+    // load and store immediates.
     addPass(createRISCVMergeBaseOffsetOptPass());
+    addPass(createRISCVCheriCleanupOptPass());
   }
   addPass(createRISCVInsertVSETVLIPass());
 }
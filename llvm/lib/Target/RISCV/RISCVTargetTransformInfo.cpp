@@ -102,6 +102,119 @@ RISCVTTIImpl::getPopcntSupport(unsigned TyWidth) {
   return ST->hasStdExtZbb() ? TTI::PSK_FastHardware : TTI::PSK_Software;
 }
 
+InstructionCost RISCVTTIImpl::getCastInstrCost(unsigned Opcode, Type *Dst,
+                                               Type *Src,
+                                               TTI::CastContextHint CCH,
+                                               TTI::TargetCostKind CostKind,
+                                               const Instruction *I) {
+  InstructionCost Cost =
+      BaseT::getCastInstrCost(Opcode, Dst, Src, CCH, CostKind, I);
+  bool IsCapabilityConversion = false;
+  switch (Opcode) {
+  default:
+    break;
+  case Instruction::PtrToInt:
+    IsCapabilityConversion = isCapabilityType(Src);
+    break;
+  case Instruction::IntToPtr:
+    IsCapabilityConversion = isCapabilityType(Dst);
+    break;
+  case Instruction::AddrSpaceCast:
+    IsCapabilityConversion = isCapabilityType(Src) != isCapabilityType(Dst);
+    break;
+  }
+  if (!IsCapabilityConversion)
+    return Cost;
+  // Moving between capabilities and integers is never free: it takes a
+  // cgetaddr, a cincoffset/csetaddr of a null or DDC-derived capability, or a
+  // cfromptr/ctoptr for address space casts. That is a single instruction,
+  // but don't undercut the generic estimate for the other cost kinds, which
+  // may include scalarizing a vector.
+  if (CostKind == TTI::TCK_CodeSize)
+    return TTI::TCC_Basic;
+  return std::max(Cost, InstructionCost(TTI::TCC_Basic));
+}
+
+InstructionCost RISCVTTIImpl::getMemoryOpCost(unsigned Opcode, Type *Src,
+                                              MaybeAlign Alignment,
+                                              unsigned AddressSpace,
+                                              TTI::TargetCostKind CostKind,
+                                              const Instruction *I) {
+  InstructionCost Cost = BaseT::getMemoryOpCost(Opcode, Src, Alignment,
+                                                AddressSpace, CostKind, I);
+  // A capability is moved by a single clc/csc. On RV32 cores such as CHERIoT
+  // it is 64 bits wide but the memory interface is only 32 bits, so it takes
+  // two beats. RV64 cores move a capability in one access.
+  if (CostKind != TTI::TCK_CodeSize && !ST->is64Bit() && isCapabilityType(Src))
+    return Cost * 2;
+  return Cost;
+}
+
+InstructionCost
+RISCVTTIImpl::getIntrinsicInstrCost(const IntrinsicCostAttributes &ICA,
+                                    TTI::TargetCostKind CostKind) {
+  if (!ST->hasCheri())
+    return BaseT::getIntrinsicInstrCost(ICA, CostKind);
+
+  switch (ICA.getID()) {
+  default:
+    break;
+  // Each of these is a single capability instruction.
+  case Intrinsic::cheri_cap_length_get:
+  case Intrinsic::cheri_cap_base_get:
+  case Intrinsic::cheri_cap_perms_and:
+  case Intrinsic::cheri_cap_perms_get:
+  case Intrinsic::cheri_cap_flags_set:
+  case Intrinsic::cheri_cap_flags_get:
+  case Intrinsic::cheri_cap_type_get:
+  case Intrinsic::cheri_cap_tag_get:
+  case Intrinsic::cheri_cap_sealed_get:
+  case Intrinsic::cheri_cap_tag_clear:
+  case Intrinsic::cheri_cap_seal:
+  case Intrinsic::cheri_cap_conditional_seal:
+  case Intrinsic::cheri_cap_unseal:
+  case Intrinsic::cheri_cap_seal_entry:
+  case Intrinsic::cheri_cap_subset_test:
+  case Intrinsic::cheri_cap_equal_exact:
+  case Intrinsic::cheri_pcc_get:
+  case Intrinsic::cheri_cap_offset_set:
+  case Intrinsic::cheri_cap_offset_get:
+  case Intrinsic::cheri_cap_diff:
+  case Intrinsic::cheri_cap_address_get:
+  case Intrinsic::cheri_cap_address_set:
+  case Intrinsic::cheri_cap_build:
+  case Intrinsic::cheri_cap_type_copy:
+  case Intrinsic::cheri_round_representable_length:
+  case Intrinsic::cheri_representable_alignment_mask:
+    return TTI::TCC_Basic;
+  // Setting bounds is a single instruction, but has to compress the new
+  // bounds and is slower than the other capability manipulations.
+  case Intrinsic::cheri_cap_bounds_set:
+  case Intrinsic::cheri_cap_bounds_set_exact:
+  case Intrinsic::cheri_bounded_stack_cap:
+  case Intrinsic::cheri_bounded_stack_cap_dynamic:
+    if (CostKind == TTI::TCK_CodeSize)
+      return TTI::TCC_Basic;
+    return 2 * TTI::TCC_Basic;
+  // CHERIoT has no DDC, no DDC-relative conversions and no CLoadTags, so only
+  // price these where the instructions exist.
+  case Intrinsic::cheri_ddc_get:
+  case Intrinsic::cheri_cap_to_pointer:
+  case Intrinsic::cheri_cap_from_pointer:
+    if (ST->getTargetABI() == RISCVABI::ABI_CHERIOT)
+      break;
+    return TTI::TCC_Basic;
+  // Loading tags is a memory access.
+  case Intrinsic::cheri_cap_load_tags:
+    if (ST->getTargetABI() == RISCVABI::ABI_CHERIOT)
+      break;
+    if (CostKind == TTI::TCK_CodeSize)
+      return TTI::TCC_Basic;
+    return 2 * TTI::TCC_Basic;
+  }
+  return BaseT::getIntrinsicInstrCost(ICA, CostKind);
+}
+
 bool RISCVTTIImpl::shouldExpandReduction(const IntrinsicInst *II) const {
   // Currently, the ExpandReductions pass can't expand scalable-vector
   // reductions, but we still request expansion as RVV doesn't support certain
@@ -21,7 +21,7 @@ using namespace llvm;
 
 #define DEBUG_TYPE "loweratomic"
 
-static bool LowerAtomicCmpXchgInst(AtomicCmpXchgInst *CXI) {
+bool llvm::lowerAtomicCmpXchgInst(AtomicCmpXchgInst *CXI) {
   IRBuilder<> Builder(CXI);
   Value *Ptr = CXI->getPointerOperand();
   Value *Cmp = CXI->getCompareOperand();
@@ -40,60 +40,51 @@ static bool LowerAtomicCmpXchgInst(AtomicCmpXchgInst *CXI) {
   return true;
 }
 
-bool llvm::lowerAtomicRMWInst(AtomicRMWInst *RMWI) {
-  IRBuilder<> Builder(RMWI);
-  Value *Ptr = RMWI->getPointerOperand();
-  Value *Val = RMWI->getValOperand();
-
-  LoadInst *Orig = Builder.CreateLoad(Val->getType(), Ptr);
-  Value *Res = nullptr;
-
-  switch (RMWI->getOperation()) {
+Value *llvm::buildAtomicRMWValue(AtomicRMWInst::BinOp Op,
+                                 IRBuilderBase &Builder, Value *Loaded,
+                                 Value *Inc) {
+  switch (Op) {
   default: llvm_unreachable("Unexpected RMW operation");
   case AtomicRMWInst::Xchg:
-    Res = Val;
-    break;
+    return Inc;
   case AtomicRMWInst::Add:
-    Res = Builder.CreateAdd(Orig, Val);
-    break;
+    return Builder.CreateAdd(Loaded, Inc);
   case AtomicRMWInst::Sub:
-    Res = Builder.CreateSub(Orig, Val);
-    break;
+    return Builder.CreateSub(Loaded, Inc);
   case AtomicRMWInst::And:
-    Res = Builder.CreateAnd(Orig, Val);
-    break;
+    return Builder.CreateAnd(Loaded, Inc);
   case AtomicRMWInst::Nand:
-    Res = Builder.CreateNot(Builder.CreateAnd(Orig, Val));
-    break;
+    return Builder.CreateNot(Builder.CreateAnd(Loaded, Inc));
   case AtomicRMWInst::Or:
-    Res = Builder.CreateOr(Orig, Val);
-    break;
+    return Builder.CreateOr(Loaded, Inc);
   case AtomicRMWInst::Xor:
-    Res = Builder.CreateXor(Orig, Val);
-    break;
+    return Builder.CreateXor(Loaded, Inc);
   case AtomicRMWInst::Max:
-    Res = Builder.CreateSelect(Builder.CreateICmpSLT(Orig, Val),
-                               Val, Orig);
-    break;
+    return Builder.CreateSelect(Builder.CreateICmpSLT(Loaded, Inc), Inc,
+                                Loaded);
   case AtomicRMWInst::Min:
-    Res = Builder.CreateSelect(Builder.CreateICmpSLT(Orig, Val),
-                               Orig, Val);
-    break;
+    return Builder.CreateSelect(Builder.CreateICmpSLT(Loaded, Inc), Loaded,
+                                Inc);
   case AtomicRMWInst::UMax:
-    Res = Builder.CreateSelect(Builder.CreateICmpULT(Orig, Val),
-                               Val, Orig);
-    break;
+    return Builder.CreateSelect(Builder.CreateICmpULT(Loaded, Inc), Inc,
+                                Loaded);
   case AtomicRMWInst::UMin:
-    Res = Builder.CreateSelect(Builder.CreateICmpULT(Orig, Val),
-                               Orig, Val);
-    break;
+    return Builder.CreateSelect(Builder.CreateICmpULT(Loaded, Inc), Loaded,
+                                Inc);
   case AtomicRMWInst::FAdd:
-    Res = Builder.CreateFAdd(Orig, Val);
-    break;
+    return Builder.CreateFAdd(Loaded, Inc);
   case AtomicRMWInst::FSub:
-    Res = Builder.CreateFSub(Orig, Val);
-    break;
+    return Builder.CreateFSub(Loaded, Inc);
   }
+}
+
+bool llvm::lowerAtomicRMWInst(AtomicRMWInst *RMWI) {
+  IRBuilder<> Builder(RMWI);
+  Value *Ptr = RMWI->getPointerOperand();
+  Value *Val = RMWI->getValOperand();
+
+  LoadInst *Orig = Builder.CreateLoad(Val->getType(), Ptr);
+  Value *Res = buildAtomicRMWValue(RMWI->getOperation(), Builder, Orig, Val);
   Builder.CreateStore(Res, Ptr);
   RMWI->replaceAllUsesWith(Orig);
   RMWI->eraseFromParent();
@@ -121,7 +112,7 @@ static bool runOnBasicBlock(BasicBlock &BB) {
     if (FenceInst *FI = dyn_cast<FenceInst>(&Inst))
       Changed |= LowerFenceInst(FI);
     else if (AtomicCmpXchgInst *CXI = dyn_cast<AtomicCmpXchgInst>(&Inst))
-      Changed |= LowerAtomicCmpXchgInst(CXI);
+      Changed |= lowerAtomicCmpXchgInst(CXI);
     else if (AtomicRMWInst *RMWI = dyn_cast<AtomicRMWInst>(&Inst))
       Changed |= lowerAtomicRMWInst(RMWI);
     else if (LoadInst *LI = dyn_cast<LoadInst>(&Inst)) {
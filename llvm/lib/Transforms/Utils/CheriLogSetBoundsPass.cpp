@@ -10,42 +10,75 @@
 #include "llvm/Transforms/Utils/CheriLogSetBounds.h"
 
 #include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/Passes.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Transforms/Utils/CheriSetBounds.h"
 #include "llvm/Transforms/Utils/Local.h"
 
+#define DEBUG_TYPE "cheri-log-setbounds"
+
 using namespace llvm;
 
 namespace {
 
+/// Emit a missed-optimization remark for a bounds-setting intrinsic that
+/// survived all IR optimizations so that opt-viewer and llvm-opt-report can
+/// show the remaining bounds overhead next to the source.
+static void emitSetBoundsRemark(IntrinsicInst &II,
+                                OptimizationRemarkEmitter &ORE) {
+  ORE.emit([&]() {
+    Value *Length = II.getArgOperand(1);
+    cheri::SetBoundsPointerSource Kind =
+        cheri::inferUnderlyingPointerSource(II.getArgOperand(0));
+    OptimizationRemarkMissed R(DEBUG_TYPE, "SetBounds", &II);
+    R << (II.getIntrinsicID() == Intrinsic::cheri_cap_bounds_set_exact
+              ? "exact bounds"
+              : "bounds")
+      << " set on "
+      << ore::NV("Reason", cheri::getPointerKindName(Kind)) << " pointer";
+    if (Optional<uint64_t> Size = cheri::inferConstantValue(Length))
+      R << " with size " << ore::NV("Size", *Size);
+    else
+      R << " with unknown size";
+    R << " (estimated cost: "
+      << ore::NV("Cost", cheri::estimateSetBoundsCost(Length))
+      << ")";
+    return R;
+  });
+}
+
 /// This should really be in Analysis/ but it depends on
 /// getOrEnforceKnownAlignment which is in Transforms/Scalar.
 class CheriLogSetBoundsLegacyPass : public FunctionPass {
 public:
   static char ID;
 
-  CheriLogSetBoundsLegacyPass() : FunctionPass(ID) {
-    assert(cheri::ShouldCollectCSetBoundsStats &&
-           "Pass should only be created when we are logging bouds");
-  }
+  CheriLogSetBoundsLegacyPass() : FunctionPass(ID) {}
 
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<AssumptionCacheTracker>();
     AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
   }
 
   bool runOnFunction(Function &F) override {
     DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
     AssumptionCache &AC =
         getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F);
-    runImpl(F, DT, AC);
+    OptimizationRemarkEmitter &ORE =
+        getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE();
+    runImpl(F, DT, AC, ORE);
     return false;
   }
-  static void runImpl(Function &F, DominatorTree &DT, AssumptionCache &AC) {
-    assert(cheri::ShouldCollectCSetBoundsStats &&
-           "Should not have been created otherwise");
+  static void runImpl(Function &F, DominatorTree &DT, AssumptionCache &AC,
+                      OptimizationRemarkEmitter &ORE) {
+    const bool LogStats = cheri::ShouldCollectCSetBoundsStats;
+    const bool EmitRemarks = ORE.allowExtraAnalysis(DEBUG_TYPE);
+    if (!LogStats && !EmitRemarks)
+      return;
     // errs() << "Logging bounds for " << F.getName() << "\n";
     // For MIPS we can guess the size here by multiplying by 4:
     const DataLayout &DL = F.getParent()->getDataLayout();
@@ -54,6 +87,15 @@ public:
         const CallBase *CB = dyn_cast<CallBase>(&I);
         if (!CB)
           continue; // Not a call
+        if (auto *II = dyn_cast<IntrinsicInst>(&I)) {
+          if (EmitRemarks &&
+              (II->getIntrinsicID() == Intrinsic::cheri_cap_bounds_set ||
+               II->getIntrinsicID() == Intrinsic::cheri_cap_bounds_set_exact))
+            emitSetBoundsRemark(*II, ORE);
+          continue;
+        }
+        if (!LogStats)
+          continue;
         Function *CalledFunc = CB->getCalledFunction();
         const auto LogAllocSize =
             [&](std::pair<unsigned, Optional<unsigned>> AllocSize) {
@@ -148,6 +190,7 @@ PreservedAnalyses CheriLogSetBoundsPass::run(Function &F,
                                              FunctionAnalysisManager &AM) {
   auto &AC = AM.getResult<AssumptionAnalysis>(F);
   auto &DT = AM.getResult<DominatorTreeAnalysis>(F);
-  CheriLogSetBoundsLegacyPass::runImpl(F, DT, AC);
+  auto &ORE = AM.getResult<OptimizationRemarkEmitterAnalysis>(F);
+  CheriLogSetBoundsLegacyPass::runImpl(F, DT, AC, ORE);
   return PreservedAnalyses::all();
 }
@@ -13,10 +13,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/CheriSetBounds.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/Transforms/Utils/Local.h"
 
 std::string llvm::cheri::inferSourceLocation(const DebugLoc &DL,
@@ -34,20 +37,24 @@ std::string llvm::cheri::inferSourceLocation(const DebugLoc &DL,
   return Result;
 }
 
+llvm::DebugLoc llvm::cheri::inferDebugLoc(Instruction *I) {
+  assert(I);
+  if (const DebugLoc &DL = I->getDebugLoc())
+    return DL;
+  // some instructions such as alloca instruction don't have a debug loc
+  // attached directly so we need to look for calls to llvm.dbg.declare()
+  SmallVector<DbgVariableIntrinsic *, 2> DbgVars;
+  findDbgUsers(DbgVars, I);
+  for (auto &DbgV : DbgVars) {
+    if (const DebugLoc &DL = DbgV->getDebugLoc())
+      return DL;
+  }
+  return DebugLoc();
+}
+
 std::string llvm::cheri::inferSourceLocation(Instruction *AI) {
   assert(AI);
-  std::string Result = inferSourceLocation(AI->getDebugLoc(), StringRef());
-  if (Result.empty()) {
-    // some instructions such as alloca instruction don't have a debug loc
-    // attached directly so we need to look for calls to llvm.dbg.declare()
-    SmallVector<DbgVariableIntrinsic *, 2> DbgVars;
-    findDbgUsers(DbgVars, AI);
-    for (auto &DbgV : DbgVars) {
-      Result = inferSourceLocation(DbgV->getDebugLoc(), StringRef());
-      if (!Result.empty())
-        break;
-    }
-  }
+  std::string Result = inferSourceLocation(inferDebugLoc(AI), StringRef());
   // No debug instructions found -> just fall back to function name
   if (Result.empty()) {
     Result = ("<somewhere in " + AI->getFunction()->getName() + ">").str();
@@ -77,3 +84,37 @@ std::string llvm::cheri::inferLocalVariableName(AllocaInst *AI) {
   OS.flush();
   return Result;
 }
+
+llvm::cheri::SetBoundsPointerSource
+llvm::cheri::inferUnderlyingPointerSource(const Value *V) {
+  V = V->stripPointerCasts();
+  // A GEP that indexes into a struct creates a pointer to a member.
+  if (auto *GEP = dyn_cast<GEPOperator>(V)) {
+    for (gep_type_iterator GTI = gep_type_begin(GEP), E = gep_type_end(GEP);
+         GTI != E; ++GTI) {
+      if (GTI.isStruct())
+        return SetBoundsPointerSource::SubObject;
+    }
+  }
+  const Value *Obj = getUnderlyingObject(V);
+  if (isa<AllocaInst>(Obj))
+    return SetBoundsPointerSource::Stack;
+  if (isa<Function>(Obj))
+    return SetBoundsPointerSource::CodePointer;
+  if (isa<GlobalValue>(Obj))
+    return SetBoundsPointerSource::GlobalVar;
+  // Without TargetLibraryInfo we can't use isAllocationFn(), but all the
+  // interesting allocation functions have allocsize or a noalias return.
+  if (auto *CB = dyn_cast<CallBase>(Obj)) {
+    if (CB->hasRetAttr(Attribute::NoAlias) ||
+        CB->hasFnAttr(Attribute::AllocSize))
+      return SetBoundsPointerSource::Heap;
+  }
+  return SetBoundsPointerSource::Unknown;
+}
+
+unsigned llvm::cheri::estimateSetBoundsCost(const Value *Length) {
+  if (auto *CI = dyn_cast<ConstantInt>(Length))
+    return CI->getValue().isIntN(12) ? 1 : 2;
+  return 1;
+}
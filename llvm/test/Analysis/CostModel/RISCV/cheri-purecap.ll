@@ -0,0 +1,71 @@
+; RUN: opt < %s -cost-model -analyze -mtriple=riscv64 -mattr=+xcheri,+cap-mode \
+; RUN:   | FileCheck %s --check-prefix=THROUGHPUT
+; RUN: opt < %s -cost-model -analyze -mtriple=riscv64 -mattr=+xcheri,+cap-mode \
+; RUN:   -cost-kind=code-size | FileCheck %s --check-prefix=SIZE
+
+; Capability casts and CHERI intrinsics are not free. RV64 moves a capability
+; in a single memory access, so capability loads and stores cost the same as
+; integer ones.
+
+target datalayout = "e-m:e-pf200:128:128:128:64-p:64:64-i64:64-i128:128-n64-S128-A200-P200-G200"
+
+declare i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i64(i8 addrspace(200)*, i64)
+declare i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)*)
+declare i64 @llvm.cheri.cap.length.get.i64(i8 addrspace(200)*)
+declare i8 addrspace(200)* @llvm.cheri.ddc.get()
+declare i8 addrspace(200)* @llvm.cheri.cap.from.pointer.i64(i8 addrspace(200)*, i64)
+declare i64 @llvm.cheri.cap.load.tags.i64(i8 addrspace(200)*)
+
+define void @casts(i8 addrspace(200)* %p, i64 %a) addrspace(200) {
+; THROUGHPUT-LABEL: 'casts'
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %i = ptrtoint i8 addrspace(200)* %p to i64
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %c = inttoptr i64 %a to i8 addrspace(200)*
+; SIZE-LABEL: 'casts'
+; SIZE: Found an estimated cost of 1 for instruction: %i = ptrtoint i8 addrspace(200)* %p to i64
+; SIZE: Found an estimated cost of 1 for instruction: %c = inttoptr i64 %a to i8 addrspace(200)*
+  %i = ptrtoint i8 addrspace(200)* %p to i64
+  %c = inttoptr i64 %a to i8 addrspace(200)*
+  ret void
+}
+
+define void @memory(i8 addrspace(200)* addrspace(200)* %pp, i64 addrspace(200)* %ip) addrspace(200) {
+; THROUGHPUT-LABEL: 'memory'
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %c = load i8 addrspace(200)*, i8 addrspace(200)* addrspace(200)* %pp
+; THROUGHPUT: Found an estimated cost of 1 for instruction: store i8 addrspace(200)* %c, i8 addrspace(200)* addrspace(200)* %pp
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %i = load i64, i64 addrspace(200)* %ip
+; SIZE-LABEL: 'memory'
+; SIZE: Found an estimated cost of 1 for instruction: %c = load i8 addrspace(200)*, i8 addrspace(200)* addrspace(200)* %pp
+; SIZE: Found an estimated cost of 1 for instruction: store i8 addrspace(200)* %c, i8 addrspace(200)* addrspace(200)* %pp
+; SIZE: Found an estimated cost of 1 for instruction: %i = load i64, i64 addrspace(200)* %ip
+  %c = load i8 addrspace(200)*, i8 addrspace(200)* addrspace(200)* %pp
+  store i8 addrspace(200)* %c, i8 addrspace(200)* addrspace(200)* %pp
+  %i = load i64, i64 addrspace(200)* %ip
+  ret void
+}
+
+define void @intrinsics(i8 addrspace(200)* %p, i64 %n) addrspace(200) {
+; THROUGHPUT-LABEL: 'intrinsics'
+; THROUGHPUT: Found an estimated cost of 2 for instruction: %b = call i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i64
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %a = call i64 @llvm.cheri.cap.address.get.i64
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %l = call i64 @llvm.cheri.cap.length.get.i64
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %d = call i8 addrspace(200)* @llvm.cheri.ddc.get()
+; THROUGHPUT: Found an estimated cost of 1 for instruction: %f = call i8 addrspace(200)* @llvm.cheri.cap.from.pointer.i64
+; THROUGHPUT: Found an estimated cost of 2 for instruction: %t = call i64 @llvm.cheri.cap.load.tags.i64
+; SIZE-LABEL: 'intrinsics'
+; SIZE: Found an estimated cost of 1 for instruction: %b = call i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i64
+; SIZE: Found an estimated cost of 1 for instruction: %a = call i64 @llvm.cheri.cap.address.get.i64
+; SIZE: Found an estimated cost of 1 for instruction: %l = call i64 @llvm.cheri.cap.length.get.i64
+; SIZE: Found an estimated cost of 1 for instruction: %d = call i8 addrspace(200)* @llvm.cheri.ddc.get()
+; SIZE: Found an estimated cost of 1 for instruction: %f = call i8 addrspace(200)* @llvm.cheri.cap.from.pointer.i64
+; SIZE: Found an estimated cost of 1 for instruction: %t = call i64 @llvm.cheri.cap.load.tags.i64
+  %b = call i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i64(i8 addrspace(200)* %p, i64 %n)
+  %a = call i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)* %p)
+  %l = call i64 @llvm.cheri.cap.length.get.i64(i8 addrspace(200)* %p)
+  %d = call i8 addrspace(200)* @llvm.cheri.ddc.get()
+  %f = call i8 addrspace(200)* @llvm.cheri.cap.from.pointer.i64(i8 addrspace(200)* %d, i64 %n)
+  %t = call i64 @llvm.cheri.cap.load.tags.i64(i8 addrspace(200)* %p)
+  ret void
+}
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 1, !"target-abi", !"l64pc128d"}
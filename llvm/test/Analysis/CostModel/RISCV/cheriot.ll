@@ -0,0 +1,30 @@
+; RUN: opt < %s -cost-model -analyze -mtriple=riscv32 -mcpu=cheriot \
+; RUN:   -mattr=+xcheri | FileCheck %s
+
+; CHERIoT prices the capability operations it has like other CHERI targets.
+; It has no DDC and no CLoadTags, so the intrinsics for them are left to the
+; generic cost model.
+
+target datalayout = "e-m:e-pf200:64:64:64:32-p:32:32-i64:64-n32-S128-A200-P200-G200"
+
+declare i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i32(i8 addrspace(200)*, i32)
+declare i32 @llvm.cheri.cap.address.get.i32(i8 addrspace(200)*)
+declare i32 @llvm.cheri.cap.load.tags.i32(i8 addrspace(200)*)
+
+define void @cheriot(i8 addrspace(200)* addrspace(200)* %pp, i32 %n) addrspace(200) {
+; CHECK-LABEL: 'cheriot'
+; CHECK: Found an estimated cost of 2 for instruction: %p = load i8 addrspace(200)*, i8 addrspace(200)* addrspace(200)* %pp
+; CHECK: Found an estimated cost of 1 for instruction: %i = ptrtoint i8 addrspace(200)* %p to i32
+; CHECK: Found an estimated cost of 2 for instruction: %b = call i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i32
+; CHECK: Found an estimated cost of 1 for instruction: %a = call i32 @llvm.cheri.cap.address.get.i32
+; CHECK: Found an estimated cost of 1 for instruction: %t = call i32 @llvm.cheri.cap.load.tags.i32
+  %p = load i8 addrspace(200)*, i8 addrspace(200)* addrspace(200)* %pp
+  %i = ptrtoint i8 addrspace(200)* %p to i32
+  %b = call i8 addrspace(200)* @llvm.cheri.cap.bounds.set.i32(i8 addrspace(200)* %p, i32 %n)
+  %a = call i32 @llvm.cheri.cap.address.get.i32(i8 addrspace(200)* %p)
+  %t = call i32 @llvm.cheri.cap.load.tags.i32(i8 addrspace(200)* %p)
+  ret void
+}
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 1, !"target-abi", !"cheriot"}
@@ -0,0 +1,40 @@
+; RUN: llc -mtriple=riscv64 -mattr=+xcheri,+cap-mode -target-abi l64pc128d \
+; RUN:   -global-isel -global-isel-abort=1 -verify-machineinstrs < %s \
+; RUN:   | FileCheck %s
+; RUN: llc -mtriple=riscv32 -mcpu=cheriot -mattr=+xcheri -target-abi cheriot \
+; RUN:   -global-isel -global-isel-abort=1 -verify-machineinstrs < %s \
+; RUN:   | FileCheck %s
+
+; Calls, arguments and returns that only use capabilities go through
+; GlobalISel without falling back to SelectionDAG.
+
+declare i8 addrspace(200)* @callee(i8 addrspace(200)*, i8 addrspace(200)*) addrspace(200)
+
+define i8 addrspace(200)* @call_direct(i8 addrspace(200)* %p,
+                                       i8 addrspace(200)* %q) addrspace(200) {
+; CHECK-LABEL: call_direct:
+; CHECK: csc cra,
+; CHECK: {{ccall|cjal}}{{.*}}callee
+; CHECK: clc cra,
+; CHECK: cret
+  %r = call i8 addrspace(200)* @callee(i8 addrspace(200)* %q,
+                                       i8 addrspace(200)* %p)
+  ret i8 addrspace(200)* %r
+}
+
+define void @call_indirect(void (i8 addrspace(200)*) addrspace(200)* %fp,
+                           i8 addrspace(200)* %p) addrspace(200) {
+; CHECK-LABEL: call_indirect:
+; CHECK: cjalr
+; CHECK: cret
+  call void %fp(i8 addrspace(200)* %p)
+  ret void
+}
+
+define i8 addrspace(200)* @load_cap(i8 addrspace(200)* addrspace(200)* %pp) addrspace(200) {
+; CHECK-LABEL: load_cap:
+; CHECK: clc ca0, 0(ca0)
+; CHECK-NEXT: cret
+  %p = load i8 addrspace(200)*, i8 addrspace(200)* addrspace(200)* %pp
+  ret i8 addrspace(200)* %p
+}
@@ -0,0 +1,32 @@
+; RUN: llc -mtriple=riscv32 -mcpu=cheriot -mattr=+xcheri -target-abi cheriot \
+; RUN:   -global-isel -stop-after=irtranslator -verify-machineinstrs < %s \
+; RUN:   | FileCheck %s
+
+define i32 @args(i8 addrspace(200)* %p, i32 %a, i8 addrspace(200)* %q) addrspace(200) {
+  ; CHECK-LABEL: name: args
+  ; CHECK: liveins: $c10, $x11, $c12
+  ; CHECK: [[P:%[0-9]+]]:_(p200) = COPY $c10
+  ; CHECK-NEXT: [[A:%[0-9]+]]:_(s32) = COPY $x11
+  ; CHECK-NEXT: [[Q:%[0-9]+]]:_(p200) = COPY $c12
+  ; CHECK: $x10 = COPY [[A]](s32)
+  ; CHECK-NEXT: PseudoCRET implicit $x10
+  ret i32 %a
+}
+
+declare i8 addrspace(200)* @callee(i32, i8 addrspace(200)*) addrspace(200)
+
+define i8 addrspace(200)* @call_direct(i32 %a, i8 addrspace(200)* %p) addrspace(200) {
+  ; CHECK-LABEL: name: call_direct
+  ; CHECK: [[A:%[0-9]+]]:_(s32) = COPY $x10
+  ; CHECK-NEXT: [[P:%[0-9]+]]:_(p200) = COPY $c11
+  ; CHECK-NEXT: ADJCALLSTACKDOWNCAP 0, 0
+  ; CHECK-NEXT: $x10 = COPY [[A]](s32)
+  ; CHECK-NEXT: $c11 = COPY [[P]](p200)
+  ; CHECK-NEXT: PseudoCCALL target-flags(riscv-ccall) @callee, csr_cheriot, {{.*}}, implicit $x10, implicit $c11, implicit-def $c10
+  ; CHECK-NEXT: [[R:%[0-9]+]]:_(p200) = COPY $c10
+  ; CHECK-NEXT: ADJCALLSTACKUPCAP 0, 0
+  ; CHECK-NEXT: $c10 = COPY [[R]](p200)
+  ; CHECK-NEXT: PseudoCRET implicit $c10
+  %r = call i8 addrspace(200)* @callee(i32 %a, i8 addrspace(200)* %p)
+  ret i8 addrspace(200)* %r
+}
@@ -0,0 +1,71 @@
+; RUN: llc -mtriple=riscv64 -mattr=+xcheri,+cap-mode -target-abi l64pc128d \
+; RUN:   -global-isel -global-isel-abort=2 -stop-after=irtranslator \
+; RUN:   -verify-machineinstrs < %s 2>/dev/null \
+; RUN:   | FileCheck %s
+
+define i8 addrspace(200)* @ret_cap(i8 addrspace(200)* %p) addrspace(200) {
+  ; CHECK-LABEL: name: ret_cap
+  ; CHECK: liveins: $c10
+  ; CHECK: [[P:%[0-9]+]]:_(p200) = COPY $c10
+  ; CHECK-NEXT: $c10 = COPY [[P]](p200)
+  ; CHECK-NEXT: PseudoCRET implicit $c10
+  ret i8 addrspace(200)* %p
+}
+
+define i64 @int_args(i8 addrspace(200)* %p, i64 %a, i32 %b) addrspace(200) {
+  ; CHECK-LABEL: name: int_args
+  ; CHECK: liveins: $c10, $x11, $x12
+  ; CHECK: [[P:%[0-9]+]]:_(p200) = COPY $c10
+  ; CHECK-NEXT: [[A:%[0-9]+]]:_(s64) = COPY $x11
+  ; CHECK-NEXT: [[B64:%[0-9]+]]:_(s64) = COPY $x12
+  ; CHECK-NEXT: [[B:%[0-9]+]]:_(s32) = G_TRUNC [[B64]](s64)
+  ; CHECK: $x10 = COPY [[A]](s64)
+  ; CHECK-NEXT: PseudoCRET implicit $x10
+  ret i64 %a
+}
+
+define void @ret_void() addrspace(200) {
+  ; CHECK-LABEL: name: ret_void
+  ; CHECK: PseudoCRET{{$}}
+  ret void
+}
+
+declare i8 addrspace(200)* @callee(i8 addrspace(200)*, i64) addrspace(200)
+
+define i8 addrspace(200)* @call_direct(i8 addrspace(200)* %p) addrspace(200) {
+  ; CHECK-LABEL: name: call_direct
+  ; CHECK-DAG: [[P:%[0-9]+]]:_(p200) = COPY $c10
+  ; CHECK-DAG: [[ONE:%[0-9]+]]:_(s64) = G_CONSTANT i64 1
+  ; CHECK: ADJCALLSTACKDOWNCAP 0, 0
+  ; CHECK-NEXT: $c10 = COPY [[P]](p200)
+  ; CHECK-NEXT: $x11 = COPY [[ONE]](s64)
+  ; CHECK-NEXT: PseudoCCALL target-flags(riscv-ccall) @callee, {{.*}}, implicit $c10, implicit $x11, implicit-def $c10
+  ; CHECK-NEXT: [[R:%[0-9]+]]:_(p200) = COPY $c10
+  ; CHECK-NEXT: ADJCALLSTACKUPCAP 0, 0
+  ; CHECK-NEXT: $c10 = COPY [[R]](p200)
+  ; CHECK-NEXT: PseudoCRET implicit $c10
+  %r = call i8 addrspace(200)* @callee(i8 addrspace(200)* %p, i64 1)
+  ret i8 addrspace(200)* %r
+}
+
+define void @call_indirect(void (i8 addrspace(200)*) addrspace(200)* %fp,
+                           i8 addrspace(200)* %p) addrspace(200) {
+  ; CHECK-LABEL: name: call_indirect
+  ; CHECK: [[FP:%[0-9]+]]:gpcr(p200) = COPY $c10
+  ; CHECK-NEXT: [[P:%[0-9]+]]:_(p200) = COPY $c11
+  ; CHECK: ADJCALLSTACKDOWNCAP 0, 0
+  ; CHECK-NEXT: $c10 = COPY [[P]](p200)
+  ; CHECK-NEXT: PseudoCCALLIndirect [[FP]](p200), {{.*}}, implicit $c10
+  ; CHECK-NEXT: ADJCALLSTACKUPCAP 0, 0
+  call void %fp(i8 addrspace(200)* %p)
+  ret void
+}
+
+; Values that would be passed on the stack are not handled yet, so the
+; translator falls back to SelectionDAG for this function.
+define i64 @stack_args(i64 %a, i64 %b, i64 %c, i64 %d, i64 %e, i64 %f,
+                       i64 %g, i64 %h, i64 %i) addrspace(200) {
+  ; CHECK-LABEL: name: stack_args
+  ; CHECK: failedISel: true
+  ret i64 %i
+}
@@ -0,0 +1,102 @@
+; RUN: llc -mtriple=riscv64 -mattr=+xcheri,+cap-mode -target-abi l64pc128d \
+; RUN:   -verify-machineinstrs < %s | FileCheck %s
+
+; Capability address and offset round trips are folded by the DAG combiner,
+; and by a machine pass when they span basic blocks.
+
+declare i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)*)
+declare i8 addrspace(200)* @llvm.cheri.cap.address.set.i64(i8 addrspace(200)*, i64)
+declare i64 @llvm.cheri.cap.offset.get.i64(i8 addrspace(200)*)
+declare i8 addrspace(200)* @llvm.cheri.cap.offset.set.i64(i8 addrspace(200)*, i64)
+
+define i8 addrspace(200)* @set_addr_of_get_addr(i8 addrspace(200)* %p) addrspace(200) nounwind {
+; CHECK-LABEL: set_addr_of_get_addr:
+; CHECK-NOT:     cgetaddr
+; CHECK-NOT:     csetaddr
+; CHECK:         cret
+  %a = call i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)* %p)
+  %q = call i8 addrspace(200)* @llvm.cheri.cap.address.set.i64(i8 addrspace(200)* %p, i64 %a)
+  ret i8 addrspace(200)* %q
+}
+
+define i8 addrspace(200)* @set_offset_of_get_offset(i8 addrspace(200)* %p) addrspace(200) nounwind {
+; CHECK-LABEL: set_offset_of_get_offset:
+; CHECK-NOT:     cgetoffset
+; CHECK-NOT:     csetoffset
+; CHECK:         cret
+  %o = call i64 @llvm.cheri.cap.offset.get.i64(i8 addrspace(200)* %p)
+  %q = call i8 addrspace(200)* @llvm.cheri.cap.offset.set.i64(i8 addrspace(200)* %p, i64 %o)
+  ret i8 addrspace(200)* %q
+}
+
+; The address of a different capability is not folded.
+define i8 addrspace(200)* @set_addr_of_other(i8 addrspace(200)* %p,
+                                             i8 addrspace(200)* %q) addrspace(200) nounwind {
+; CHECK-LABEL: set_addr_of_other:
+; CHECK:         cgetaddr [[A:[a-z0-9]+]], ca1
+; CHECK-NEXT:    csetaddr ca0, ca0, [[A]]
+  %a = call i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)* %q)
+  %r = call i8 addrspace(200)* @llvm.cheri.cap.address.set.i64(i8 addrspace(200)* %p, i64 %a)
+  ret i8 addrspace(200)* %r
+}
+
+define i64 @get_addr_of_set_addr(i8 addrspace(200)* %p, i64 %a) addrspace(200) nounwind {
+; CHECK-LABEL: get_addr_of_set_addr:
+; CHECK-NOT:     csetaddr
+; CHECK-NOT:     cgetaddr
+; CHECK:         mv a0, a1
+; CHECK-NEXT:    cret
+  %q = call i8 addrspace(200)* @llvm.cheri.cap.address.set.i64(i8 addrspace(200)* %p, i64 %a)
+  %r = call i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)* %q)
+  ret i64 %r
+}
+
+; In the pure-capability ABI inttoptr derives from the null capability and
+; ptrtoint is the address, so the pair folds away.
+define i64 @get_addr_of_inttoptr(i64 %a) addrspace(200) nounwind {
+; CHECK-LABEL: get_addr_of_inttoptr:
+; CHECK-NOT:     cincoffset
+; CHECK-NOT:     cgetaddr
+; CHECK:         cret
+  %p = inttoptr i64 %a to i8 addrspace(200)*
+  %r = call i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)* %p)
+  ret i64 %r
+}
+
+define i64 @ptrtoint_of_inttoptr(i64 %a) addrspace(200) nounwind {
+; CHECK-LABEL: ptrtoint_of_inttoptr:
+; CHECK-NOT:     cincoffset
+; CHECK-NOT:     cgetaddr
+; CHECK:         cret
+  %p = inttoptr i64 %a to i8 addrspace(200)*
+  %r = ptrtoint i8 addrspace(200)* %p to i64
+  ret i64 %r
+}
+
+define i8 addrspace(200)* @ptrtoint_set_addr(i8 addrspace(200)* %p) addrspace(200) nounwind {
+; CHECK-LABEL: ptrtoint_set_addr:
+; CHECK-NOT:     cgetaddr
+; CHECK-NOT:     csetaddr
+; CHECK:         cret
+  %a = ptrtoint i8 addrspace(200)* %p to i64
+  %q = call i8 addrspace(200)* @llvm.cheri.cap.address.set.i64(i8 addrspace(200)* %p, i64 %a)
+  ret i8 addrspace(200)* %q
+}
+
+; The round trip spans basic blocks, so it is left to the machine pass.
+define i8 addrspace(200)* @set_addr_across_blocks(i8 addrspace(200)* %p, i1 %c) addrspace(200) nounwind {
+; CHECK-LABEL: set_addr_across_blocks:
+; CHECK-NOT:     cgetaddr
+; CHECK-NOT:     csetaddr
+; CHECK:         cret
+entry:
+  %a = call i64 @llvm.cheri.cap.address.get.i64(i8 addrspace(200)* %p)
+  br i1 %c, label %set, label %exit
+
+set:
+  %q = call i8 addrspace(200)* @llvm.cheri.cap.address.set.i64(i8 addrspace(200)* %p, i64 %a)
+  ret i8 addrspace(200)* %q
+
+exit:
+  ret i8 addrspace(200)* null
+}
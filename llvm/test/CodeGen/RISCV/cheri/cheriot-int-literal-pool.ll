@@ -0,0 +1,154 @@
+; RUN: llc -mtriple=riscv32 -mcpu=cheriot -mattr=+xcheri -target-abi cheriot \
+; RUN:   -disable-constant-hoisting -verify-machineinstrs < %s | FileCheck %s
+; RUN: llc -mtriple=riscv32 -mcpu=cheriot -mattr=+xcheri -target-abi cheriot \
+; RUN:   -disable-constant-hoisting -riscv-disable-int-literal-pool \
+; RUN:   -verify-machineinstrs < %s | FileCheck %s --check-prefix=DISABLED
+
+; On CHERIoT, an integer constant that needs lui+addi and is built in enough
+; basic blocks is loaded from the constant pool when optimising for size.
+; Constant hoisting is disabled so that each block builds its own copy.
+
+; DISABLED-NOT: .LCPI
+
+; Three blocks: 2 + 3 loads is cheaper than 3 * (lui + addi).  The address
+; of the pool entry is built once, in the block that dominates the loads.  All
+; uses are loads within the entry, so it is not bounded.
+; CHECK:         .LCPI0_0:
+; CHECK-NEXT:    .word 305419896
+define void @three_blocks_optsize(i32 addrspace(200)* %p, i32 %c) addrspace(200) optsize nounwind {
+; CHECK-LABEL: three_blocks_optsize:
+; CHECK-NOT:     {{lui|clw}}
+; CHECK:         auipcc [[ADDR:c[a-z0-9]+]], %cheriot_compartment_hi(.LCPI0_0)
+; CHECK-NEXT:    cincoffset [[ADDR]], [[ADDR]], %cheriot_compartment_lo_i(.LBB0_{{[0-9]+}})
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         clw [[V0:[a-z0-9]+]], 0([[ADDR]])
+; CHECK-NEXT:    csw [[V0]], {{[0-9]+}}(c{{[a-z0-9]+}})
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         clw [[V1:[a-z0-9]+]], 0([[ADDR]])
+; CHECK-NEXT:    csw [[V1]], {{[0-9]+}}(c{{[a-z0-9]+}})
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         clw [[V2:[a-z0-9]+]], 0([[ADDR]])
+; CHECK-NEXT:    csw [[V2]], {{[0-9]+}}(c{{[a-z0-9]+}})
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         .Lfunc_end0:
+entry:
+  switch i32 %c, label %exit [
+    i32 0, label %a
+    i32 1, label %b
+    i32 2, label %d
+  ]
+
+a:
+  store volatile i32 305419896, i32 addrspace(200)* %p
+  br label %exit
+
+b:
+  %pb = getelementptr i32, i32 addrspace(200)* %p, i32 1
+  store volatile i32 305419896, i32 addrspace(200)* %pb
+  br label %exit
+
+d:
+  %pd = getelementptr i32, i32 addrspace(200)* %p, i32 2
+  store volatile i32 305419896, i32 addrspace(200)* %pd
+  br label %exit
+
+exit:
+  ret void
+}
+
+; Without optsize a load is costed as two instructions, so the constant stays
+; inline.
+define void @three_blocks(i32 addrspace(200)* %p, i32 %c) addrspace(200) nounwind {
+; CHECK-LABEL: three_blocks:
+; CHECK-NOT:     .LCPI1_
+; CHECK:         lui {{[a-z0-9]+}}, 74565
+; CHECK-NOT:     .LCPI1_
+; CHECK:         .Lfunc_end1:
+entry:
+  switch i32 %c, label %exit [
+    i32 0, label %a
+    i32 1, label %b
+    i32 2, label %d
+  ]
+
+a:
+  store volatile i32 305419896, i32 addrspace(200)* %p
+  br label %exit
+
+b:
+  %pb = getelementptr i32, i32 addrspace(200)* %p, i32 1
+  store volatile i32 305419896, i32 addrspace(200)* %pb
+  br label %exit
+
+d:
+  %pd = getelementptr i32, i32 addrspace(200)* %p, i32 2
+  store volatile i32 305419896, i32 addrspace(200)* %pd
+  br label %exit
+
+exit:
+  ret void
+}
+
+; Two blocks: 2 + 2 loads is no better than 2 * (lui + addi).
+define void @two_blocks_optsize(i32 addrspace(200)* %p, i1 %c) addrspace(200) optsize nounwind {
+; CHECK-LABEL: two_blocks_optsize:
+; CHECK-NOT:     .LCPI2_
+; CHECK:         lui {{[a-z0-9]+}}, 74565
+; CHECK-NOT:     .LCPI2_
+; CHECK:         .Lfunc_end2:
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  store volatile i32 305419896, i32 addrspace(200)* %p
+  ret void
+
+b:
+  %pb = getelementptr i32, i32 addrspace(200)* %p, i32 1
+  store volatile i32 305419896, i32 addrspace(200)* %pb
+  ret void
+}
+
+; Uses within one block share a single lui + addi.
+define void @one_block_optsize(i32 addrspace(200)* %p) addrspace(200) optsize nounwind {
+; CHECK-LABEL: one_block_optsize:
+; CHECK-NOT:     .LCPI3_
+; CHECK:         lui {{[a-z0-9]+}}, 74565
+; CHECK-NOT:     .LCPI3_
+; CHECK:         .Lfunc_end3:
+  store volatile i32 305419896, i32 addrspace(200)* %p
+  %p1 = getelementptr i32, i32 addrspace(200)* %p, i32 1
+  store volatile i32 305419896, i32 addrspace(200)* %p1
+  %p2 = getelementptr i32, i32 addrspace(200)* %p, i32 2
+  store volatile i32 305419896, i32 addrspace(200)* %p2
+  ret void
+}
+
+; The entry block uses the constant as well, so the address built there is
+; kept and reused by the other two blocks.
+define void @dominating_use_optsize(i32 addrspace(200)* %p, i1 %c) addrspace(200) optsize nounwind {
+; CHECK-LABEL: dominating_use_optsize:
+; CHECK-NOT:     {{lui|clw}}
+; CHECK:         auipcc [[ADDR:c[a-z0-9]+]], %cheriot_compartment_hi(.LCPI4_0)
+; CHECK-NEXT:    cincoffset [[ADDR]], [[ADDR]], %cheriot_compartment_lo_i(.LBB4_{{[0-9]+}})
+; CHECK-NEXT:    clw [[V0:[a-z0-9]+]], 0([[ADDR]])
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         clw {{[a-z0-9]+}}, 0([[ADDR]])
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         clw {{[a-z0-9]+}}, 0([[ADDR]])
+; CHECK-NOT:     {{auipcc|csetbounds|lui}}
+; CHECK:         .Lfunc_end4:
+entry:
+  store volatile i32 305419896, i32 addrspace(200)* %p
+  br i1 %c, label %a, label %b
+
+a:
+  %pa = getelementptr i32, i32 addrspace(200)* %p, i32 1
+  store volatile i32 305419896, i32 addrspace(200)* %pa
+  ret void
+
+b:
+  %pb = getelementptr i32, i32 addrspace(200)* %p, i32 2
+  store volatile i32 305419896, i32 addrspace(200)* %pb
+  ret void
+}
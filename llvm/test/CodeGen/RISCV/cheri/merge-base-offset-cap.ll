@@ -0,0 +1,33 @@
+; RUN: llc -mtriple=riscv64 -mattr=+xcheri,+cap-mode -target-abi l64pc128d \
+; RUN:   -verify-machineinstrs < %s | FileCheck %s
+; RUN: llc -mtriple=riscv32 -mcpu=cheriot -mattr=+xcheri -target-abi cheriot \
+; RUN:   -verify-machineinstrs < %s | FileCheck %s
+
+; Accesses to fields of a global use the capability for the whole global with
+; the field offset in the load or store immediate, rather than a cincoffset.
+
+@g = addrspace(200) global [16 x i32] zeroinitializer
+
+define i32 @fields(i1 %c) addrspace(200) nounwind {
+; CHECK-LABEL: fields:
+; CHECK-NOT:     cincoffset
+; CHECK:         {{cllc|clgc}} [[G:c[a-z0-9]+]], g
+; CHECK-NOT:     cincoffset
+; CHECK:         clw {{[a-z0-9]+}}, 16([[G]])
+; CHECK-NOT:     cincoffset
+; CHECK:         csw {{[a-z0-9]+}}, 32(c{{[a-z0-9]+}})
+; CHECK-NOT:     cincoffset
+; CHECK:         .Lfunc_end0:
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  %pa = getelementptr [16 x i32], [16 x i32] addrspace(200)* @g, i32 0, i32 4
+  %va = load i32, i32 addrspace(200)* %pa
+  ret i32 %va
+
+b:
+  %pb = getelementptr [16 x i32], [16 x i32] addrspace(200)* @g, i32 0, i32 8
+  store i32 1, i32 addrspace(200)* %pb
+  ret i32 0
+}
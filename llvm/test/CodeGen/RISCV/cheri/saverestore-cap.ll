@@ -0,0 +1,61 @@
+; RUN: llc -mtriple=riscv64 -mattr=+xcheri,+cap-mode,+save-restore \
+; RUN:   -target-abi l64pc128d -verify-machineinstrs < %s \
+; RUN:   | FileCheck %s --check-prefixes=CHECK,PURECAP
+; RUN: llc -mtriple=riscv32 -mcpu=cheriot -mattr=+xcheri,+save-restore \
+; RUN:   -target-abi cheriot -verify-machineinstrs < %s \
+; RUN:   | FileCheck %s --check-prefixes=CHECK,CHERIOT
+; RUN: llc -mtriple=riscv64 -mattr=+xcheri,+cap-mode \
+; RUN:   -target-abi l64pc128d -verify-machineinstrs < %s \
+; RUN:   | FileCheck %s --check-prefix=NOLIBCALL
+
+; With -msave-restore, purecap functions save and restore the capability
+; callee-saved registers with the __riscv_save_cap_N and __riscv_restore_cap_N
+; libcalls. The save is called through ct0 and the restore is a tail call.
+; Each register gets a capability-sized slot, which the CFI offsets match.
+
+declare void @g(i8 addrspace(200)*) addrspace(200)
+
+define i8 addrspace(200)* @ra_only(i8 addrspace(200)* %a) addrspace(200) {
+; CHECK-LABEL: ra_only:
+; CHECK:         ccall ct0, __riscv_save_cap_0
+; CHECK-NEXT:    .cfi_def_cfa_offset 16
+; PURECAP-NEXT:  .cfi_offset {{c?ra}}, -16
+; CHERIOT-NEXT:  .cfi_offset {{c?ra}}, -8
+; CHECK:         ctail __riscv_restore_cap_0
+; CHECK-NOT:     cret
+; CHECK-LABEL: .Lfunc_end0:
+; NOLIBCALL-LABEL: ra_only:
+; NOLIBCALL-NOT: __riscv_save
+; NOLIBCALL:     csc cra,
+; NOLIBCALL:     clc cra,
+; NOLIBCALL:     cret
+  call void @g(i8 addrspace(200)* %a)
+  ret i8 addrspace(200)* null
+}
+
+define i8 addrspace(200)* @ra_s0_s1(i8 addrspace(200)* %a,
+                                    i8 addrspace(200)* %b) addrspace(200) {
+; CHECK-LABEL: ra_s0_s1:
+; CHECK:         ccall ct0, __riscv_save_cap_2
+; PURECAP-NEXT:  .cfi_def_cfa_offset 48
+; CHERIOT-NEXT:  .cfi_def_cfa_offset 32
+; PURECAP-DAG:   .cfi_offset {{c?ra}}, -16
+; PURECAP-DAG:   .cfi_offset {{c?s0}}, -32
+; PURECAP-DAG:   .cfi_offset {{c?s1}}, -48
+; CHERIOT-DAG:   .cfi_offset {{c?ra}}, -8
+; CHERIOT-DAG:   .cfi_offset {{c?s0}}, -16
+; CHERIOT-DAG:   .cfi_offset {{c?s1}}, -24
+; CHECK:         ccall g
+; CHECK:         ccall g
+; CHECK:         ctail __riscv_restore_cap_2
+; CHECK-NOT:     cret
+; CHECK-LABEL: .Lfunc_end1:
+; NOLIBCALL-LABEL: ra_s0_s1:
+; NOLIBCALL-NOT: __riscv_save
+; NOLIBCALL:     cret
+  call void @g(i8 addrspace(200)* %a)
+  call void @g(i8 addrspace(200)* %b)
+  %c = getelementptr i8, i8 addrspace(200)* %a, i64 1
+  call void @g(i8 addrspace(200)* %b)
+  ret i8 addrspace(200)* %c
+}
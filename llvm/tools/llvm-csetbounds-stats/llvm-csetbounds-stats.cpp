@@ -0,0 +1,286 @@
+//===- llvm-csetbounds-stats.cpp - Merge and analyze CSetBounds stats -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// llvm-csetbounds-stats merges the binary CSetBounds statistics written with
+// -collect-csetbounds-stats=binary and joins them with sampled execution
+// counts to find the bounds-setting sites that matter at run time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CheriSetBounds.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::cheri;
+
+static StringRef ToolName;
+
+LLVM_ATTRIBUTE_NORETURN static void exitWithError(const Twine &Message,
+                                                  StringRef Whence = "") {
+  WithColor::error(errs(), ToolName);
+  if (!Whence.empty())
+    errs() << Whence << ": ";
+  errs() << Message << "\n";
+  exit(1);
+}
+
+static void readProfiles(ArrayRef<std::string> Inputs,
+                         CSetBoundsProfile &Profile) {
+  if (Inputs.empty())
+    exitWithError("no input files specified");
+  for (const std::string &Input : Inputs) {
+    auto BufOrErr = MemoryBuffer::getFileOrSTDIN(Input);
+    if (!BufOrErr)
+      exitWithError(BufOrErr.getError().message(), Input);
+    StringRef Data = (*BufOrErr)->getBuffer();
+    // An empty stats file just means no CSetBounds were emitted.
+    if (!Data.empty() && !CSetBoundsProfile::hasBinaryMagic(Data))
+      exitWithError("not a binary CSetBounds profile (compile with "
+                    "-collect-csetbounds-stats=binary)",
+                    Input);
+    if (Error E = Profile.read(Data))
+      exitWithError(toString(std::move(E)), Input);
+  }
+}
+
+static std::unique_ptr<ToolOutputFile> openOutput(StringRef Filename,
+                                                  sys::fs::OpenFlags Flags) {
+  std::error_code EC;
+  auto Out = std::make_unique<ToolOutputFile>(Filename, EC, Flags);
+  if (EC)
+    exitWithError(EC.message(), Filename);
+  return Out;
+}
+
+static void printSize(raw_ostream &OS, const CSetBoundsStatistics::Entry &E) {
+  if (E.RequestedSize)
+    OS << *E.RequestedSize;
+  else if (E.RequestedSizeMultipleOf)
+    OS << "<unknown multiple of " << *E.RequestedSizeMultipleOf << ">";
+  else
+    OS << "<unknown>";
+}
+
+/// Print the columns shared by the show and join output, matching the
+/// -collect-csetbounds-stats=csv format.
+static void printSiteColumns(raw_ostream &OS,
+                             const CSetBoundsStatistics::Entry &E) {
+  OS << Log2(E.KnownAlignment) << ',';
+  printSize(OS, E);
+  OS << ',' << getPointerKindLetter(E.PointerKind);
+  OS << ",\"" << yaml::escape(E.SourceLocation) << '"';
+  OS << ",\"" << yaml::escape(E.Pass) << '"';
+  OS << ",\"" << yaml::escape(E.Details) << '"';
+}
+
+static int merge_main(int argc, const char *argv[]) {
+  cl::list<std::string> Inputs(cl::Positional, cl::OneOrMore,
+                               cl::desc("<profile files>"));
+  cl::opt<std::string> OutputFilename("output", cl::Required,
+                                      cl::desc("Output file"));
+  cl::alias OutputFilenameA("o", cl::desc("Alias for --output"),
+                            cl::aliasopt(OutputFilename));
+  cl::ParseCommandLineOptions(argc, argv, "CSetBounds profile merger\n");
+
+  CSetBoundsProfile Profile;
+  readProfiles(Inputs, Profile);
+  auto Out = openOutput(OutputFilename, sys::fs::OF_None);
+  Profile.write(Out->os());
+  Out->keep();
+  return 0;
+}
+
+static int show_main(int argc, const char *argv[]) {
+  cl::list<std::string> Inputs(cl::Positional, cl::OneOrMore,
+                               cl::desc("<profile files>"));
+  cl::opt<std::string> OutputFilename("output", cl::init("-"),
+                                      cl::desc("Output file"));
+  cl::alias OutputFilenameA("o", cl::desc("Alias for --output"),
+                            cl::aliasopt(OutputFilename));
+  cl::ParseCommandLineOptions(argc, argv, "CSetBounds profile viewer\n");
+
+  CSetBoundsProfile Profile;
+  readProfiles(Inputs, Profile);
+  std::vector<const CSetBoundsProfile::Record *> Sorted;
+  for (const CSetBoundsProfile::Record &R : Profile.records())
+    Sorted.push_back(&R);
+  llvm::stable_sort(Sorted, [](const CSetBoundsProfile::Record *LHS,
+                               const CSetBoundsProfile::Record *RHS) {
+    return LHS->Count > RHS->Count;
+  });
+
+  auto Out = openOutput(OutputFilename, sys::fs::OF_Text);
+  raw_ostream &OS = Out->os();
+  OS << "count,alignment_bits,size,kind,source_loc,compiler_pass,details\n";
+  for (const CSetBoundsProfile::Record *R : Sorted) {
+    OS << R->Count << ',';
+    printSiteColumns(OS, R->Site);
+    OS << '\n';
+  }
+  Out->keep();
+  return 0;
+}
+
+/// Split a location as printed by DebugLoc::print() ("file:line:col", followed
+/// by " @[ ... ]" for inlined code) or "file:line" into the file name and line,
+/// ignoring the inlined-at locations. Returns false for locations without line
+/// information.
+static bool parseSourceLocation(StringRef Loc, StringRef &File,
+                                unsigned &Line) {
+  Loc = Loc.substr(0, Loc.find(" @[")).trim();
+  StringRef LineStr;
+  std::tie(File, LineStr) = Loc.rsplit(':');
+  if (File.empty() || LineStr.getAsInteger(10, Line))
+    return false;
+  // The last number was the column if it is preceded by another one.
+  StringRef Prefix, MaybeLine;
+  std::tie(Prefix, MaybeLine) = File.rsplit(':');
+  if (!Prefix.empty() && !MaybeLine.getAsInteger(10, Line))
+    File = Prefix;
+  return true;
+}
+
+/// Samples are matched on the file name without directories since the paths
+/// recorded by the compiler and the profiler rarely agree.
+static std::string getSampleKey(StringRef File, unsigned Line) {
+  return (sys::path::filename(File) + ":" + Twine(Line)).str();
+}
+
+/// Read a sample file in which every non-empty line has the form
+/// "<file>:<line> <count>". Lines starting with '#' are ignored and the counts
+/// of duplicate locations are summed.
+static StringMap<uint64_t> readSamples(StringRef Filename) {
+  auto BufOrErr = MemoryBuffer::getFileOrSTDIN(Filename);
+  if (!BufOrErr)
+    exitWithError(BufOrErr.getError().message(), Filename);
+  StringMap<uint64_t> Samples;
+  for (line_iterator LI(**BufOrErr, /*SkipBlanks=*/true, '#'); !LI.is_at_eof();
+       ++LI) {
+    StringRef Loc, CountStr;
+    std::tie(Loc, CountStr) = LI->trim().rsplit(' ');
+    StringRef File;
+    unsigned Line;
+    uint64_t Count;
+    if (CountStr.trim().getAsInteger(10, Count) ||
+        !parseSourceLocation(Loc, File, Line))
+      exitWithError("expected '<file>:<line> <count>' on line " +
+                        Twine(LI.line_number()),
+                    Filename);
+    Samples[getSampleKey(File, Line)] += Count;
+  }
+  return Samples;
+}
+
+static int join_main(int argc, const char *argv[]) {
+  cl::list<std::string> Inputs(cl::Positional, cl::OneOrMore,
+                               cl::desc("<profile files>"));
+  cl::opt<std::string> SamplesFilename(
+      "samples", cl::Required,
+      cl::desc("Sampled execution counts, one '<file>:<line> <count>' per "
+               "line"));
+  cl::opt<std::string> OutputFilename("output", cl::init("-"),
+                                      cl::desc("Output file"));
+  cl::alias OutputFilenameA("o", cl::desc("Alias for --output"),
+                            cl::aliasopt(OutputFilename));
+  cl::opt<bool> ShowUnsampled(
+      "show-unsampled", cl::init(false),
+      cl::desc("Also list bounds-setting sites without any samples"));
+  cl::ParseCommandLineOptions(
+      argc, argv, "Join CSetBounds profiles with sampled execution counts\n");
+
+  CSetBoundsProfile Profile;
+  readProfiles(Inputs, Profile);
+  StringMap<uint64_t> Samples = readSamples(SamplesFilename);
+
+  struct JoinedSite {
+    const CSetBoundsProfile::Record *Record;
+    uint64_t Samples;
+  };
+  std::vector<JoinedSite> Joined;
+  uint64_t TotalSamples = 0;
+  for (const auto &S : Samples)
+    TotalSamples += S.getValue();
+  for (const CSetBoundsProfile::Record &R : Profile.records()) {
+    StringRef File;
+    unsigned Line;
+    uint64_t Count = 0;
+    if (parseSourceLocation(R.Site.SourceLocation, File, Line))
+      Count = Samples.lookup(getSampleKey(File, Line));
+    if (Count || ShowUnsampled)
+      Joined.push_back({&R, Count});
+  }
+  llvm::stable_sort(Joined, [](const JoinedSite &LHS, const JoinedSite &RHS) {
+    return LHS.Samples > RHS.Samples;
+  });
+
+  auto Out = openOutput(OutputFilename, sys::fs::OF_Text);
+  raw_ostream &OS = Out->os();
+  OS << "samples,samples_percent,count,alignment_bits,size,kind,source_loc,"
+        "compiler_pass,details\n";
+  for (const JoinedSite &J : Joined) {
+    OS << J.Samples << ',';
+    OS << format("%.2f", TotalSamples ? 100.0 * J.Samples / TotalSamples : 0.0);
+    OS << ',' << J.Record->Count << ',';
+    printSiteColumns(OS, J.Record->Site);
+    OS << '\n';
+  }
+  Out->keep();
+  return 0;
+}
+
+int main(int argc, const char *argv[]) {
+  InitLLVM X(argc, argv);
+
+  ToolName = sys::path::filename(argv[0]);
+  if (argc > 1) {
+    int (*func)(int, const char *[]) = nullptr;
+
+    if (strcmp(argv[1], "merge") == 0)
+      func = merge_main;
+    else if (strcmp(argv[1], "show") == 0)
+      func = show_main;
+    else if (strcmp(argv[1], "join") == 0)
+      func = join_main;
+
+    if (func) {
+      std::string Invocation(ToolName.str() + " " + argv[1]);
+      argv[1] = Invocation.c_str();
+      return func(argc - 1, argv + 1);
+    }
+
+    if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "-help") == 0 ||
+        strcmp(argv[1], "--help") == 0) {
+      errs() << "OVERVIEW: CHERI CSetBounds statistics tool\n\n"
+             << "USAGE: " << ToolName << " <command> [args...]\n"
+             << "USAGE: " << ToolName << " <command> -help\n\n"
+             << "See each individual command --help for more details.\n"
+             << "Available commands: merge, show, join\n";
+      return 0;
+    }
+  }
+
+  if (argc < 2)
+    errs() << ToolName << ": No command specified!\n";
+  else
+    errs() << ToolName << ": Unknown command!\n";
+
+  errs() << "USAGE: " << ToolName << " <merge|show|join> [args...]\n";
+  return 1;
+}
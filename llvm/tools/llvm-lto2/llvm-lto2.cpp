@@ -441,6 +441,7 @@ static int dumpSymtab(int argc, char **argv) {
       PrintBool('O', Sym.canBeOmittedFromSymbolTable());
       PrintBool('T', Sym.isTLS());
       PrintBool('X', Sym.isExecutable());
+      PrintBool('E', Sym.isCompartmentEntry());
       outs() << ' ' << Sym.getName() << '\n';
 
       if (Sym.isCommon())
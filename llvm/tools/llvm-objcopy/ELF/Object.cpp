@@ -457,6 +457,22 @@ getDecompressedSizeAndAlignment(ArrayRef<uint8_t> Data) {
   return std::make_tuple(DecompressedSize, DecompressedAlign);
 }
 
+static Error decompressSectionData(uint32_t ChType, StringRef Input,
+                                   SmallVectorImpl<char> &Output,
+                                   size_t DecompressedSize) {
+  if (ChType == ELF::ELFCOMPRESS_ZSTD) {
+    if (!zstd::isAvailable())
+      return createStringError(
+          errc::not_supported,
+          "LLVM was not compiled with LLVM_ENABLE_ZSTD: cannot decompress");
+    return zstd::uncompress(Input, Output, DecompressedSize);
+  }
+  if (ChType != ELF::ELFCOMPRESS_ZLIB)
+    return createStringError(errc::not_supported,
+                             "unsupported compression type %u", ChType);
+  return zlib::uncompress(Input, Output, DecompressedSize);
+}
+
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const DecompressedSection &Sec) {
   const size_t DataOffset = isDataGnuCompressed(Sec.OriginalData)
@@ -467,9 +483,16 @@ Error ELFSectionWriter<ELFT>::visit(const DecompressedSection &Sec) {
       reinterpret_cast<const char *>(Sec.OriginalData.data()) + DataOffset,
       Sec.OriginalData.size() - DataOffset);
 
+  uint32_t ChType = ELF::ELFCOMPRESS_ZLIB;
+  if (!isDataGnuCompressed(Sec.OriginalData))
+    ChType = reinterpret_cast<const Elf_Chdr_Impl<ELFT> *>(
+                 Sec.OriginalData.data())
+                 ->ch_type;
+
   SmallVector<char, 128> DecompressedContent;
-  if (Error Err = zlib::uncompress(CompressedContent, DecompressedContent,
-                                   static_cast<size_t>(Sec.Size)))
+  if (Error Err = decompressSectionData(ChType, CompressedContent,
+                                        DecompressedContent,
+                                        static_cast<size_t>(Sec.Size)))
     return createStringError(errc::invalid_argument,
                              "'" + Sec.Name + "': " + toString(std::move(Err)));
 
@@ -534,7 +557,9 @@ Error ELFSectionWriter<ELFT>::visit(const CompressedSection &Sec) {
     Buf += sizeof(DecompressedSize);
   } else {
     Elf_Chdr_Impl<ELFT> Chdr;
-    Chdr.ch_type = ELF::ELFCOMPRESS_ZLIB;
+    Chdr.ch_type = Sec.CompressionType == DebugCompressionType::Zstd
+                       ? ELF::ELFCOMPRESS_ZSTD
+                       : ELF::ELFCOMPRESS_ZLIB;
     Chdr.ch_size = Sec.DecompressedSize;
     Chdr.ch_addralign = Sec.DecompressedAlign;
     memcpy(Buf, &Chdr, sizeof(Chdr));
@@ -570,10 +595,11 @@ CompressedSection::CompressedSection(const SectionBase &Sec,
       DecompressedSize(Sec.OriginalData.size()), DecompressedAlign(Sec.Align) {
   ErrorAsOutParameter EAO(&OutErr);
 
-  if (Error Err = zlib::compress(
-          StringRef(reinterpret_cast<const char *>(OriginalData.data()),
-                    OriginalData.size()),
-          CompressedData)) {
+  StringRef Input(reinterpret_cast<const char *>(OriginalData.data()),
+                  OriginalData.size());
+  if (Error Err = CompressionType == DebugCompressionType::Zstd
+                      ? zstd::compress(Input, CompressedData)
+                      : zlib::compress(Input, CompressedData)) {
     OutErr = createStringError(llvm::errc::invalid_argument,
                                "'" + Name + "': " + toString(std::move(Err)));
     return;
@@ -13,6 +13,8 @@
 
 #include "ObjDumper.h"
 #include "llvm-readobj.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Object/Decompressor.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FormatVariadic.h"
@@ -114,8 +116,39 @@ getSectionRefsByNameOrIndex(const object::ObjectFile &Obj,
   return Ret;
 }
 
+// Replace SectionContent with the decompressed contents of Section if it is
+// compressed (zlib, zlib-gnu or zstd). On failure, warn and leave the raw
+// contents in place.
+static void maybeDecompress(const object::ObjectFile &Obj,
+                            const object::SectionRef &Section,
+                            StringRef SectionName, StringRef &SectionContent,
+                            SmallString<0> &Out) {
+  if (!object::Decompressor::isCompressed(Section))
+    return;
+  Expected<object::Decompressor> D =
+      object::Decompressor::create(SectionName, SectionContent,
+                                   Obj.isLittleEndian(),
+                                   Obj.getBytesInAddress() == 8);
+  if (!D) {
+    reportWarning(createError("section '" + SectionName +
+                              "' cannot be decompressed: " +
+                              toString(D.takeError())),
+                  Obj.getFileName());
+    return;
+  }
+  if (Error E = D->resizeAndDecompress(Out)) {
+    reportWarning(createError("section '" + SectionName +
+                              "' cannot be decompressed: " +
+                              toString(std::move(E))),
+                  Obj.getFileName());
+    return;
+  }
+  SectionContent = Out;
+}
+
 void ObjDumper::printSectionsAsString(const object::ObjectFile &Obj,
-                                      ArrayRef<std::string> Sections) {
+                                      ArrayRef<std::string> Sections,
+                                      bool Decompress) {
   bool First = true;
   for (object::SectionRef Section :
        getSectionRefsByNameOrIndex(Obj, Sections)) {
@@ -128,12 +161,16 @@ void ObjDumper::printSectionsAsString(const object::ObjectFile &Obj,
 
     StringRef SectionContent =
         unwrapOrError(Obj.getFileName(), Section.getContents());
+    SmallString<0> Out;
+    if (Decompress)
+      maybeDecompress(Obj, Section, SectionName, SectionContent, Out);
     printAsStringList(SectionContent);
   }
 }
 
 void ObjDumper::printSectionsAsHex(const object::ObjectFile &Obj,
-                                   ArrayRef<std::string> Sections) {
+                                   ArrayRef<std::string> Sections,
+                                   bool Decompress) {
   bool First = true;
   for (object::SectionRef Section :
        getSectionRefsByNameOrIndex(Obj, Sections)) {
@@ -146,6 +183,9 @@ void ObjDumper::printSectionsAsHex(const object::ObjectFile &Obj,
 
     StringRef SectionContent =
         unwrapOrError(Obj.getFileName(), Section.getContents());
+    SmallString<0> Out;
+    if (Decompress)
+      maybeDecompress(Obj, Section, SectionName, SectionContent, Out);
     const uint8_t *SecContent = SectionContent.bytes_begin();
     const uint8_t *SecEnd = SecContent + SectionContent.size();
 
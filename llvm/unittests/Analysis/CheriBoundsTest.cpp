@@ -0,0 +1,153 @@
+//===- CheriBoundsTest.cpp - Unit tests for CheriNeedBoundsChecker --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/CheriBounds.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class CheriBoundsTest : public testing::Test {
+protected:
+  void parseAssembly(StringRef Assembly) {
+    SMDiagnostic Error;
+    M = parseAssemblyString(Assembly, Error, Context);
+    std::string ErrMsg;
+    raw_string_ostream OS(ErrMsg);
+    Error.print("", OS);
+    ASSERT_TRUE(M) << OS.str();
+  }
+
+  AllocaInst *getAlloca(StringRef FuncName, StringRef Name) {
+    Function *F = M->getFunction(FuncName);
+    EXPECT_NE(F, nullptr);
+    for (Instruction &I : instructions(*F))
+      if (I.getName() == Name)
+        return cast<AllocaInst>(&I);
+    ADD_FAILURE() << "no alloca named " << Name.str();
+    return nullptr;
+  }
+
+  bool needsBounds(StringRef FuncName, StringRef Name,
+                   CheriNeedBoundsCache *Cache = nullptr) {
+    CheriNeedBoundsChecker Checker(getAlloca(FuncName, Name),
+                                   M->getDataLayout(), Cache);
+    return Checker.anyUseNeedsBounds();
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M;
+};
+
+TEST_F(CheriBoundsTest, ConstantOffsets) {
+  parseAssembly(R"(
+    define i32 @in_bounds() {
+      %a = alloca [4 x i32]
+      %p = getelementptr inbounds [4 x i32], [4 x i32]* %a, i64 0, i64 3
+      store i32 1, i32* %p
+      %v = load i32, i32* %p
+      ret i32 %v
+    }
+    define i32 @past_the_end() {
+      %a = alloca [4 x i32]
+      %p = getelementptr inbounds [4 x i32], [4 x i32]* %a, i64 0, i64 4
+      %v = load i32, i32* %p
+      ret i32 %v
+    }
+    define i32 @negative() {
+      %a = alloca [4 x i32]
+      %p = getelementptr [4 x i32], [4 x i32]* %a, i64 0, i64 -1
+      %v = load i32, i32* %p
+      ret i32 %v
+    }
+    define i32 @huge_offset() {
+      %a = alloca [4 x i32]
+      %p = getelementptr [4 x i32], [4 x i32]* %a, i64 0, i64 9223372036854775807
+      %q = getelementptr i32, i32* %p, i64 9223372036854775807
+      %v = load i32, i32* %q
+      ret i32 %v
+    }
+  )");
+  EXPECT_FALSE(needsBounds("in_bounds", "a"));
+  EXPECT_TRUE(needsBounds("past_the_end", "a"));
+  EXPECT_TRUE(needsBounds("negative", "a"));
+  EXPECT_TRUE(needsBounds("huge_offset", "a"));
+}
+
+TEST_F(CheriBoundsTest, Cycles) {
+  parseAssembly(R"(
+    declare i1 @cond()
+    define void @same_offset() {
+    entry:
+      %a = alloca i32
+      br label %loop
+    loop:
+      %p = phi i32* [ %a, %entry ], [ %p, %loop ]
+      store i32 0, i32* %p
+      %c = call i1 @cond()
+      br i1 %c, label %loop, label %exit
+    exit:
+      ret void
+    }
+    define void @increment() {
+    entry:
+      %a = alloca [4 x i32]
+      %base = getelementptr inbounds [4 x i32], [4 x i32]* %a, i64 0, i64 0
+      br label %loop
+    loop:
+      %p = phi i32* [ %base, %entry ], [ %next, %loop ]
+      store i32 0, i32* %p
+      %next = getelementptr inbounds i32, i32* %p, i64 1
+      %c = call i1 @cond()
+      br i1 %c, label %loop, label %exit
+    exit:
+      ret void
+    }
+  )");
+  // Going around the loop does not reach any new users.
+  EXPECT_FALSE(needsBounds("same_offset", "a"));
+  // Each iteration accesses a different offset.
+  EXPECT_TRUE(needsBounds("increment", "a"));
+}
+
+TEST_F(CheriBoundsTest, SharedCache) {
+  parseAssembly(R"(
+    declare void @escape(i32*)
+    define i32 @merged(i1 %c) {
+      %a = alloca i32
+      %b = alloca i32
+      %s = select i1 %c, i32* %a, i32* %b
+      %v = load i32, i32* %s
+      ret i32 %v
+    }
+    define void @merged_escape(i1 %c) {
+      %a = alloca i32
+      %b = alloca i32
+      %s = select i1 %c, i32* %a, i32* %b
+      call void @escape(i32* %s)
+      ret void
+    }
+  )");
+  CheriNeedBoundsCache Cache;
+  EXPECT_FALSE(needsBounds("merged", "a", &Cache));
+  EXPECT_FALSE(needsBounds("merged", "b", &Cache));
+  EXPECT_TRUE(needsBounds("merged_escape", "a", &Cache));
+  EXPECT_TRUE(needsBounds("merged_escape", "b", &Cache));
+  Cache.clear();
+  EXPECT_TRUE(needsBounds("merged_escape", "b", &Cache));
+}
+
+} // end anonymous namespace
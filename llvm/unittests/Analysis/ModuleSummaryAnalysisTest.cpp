@@ -0,0 +1,95 @@
+//===- ModuleSummaryAnalysisTest.cpp - ModuleSummaryAnalysis unit tests ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/ModuleSummaryAnalysis.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class ModuleSummaryAnalysisTest : public testing::Test {
+protected:
+  void parseAssembly(StringRef Assembly) {
+    SMDiagnostic Error;
+    M = parseAssemblyString(Assembly, Error, Context);
+    std::string ErrMsg;
+    raw_string_ostream OS(ErrMsg);
+    Error.print("", OS);
+    ASSERT_TRUE(M) << OS.str();
+  }
+
+  const FunctionSummary *getSummary(const ModuleSummaryIndex &Index,
+                                    StringRef Name) {
+    const Function *F = M->getFunction(Name);
+    EXPECT_NE(F, nullptr);
+    ValueInfo VI = Index.getValueInfo(F->getGUID());
+    EXPECT_TRUE(VI);
+    return cast<FunctionSummary>(VI.getSummaryList().front()->getBaseObject());
+  }
+
+  static bool hasCall(const FunctionSummary *FS, const Function *Callee) {
+    return llvm::any_of(FS->calls(), [&](const FunctionSummary::EdgeTy &E) {
+      return E.first.getGUID() == Callee->getGUID();
+    });
+  }
+
+  static bool hasRef(const FunctionSummary *FS, const Function *Callee) {
+    return llvm::any_of(FS->refs(), [&](const ValueInfo &VI) {
+      return VI.getGUID() == Callee->getGUID();
+    });
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M;
+};
+
+// Calls into another compartment must not become importable call edges, but
+// the callee still has to be referenced so that it is kept alive.
+TEST_F(ModuleSummaryAnalysisTest, CrossCompartmentCallIsNotACallEdge) {
+  parseAssembly(R"(
+    define chericcallcce void @entry() #0 {
+      ret void
+    }
+    define chericcallcce void @other_entry() #1 {
+      ret void
+    }
+    define void @helper() #0 {
+      ret void
+    }
+    define void @caller() #0 {
+      call chericcallcc void @other_entry()
+      call chericcallcc void @entry()
+      call void @helper()
+      ret void
+    }
+    attributes #0 = { "cheri-compartment"="alpha" }
+    attributes #1 = { "cheri-compartment"="beta" }
+  )");
+  ProfileSummaryInfo PSI(*M);
+  ModuleSummaryIndex Index = buildModuleSummaryIndex(
+      *M, [](const Function &F) { return nullptr; }, &PSI);
+  const FunctionSummary *Caller = getSummary(Index, "caller");
+
+  const Function *OtherEntry = M->getFunction("other_entry");
+  EXPECT_FALSE(hasCall(Caller, OtherEntry));
+  EXPECT_TRUE(hasRef(Caller, OtherEntry));
+
+  // Calls within the compartment are importable as before.
+  EXPECT_TRUE(hasCall(Caller, M->getFunction("entry")));
+  EXPECT_TRUE(hasCall(Caller, M->getFunction("helper")));
+}
+
+} // end anonymous namespace
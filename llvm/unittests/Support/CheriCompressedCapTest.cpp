@@ -0,0 +1,151 @@
+//===- llvm/unittest/Support/CheriCompressedCapTest.cpp -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CheriCompressedCap.h"
+#include "gtest/gtest.h"
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::cheri;
+
+namespace {
+
+template <class Format> class CheriCompressedCapTest : public ::testing::Test {
+protected:
+  using Codec = CompressedCapCodec<Format>;
+  using addr_t = typename Codec::addr_t;
+  using cap_t = typename Codec::cap_t;
+
+  // Build a mix of runs of pointers into the same object (which hit the
+  // decoder's reuse path), untagged integers and random bit patterns.
+  void makeInputs(std::vector<addr_t> &Pesbt, std::vector<addr_t> &Cursor,
+                  BitVector &Tags) {
+    std::mt19937_64 Rng(42);
+    for (unsigned Obj = 0; Obj < 64; ++Obj) {
+      // Keep the objects in the lower half of the address space so that
+      // rounding up the bounds can never overflow.
+      addr_t Base = static_cast<addr_t>(Rng()) &
+                    (std::numeric_limits<addr_t>::max() >> 1) & ~addr_t(0xf);
+      addr_t Len = static_cast<addr_t>(Rng() % (Obj < 32 ? 256 : 1 << 20));
+      cap_t Cap = Format::make_max_perms_cap(
+          0, Base, typename Format::length_t(1) << (sizeof(addr_t) * 8));
+      Format::setbounds(&Cap, Base, (typename Format::length_t)Base + Len);
+      addr_t Mem = Format::compress_mem(&Cap);
+      for (unsigned I = 0; I < 8; ++I) {
+        Pesbt.push_back(Mem);
+        Cursor.push_back(Cap.base() + (Len ? Rng() % Len : 0));
+        Tags.push_back(true);
+      }
+      Pesbt.push_back(0);
+      Cursor.push_back(static_cast<addr_t>(Rng()));
+      Tags.push_back(false);
+      Pesbt.push_back(static_cast<addr_t>(Rng()));
+      Cursor.push_back(static_cast<addr_t>(Rng()));
+      Tags.push_back(false);
+    }
+  }
+};
+
+using Formats = ::testing::Types<CompressedCap64, CompressedCap128>;
+TYPED_TEST_SUITE(CheriCompressedCapTest, Formats, );
+
+TYPED_TEST(CheriCompressedCapTest, BatchMatchesScalarDecode) {
+  using Codec = typename TestFixture::Codec;
+  using addr_t = typename TestFixture::addr_t;
+  using cap_t = typename TestFixture::cap_t;
+  std::vector<addr_t> Pesbt, Cursor;
+  BitVector Tags;
+  this->makeInputs(Pesbt, Cursor, Tags);
+
+  std::vector<cap_t> Batch(Pesbt.size());
+  Codec::decode(Pesbt, Cursor, &Tags, Batch);
+  for (size_t I = 0; I < Pesbt.size(); ++I) {
+    cap_t Expected;
+    TypeParam::decompress_mem(Pesbt[I], Cursor[I], Tags[I], &Expected);
+    EXPECT_EQ(Expected, Batch[I]) << "index " << I;
+    EXPECT_EQ(Expected.base(), Batch[I].base()) << "index " << I;
+    EXPECT_EQ(Expected.top(), Batch[I].top()) << "index " << I;
+    EXPECT_EQ(Expected.cr_exp, Batch[I].cr_exp) << "index " << I;
+  }
+}
+
+// Decode arbitrary (untagged) bit patterns with many different cursors per
+// metadata word, including cursors close to the edges of the representable
+// region and of the address space, to check that the decoder never reuses
+// bounds that a full decompression would compute differently.
+TYPED_TEST(CheriCompressedCapTest, RandomBitPatterns) {
+  using Codec = typename TestFixture::Codec;
+  using addr_t = typename TestFixture::addr_t;
+  using cap_t = typename TestFixture::cap_t;
+  std::mt19937_64 Rng(1234);
+  std::vector<addr_t> Pesbt, Cursor;
+  for (unsigned I = 0; I < 2000; ++I) {
+    addr_t P = I % 4 == 0 ? 0 : static_cast<addr_t>(Rng());
+    for (unsigned J = 0; J < 16; ++J) {
+      addr_t C;
+      switch (J % 4) {
+      case 0:
+        C = static_cast<addr_t>(Rng());
+        break;
+      case 1:
+        C = Cursor.empty() ? 0 : Cursor.back() + (Rng() % 64) - 32;
+        break;
+      case 2:
+        C = std::numeric_limits<addr_t>::max() - Rng() % 4096;
+        break;
+      default:
+        C = static_cast<addr_t>(Rng() % 4096);
+        break;
+      }
+      // Shift the cursor by a random power of two to cross region edges.
+      if (Rng() % 2)
+        C += addr_t(1) << (Rng() % (sizeof(addr_t) * 8));
+      Pesbt.push_back(P);
+      Cursor.push_back(C);
+    }
+  }
+  std::vector<cap_t> Batch(Pesbt.size());
+  Codec::decode(Pesbt, Cursor, nullptr, Batch);
+  for (size_t I = 0; I < Pesbt.size(); ++I) {
+    cap_t Expected;
+    TypeParam::decompress_mem(Pesbt[I], Cursor[I], false, &Expected);
+    ASSERT_EQ(Expected.base(), Batch[I].base()) << "index " << I;
+    ASSERT_EQ(Expected.top(), Batch[I].top()) << "index " << I;
+    ASSERT_EQ(Expected.cr_exp, Batch[I].cr_exp) << "index " << I;
+    ASSERT_EQ(Expected.cr_bounds_valid, Batch[I].cr_bounds_valid)
+        << "index " << I;
+    ASSERT_EQ(Expected, Batch[I]) << "index " << I;
+  }
+}
+
+TYPED_TEST(CheriCompressedCapTest, RoundTripThroughMemory) {
+  using Codec = typename TestFixture::Codec;
+  using addr_t = typename TestFixture::addr_t;
+  using cap_t = typename TestFixture::cap_t;
+  std::vector<addr_t> Pesbt, Cursor;
+  BitVector Tags;
+  this->makeInputs(Pesbt, Cursor, Tags);
+  std::vector<cap_t> Caps(Pesbt.size());
+  Codec::decode(Pesbt, Cursor, &Tags, Caps);
+
+  for (support::endianness Endian : {support::little, support::big}) {
+    for (CapabilityWordOrder Order : {CapabilityWordOrder::CursorFirst,
+                                      CapabilityWordOrder::PesbtFirst}) {
+      std::vector<uint8_t> Bytes(Caps.size() * Codec::CapBytes);
+      Codec::encode(Caps, Endian, Order, Bytes);
+      std::vector<cap_t> Decoded(Caps.size());
+      Codec::decode(Bytes, Endian, Order, &Tags, Decoded);
+      for (size_t I = 0; I < Caps.size(); ++I)
+        EXPECT_EQ(Caps[I], Decoded[I]) << "index " << I;
+    }
+  }
+}
+
+} // end anonymous namespace
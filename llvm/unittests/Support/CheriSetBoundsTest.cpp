@@ -0,0 +1,102 @@
+//===- CheriSetBoundsTest.cpp - CSetBounds profile tests ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CheriSetBounds.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::cheri;
+
+namespace {
+
+CSetBoundsStatistics::Entry makeEntry(Optional<uint64_t> Size, StringRef Loc,
+                                      SetBoundsPointerSource Kind) {
+  CSetBoundsStatistics::Entry E;
+  E.RequestedSize = Size;
+  E.KnownAlignment = Align(16);
+  E.PointerKind = Kind;
+  E.SourceLocation = Loc.str();
+  E.Pass = "CHERI bound allocas";
+  E.Details = "set bounds on alloca";
+  return E;
+}
+
+std::string writeProfile(const CSetBoundsProfile &P) {
+  std::string Buf;
+  raw_string_ostream OS(Buf);
+  P.write(OS);
+  return OS.str();
+}
+
+TEST(CSetBoundsProfileTest, RoundTrip) {
+  CSetBoundsProfile P;
+  P.add(makeEntry(32, "a.c:1:2", SetBoundsPointerSource::Stack));
+  P.add(makeEntry(32, "a.c:1:2", SetBoundsPointerSource::Stack));
+  CSetBoundsStatistics::Entry Unknown =
+      makeEntry(None, "b.c:7:1 @[ a.c:3:4 ]", SetBoundsPointerSource::Heap);
+  Unknown.RequestedSizeMultipleOf = 8;
+  P.add(Unknown);
+  ASSERT_EQ(P.records().size(), 2u);
+  EXPECT_EQ(P.totalCount(), 3u);
+
+  std::string Data = writeProfile(P);
+  EXPECT_TRUE(CSetBoundsProfile::hasBinaryMagic(Data));
+  CSetBoundsProfile Read;
+  ASSERT_THAT_ERROR(Read.read(Data), Succeeded());
+  ASSERT_EQ(Read.records().size(), 2u);
+  const CSetBoundsProfile::Record &R0 = Read.records()[0];
+  EXPECT_EQ(R0.Count, 2u);
+  EXPECT_EQ(R0.Site.RequestedSize, Optional<uint64_t>(32));
+  EXPECT_EQ(R0.Site.KnownAlignment, Align(16));
+  EXPECT_EQ(R0.Site.PointerKind, SetBoundsPointerSource::Stack);
+  EXPECT_EQ(R0.Site.SourceLocation, "a.c:1:2");
+  const CSetBoundsProfile::Record &R1 = Read.records()[1];
+  EXPECT_EQ(R1.Count, 1u);
+  EXPECT_FALSE(R1.Site.RequestedSize);
+  EXPECT_EQ(R1.Site.RequestedSizeMultipleOf, Optional<uint64_t>(8));
+  EXPECT_EQ(R1.Site.PointerKind, SetBoundsPointerSource::Heap);
+  EXPECT_EQ(R1.Site.SourceLocation, "b.c:7:1 @[ a.c:3:4 ]");
+  EXPECT_EQ(R1.Site.Pass, "CHERI bound allocas");
+}
+
+TEST(CSetBoundsProfileTest, MergeConcatenatedChunks) {
+  // Each compilation appends one chunk to the same stats file.
+  CSetBoundsProfile A, B;
+  A.add(makeEntry(32, "a.c:1:2", SetBoundsPointerSource::Stack), 5);
+  B.add(makeEntry(32, "a.c:1:2", SetBoundsPointerSource::Stack), 3);
+  B.add(makeEntry(64, "b.c:4:2", SetBoundsPointerSource::GlobalVar));
+  std::string Data = writeProfile(A) + writeProfile(B);
+
+  CSetBoundsProfile Merged;
+  ASSERT_THAT_ERROR(Merged.read(Data), Succeeded());
+  ASSERT_EQ(Merged.records().size(), 2u);
+  EXPECT_EQ(Merged.records()[0].Count, 8u);
+  EXPECT_EQ(Merged.records()[1].Count, 1u);
+
+  CSetBoundsProfile Copy;
+  Copy.merge(Merged);
+  Copy.merge(Merged);
+  EXPECT_EQ(Copy.totalCount(), 18u);
+}
+
+TEST(CSetBoundsProfileTest, Malformed) {
+  CSetBoundsProfile P;
+  P.add(makeEntry(32, "a.c:1:2", SetBoundsPointerSource::Stack));
+  std::string Data = writeProfile(P);
+
+  CSetBoundsProfile Read;
+  EXPECT_THAT_ERROR(Read.read(StringRef(Data).drop_back()), Failed());
+  EXPECT_THAT_ERROR(Read.read("not a profile"), Failed());
+  std::string BadVersion = Data;
+  BadVersion[8] = 2;
+  EXPECT_THAT_ERROR(Read.read(BadVersion), Failed());
+}
+
+} // end anonymous namespace
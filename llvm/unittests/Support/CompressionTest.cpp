@@ -15,6 +15,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Testing/Support/Error.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -71,6 +72,72 @@ TEST(CompressionTest, ZlibCRC32) {
       zlib::crc32(StringRef("The quick brown fox jumps over the lazy dog")));
 }
 
+TEST(CompressionTest, ZlibChunks) {
+  std::string Input;
+  for (int I = 0; I < 10000; ++I)
+    Input += "chunk " + std::to_string(I % 97) + "\n";
+  const size_t ChunkSize = 4096;
+
+  // Compress the chunks independently and join them into one zlib stream.
+  SmallString<32> Compressed("\x78\x01");
+  uint32_t Checksum = 1;
+  for (size_t Pos = 0; Pos < Input.size(); Pos += ChunkSize) {
+    StringRef Chunk = StringRef(Input).substr(Pos, ChunkSize);
+    EXPECT_THAT_ERROR(zlib::compressChunk(Chunk, Compressed,
+                                          zlib::BestSpeedCompression,
+                                          Pos + ChunkSize >= Input.size()),
+                      Succeeded());
+    Checksum =
+        zlib::adler32Combine(Checksum, zlib::adler32(Chunk), Chunk.size());
+  }
+  EXPECT_EQ(zlib::adler32(Input), Checksum);
+  for (int Shift = 24; Shift >= 0; Shift -= 8)
+    Compressed.push_back(char(Checksum >> Shift));
+
+  SmallString<32> Uncompressed;
+  EXPECT_THAT_ERROR(zlib::uncompress(Compressed, Uncompressed, Input.size()),
+                    Succeeded());
+  EXPECT_EQ(Input, Uncompressed);
+}
+
 #endif
 
+void TestZstdCompression(StringRef Input, int Level) {
+  SmallString<32> Compressed;
+  SmallString<32> Uncompressed;
+  EXPECT_THAT_ERROR(zstd::compress(Input, Compressed, Level), Succeeded());
+  EXPECT_THAT_ERROR(zstd::uncompress(Compressed, Uncompressed, Input.size()),
+                    Succeeded());
+  EXPECT_EQ(Input, Uncompressed);
+  if (Input.size() > 0) {
+    // Uncompression fails if expected length is too short.
+    EXPECT_THAT_ERROR(
+        zstd::uncompress(Compressed, Uncompressed, Input.size() - 1),
+        Failed());
+  }
+}
+
+TEST(CompressionTest, Zstd) {
+  if (!zstd::isAvailable())
+    GTEST_SKIP();
+
+  TestZstdCompression("", zstd::DefaultCompression);
+
+  TestZstdCompression("hello, world!", zstd::NoCompression);
+  TestZstdCompression("hello, world!", zstd::BestSizeCompression);
+  TestZstdCompression("hello, world!", zstd::BestSpeedCompression);
+  TestZstdCompression("hello, world!", zstd::DefaultCompression);
+
+  // Independently compressed frames decompress as their concatenation.
+  SmallString<32> Compressed;
+  SmallString<32> Uncompressed;
+  EXPECT_THAT_ERROR(zstd::compress("hello, ", Compressed), Succeeded());
+  SmallString<32> Second;
+  EXPECT_THAT_ERROR(zstd::compress("world!", Second), Succeeded());
+  Compressed += Second;
+  EXPECT_THAT_ERROR(zstd::uncompress(Compressed, Uncompressed, 13),
+                    Succeeded());
+  EXPECT_EQ("hello, world!", Uncompressed);
+}
+
 }
@@ -14,7 +14,9 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
+#include <vector>
 
 uint32_t array[1024 * 1024];
 
@@ -49,6 +51,16 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, ForEachChunks) {
+  // Every item must be visited exactly once, also when the number of items
+  // does not divide evenly into chunks.
+  std::vector<std::atomic<uint32_t>> counts(3 * 1024 + 7);
+  parallelForEach(counts, [](std::atomic<uint32_t> &c) { ++c; });
+  parallelForEachN(0, counts.size(), [&](size_t i) { ++counts[i]; });
+  for (const std::atomic<uint32_t> &c : counts)
+    ASSERT_EQ(c, 2u);
+}
+
 TEST(Parallel, TransformReduce) {
   // Sum an empty list, check that it works.
   auto identity = [](uint32_t v) { return v; };